@@ -21,541 +21,5526 @@
 
 
 #include <WiFi.h>
-#include <WebServer.h>
 #include <ArduinoJson.h>
+#include <lwip/sockets.h>
+#include <esp_timer.h>
+#include <esp_pm.h>
+#include <esp_vfs_eventfd.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <ESPmDNS.h>
+#include <atomic>
+#include <type_traits>
+
+#include "dashboard_html.h"
+
+// Output backend, chosen at build time (e.g. -DLED_BACKEND=BACKEND_WS2812).
+// The channel store and the engine are the same for every backend; only
+// setupOutputs() and flushOutputs() differ.
+#define BACKEND_LEDC     0  // one ESP32 PWM pin per channel
+#define BACKEND_PCA9685  1  // chain of 16-channel I2C PWM chips
+#define BACKEND_74HC595  2  // chain of shift registers, on/off only
+#define BACKEND_WS2812   3  // addressable strip, one channel per colour byte
+
+#ifndef LED_BACKEND
+#define LED_BACKEND BACKEND_LEDC
+#endif
+
+#if LED_BACKEND == BACKEND_LEDC
+#include <driver/ledc.h>
+#include <hal/ledc_ll.h>
+#include <soc/ledc_struct.h>
+#include <utility>
+#elif LED_BACKEND == BACKEND_PCA9685
+#include <Wire.h>
+#elif LED_BACKEND == BACKEND_74HC595
+#include <SPI.h>
+#endif
+
+// Serial log level, chosen at build time (e.g. -DLOG_LEVEL=LOG_LEVEL_WARN).
+// Messages below it are not compiled in at all.
+#define LOG_LEVEL_DEBUG  0
+#define LOG_LEVEL_INFO   1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_ERROR  3
+#define LOG_LEVEL_NONE   4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
 
 // WiFi credentials
 const char* ssid = "YOUR_WIFI_SSID";
 const char* password = "YOUR_WIFI_PASSWORD";
 
-WebServer server(80);
+// Optional static address; skips DHCP on every (re)connect
+const bool USE_STATIC_IP = false;
+const IPAddress STATIC_IP(192, 168, 1, 50);
+const IPAddress STATIC_GATEWAY(192, 168, 1, 1);
+const IPAddress STATIC_SUBNET(255, 255, 255, 0);
+const IPAddress STATIC_DNS(192, 168, 1, 1);
+
+// WiFi is brought up and kept up by a state machine polled from loop(), so
+// the LEDs never wait for the network. Failed attempts back off
+// exponentially. The AP's BSSID and channel are cached in NVS so the first
+// attempt after boot or a drop can skip the scan.
+enum WiFiState {
+  WIFI_CONNECTING,
+  WIFI_CONNECTED,
+  WIFI_BACKOFF
+};
+
+const unsigned long WIFI_CONNECT_TIMEOUT_MS = 15000;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT_MS = 4000;  // with a cached BSSID
+const unsigned long WIFI_BACKOFF_MIN_MS = 1000;
+const unsigned long WIFI_BACKOFF_MAX_MS = 60000;
+
+struct WiFiCache {
+  uint8_t bssid[6];
+  uint8_t channel;
+};
+
+WiFiState wifiState = WIFI_CONNECTING;
+unsigned long wifiStateTime = 0;
+unsigned long wifiTimeout = 0;      // of the attempt in progress, or the backoff
+int wifiFailures = 0;               // since the last successful connect
+uint32_t wifiConnects = 0;
+WiFiCache wifiCache;
+bool wifiCacheValid = false;
+bool httpReady = false;
+int64_t httpReadyUs = 0;            // esp_timer time the web server started
+
+#if LED_BACKEND == BACKEND_LEDC
+// LED pin definitions, overridable at build time (e.g.
+// -DLED_PIN_LIST=2,4,5,12,13,14,15,16,17,18,19,21,22,23,25,26 for all 16
+// channels). The mapping is fixed at compile time: channel i drives
+// LED_PINS[i] from LEDC channel i % 8 of group i / 8 (group 0 is the
+// high-speed group, 1 the low-speed one), and every channel runs off timer 0
+// of its group. flushOutputs() is generated from it, one direct register
+// write per channel with no lookups.
+#ifndef LED_PIN_LIST
+#define LED_PIN_LIST 2, 4, 5, 18, 19, 21, 22, 23
+#endif
+constexpr int LED_PINS[] = {LED_PIN_LIST};
+constexpr int NUM_LEDS = sizeof(LED_PINS) / sizeof(LED_PINS[0]);
+constexpr int LEDC_GROUP_CHANNELS = 8;
+constexpr int LEDC_GROUPS = (NUM_LEDS + LEDC_GROUP_CHANNELS - 1) / LEDC_GROUP_CHANNELS;
+const ledc_timer_t LEDC_TIMER = LEDC_TIMER_0;
+
+constexpr ledc_mode_t ledcGroup(int ledNum) {
+  return (ledc_mode_t)(ledNum / LEDC_GROUP_CHANNELS);
+}
+
+constexpr ledc_channel_t ledcChannel(int ledNum) {
+  return (ledc_channel_t)(ledNum % LEDC_GROUP_CHANNELS);
+}
+
+// Classic ESP32 pins: 6-11 belong to the flash, 20, 24 and 28-31 don't
+// exist and 34-39 are inputs only
+constexpr bool ledPinsUsable() {
+  for (int i = 0; i < NUM_LEDS; i++) {
+    int pin = LED_PINS[i];
+    if (pin < 0 || pin > 33 || (pin >= 6 && pin <= 11) || pin == 20 || pin == 24 || (pin >= 28 && pin <= 31)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr bool ledPinsDistinct() {
+  for (int i = 0; i < NUM_LEDS; i++) {
+    for (int j = 0; j < i; j++) {
+      if (LED_PINS[i] == LED_PINS[j]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// PWM properties for brightness control
+const int PWM_FREQ = 5000;
+constexpr int PWM_RESOLUTION = 12;
+
+// Duty writes are kept this far clear of the timer overflow that latches
+// them, so one flush never straddles two PWM periods
+const uint32_t LEDC_LATCH_GUARD_US = 5;
+constexpr uint32_t LEDC_LATCH_GUARD_TICKS = (uint64_t)LEDC_LATCH_GUARD_US * PWM_FREQ * (1UL << PWM_RESOLUTION) / 1000000;
+
+static_assert(NUM_LEDS >= 1 && LEDC_GROUPS <= LEDC_SPEED_MODE_MAX, "more channels than LEDC has");
+#if CONFIG_IDF_TARGET_ESP32
+static_assert(ledPinsUsable(), "LED_PINS has a flash, missing or input-only pin");
+#endif
+static_assert(ledPinsDistinct(), "LED_PINS has a pin twice");
+static_assert(ledcGroup(NUM_LEDS - 1) < LEDC_SPEED_MODE_MAX && ledcChannel(NUM_LEDS - 1) < LEDC_CHANNEL_MAX,
+              "channel mapping out of range");
+static_assert(80000000UL / PWM_FREQ >= (1UL << PWM_RESOLUTION), "PWM_FREQ too high for PWM_RESOLUTION");
+static_assert(LEDC_LATCH_GUARD_TICKS < (1UL << PWM_RESOLUTION) / 2, "latch guard longer than half a PWM period");
+#elif LED_BACKEND == BACKEND_PCA9685
+// Chip n answers at PCA9685_BASE_ADDRESS + n and drives channels 16n-16n+15
+const int NUM_LEDS = 512;
+const int PCA9685_SDA_PIN = 21;
+const int PCA9685_SCL_PIN = 22;
+const uint8_t PCA9685_BASE_ADDRESS = 0x40;
+const uint32_t PCA9685_I2C_CLOCK = 1000000;  // Fast-mode Plus
+const int PCA9685_CHIPS = (NUM_LEDS + 15) / 16;
+
+const int PWM_FREQ = 1000;
+constexpr int PWM_RESOLUTION = 12;
+
+static_assert(PCA9685_CHIPS <= 0x70 - PCA9685_BASE_ADDRESS, "PCA9685 chain runs into the all-call address");
+static_assert(PWM_FREQ >= 24 && PWM_FREQ <= 1526, "PCA9685 PWM range is 24-1526 Hz");
+#elif LED_BACKEND == BACKEND_74HC595
+// Channel 0 is Q0 of the first register in the chain. Registers have no
+// PWM, so a channel is lit whenever its duty is non-zero.
+const int NUM_LEDS = 512;
+const int SHIFT_DATA_PIN = 23;   // SPI MOSI
+const int SHIFT_CLOCK_PIN = 18;  // SPI SCK
+const int SHIFT_LATCH_PIN = 5;
+const uint32_t SHIFT_SPI_CLOCK = 10000000;
+const int SHIFT_BYTES = (NUM_LEDS + 7) / 8;
+
+constexpr int PWM_RESOLUTION = 8;
+#elif LED_BACKEND == BACKEND_WS2812
+// Channels map one to one onto strip bytes, so an RGB pixel is three
+// consecutive channels in the strip's own colour order
+const int NUM_LEDS = 510;  // 170 pixels
+const int WS2812_PIN = 13;
+const uint32_t WS2812_RMT_HZ = 10000000;  // 100 ns RMT ticks
+
+constexpr int PWM_RESOLUTION = 8;
+#else
+#error "Unknown LED_BACKEND"
+#endif
+
+constexpr uint32_t PWM_MAX_DUTY = (1UL << PWM_RESOLUTION) - 1;
+
+static_assert(PWM_RESOLUTION >= 8 && PWM_RESOLUTION <= 14, "gamma table supports 8-14 bit PWM");
+
+// Perceptual brightness: levels are 16-bit (0-65535) and mapped to duty
+// through a gamma curve generated at compile time for PWM_RESOLUTION
+constexpr double LED_GAMMA = 2.2;
+
+constexpr double constexprLn(double x) {
+  int exponent = 0;
+  while (x > 2.0) { x /= 2.0; exponent++; }
+  while (x < 0.5) { x *= 2.0; exponent--; }
+  // ln(x) = 2 * atanh((x - 1) / (x + 1))
+  double y = (x - 1.0) / (x + 1.0);
+  double term = y;
+  double sum = 0.0;
+  for (int n = 1; n < 40; n += 2) {
+    sum += term / n;
+    term *= y * y;
+  }
+  return 2.0 * sum + exponent * 0.69314718055994531;
+}
+
+constexpr double constexprExp(double x) {
+  int halvings = 0;
+  while (x > 0.5 || x < -0.5) { x /= 2.0; halvings++; }
+  double term = 1.0;
+  double sum = 1.0;
+  for (int n = 1; n < 20; n++) {
+    term *= x / n;
+    sum += term;
+  }
+  while (halvings-- > 0) sum *= sum;
+  return sum;
+}
+
+// 257 points so a 16-bit level can interpolate between idx and idx + 1
+struct GammaTable {
+  uint16_t duty[257];
+};
+
+constexpr GammaTable makeGammaTable() {
+  GammaTable table = {};
+  for (int i = 1; i <= 256; i++) {
+    double curve = constexprExp(LED_GAMMA * constexprLn(i / 256.0));
+    table.duty[i] = (uint16_t)(curve * PWM_MAX_DUTY + 0.5);
+  }
+  return table;
+}
+
+constexpr GammaTable GAMMA_TABLE = makeGammaTable();
+
+static_assert(GAMMA_TABLE.duty[0] == 0 && GAMMA_TABLE.duty[256] == PWM_MAX_DUTY, "gamma table endpoints");
+
+// Fades run on a fixed tick from the LED engine, in Q16.16 fixed point
+const int64_t FADE_TICK_US = 4000;  // 250 Hz
+const long MAX_FADE_MS = 600000;
+
+// Timed behaviour attached to a channel; at most one per channel
+enum EffectType {
+  EFFECT_NONE,
+  EFFECT_BLINK,   // toggles every blinkInterval ms
+  EFFECT_PULSE,   // on now, off when the deadline passes
+  EFFECT_TIMER    // keeps its state, off when the deadline passes
+};
+
+// Channel store: one array per field, so loops over hundreds of channels
+// (fade ticks, snapshots) only touch the fields they need
+struct ChannelStore {
+  bool isOn[NUM_LEDS];
+  uint8_t brightness[NUM_LEDS];      // 0-255, applied while the LED is on
+  uint8_t effect[NUM_LEDS];          // EffectType
+  bool blinkState[NUM_LEDS];         // current phase while blinking
+  uint32_t blinkInterval[NUM_LEDS];  // ms between toggles, 0 = steady
+  uint32_t level[NUM_LEDS];          // current output level, Q16.16 of 0-65535
+  int32_t fadeStep[NUM_LEDS];        // per fade tick, Q16.16
+  uint32_t fadeTicks[NUM_LEDS];      // fade ticks remaining, 0 = not fading
+};
+
+ChannelStore channels;
+
+// Duty last computed for each channel. Changes widen the dirty range and
+// flushOutputs() sends the range to the backend in one burst.
+uint16_t outputDuty[NUM_LEDS];
+int dirtyLow = NUM_LEDS;
+int dirtyHigh = -1;
+
+// Fixed-size set of channel numbers
+const int CHANNEL_MASK_WORDS = (NUM_LEDS + 31) / 32;
+
+struct ChannelMask {
+  uint32_t words[CHANNEL_MASK_WORDS];
+
+  void set(int i) { words[i >> 5] |= 1UL << (i & 31); }
+  void reset(int i) { words[i >> 5] &= ~(1UL << (i & 31)); }
+  bool test(int i) const { return words[i >> 5] & (1UL << (i & 31)); }
+  void clear() { memset(words, 0, sizeof(words)); }
+
+  void setAll() {
+    memset(words, 0xFF, sizeof(words));
+    if (NUM_LEDS % 32 != 0) {
+      words[CHANNEL_MASK_WORDS - 1] = (1UL << (NUM_LEDS % 32)) - 1;
+    }
+  }
+
+  void merge(const ChannelMask& other) {
+    for (int w = 0; w < CHANNEL_MASK_WORDS; w++) {
+      words[w] |= other.words[w];
+    }
+  }
+
+  int count() const {
+    int n = 0;
+    for (int w = 0; w < CHANNEL_MASK_WORDS; w++) {
+      n += __builtin_popcount(words[w]);
+    }
+    return n;
+  }
+
+  // Lowest channel >= from in the set, or -1
+  int next(int from = 0) const {
+    for (int w = from >> 5; w < CHANNEL_MASK_WORDS; w++) {
+      uint32_t bits = words[w];
+      if (w == from >> 5) {
+        bits &= 0xFFFFFFFFUL << (from & 31);
+      }
+      if (bits != 0) {
+        return w * 32 + __builtin_ctz(bits);
+      }
+    }
+    return -1;
+  }
+};
+
+// Effects scheduler: a min-heap of per-channel deadlines in esp_timer
+// microseconds. The LED engine runs whatever is due and otherwise sleeps
+// until the next deadline or the next command. The heap is kept as
+// parallel arrays, like the channel store, so an entry takes 10 bytes
+// rather than a padded 16.
+static_assert(NUM_LEDS <= INT16_MAX, "effect heap positions are 16-bit");
+
+int64_t effectDue[NUM_LEDS];        // the heap, earliest deadline first
+uint16_t effectLed[NUM_LEDS];       // the channel each deadline is for
+int effectHeapSize = 0;
+int16_t effectHeapIndex[NUM_LEDS];  // position in the heap, -1 when idle
+
+esp_timer_handle_t effectTimer;
+
+// loop() has a single wait: one select() on every socket it serves plus an
+// eventfd that the engine and WiFi events signal, with a timeout of the
+// earliest deadline among its pumps (a request timeout, the next fleet
+// beacon, a settled state to save...). Nothing wakes it on a fixed tick.
+// With LIGHT_SLEEP the CPU clock drops to MIN_CPU_MHZ whenever both tasks
+// wait, and the chip light-sleeps between WiFi beacons if the build has
+// tickless idle. Each task holds a CPU lock while it works, so passes run
+// at full speed and the cycle-count metrics stay in step.
+const bool LIGHT_SLEEP = true;
+const int MIN_CPU_MHZ = 80;  // the APB, which clocks the peripherals, stays at 80 MHz
+
+// What loop() waits on, collected fresh before every wait
+struct LoopWait {
+  fd_set readSet;
+  fd_set writeSet;
+  int maxFd;
+  unsigned long now;  // millis() when collected
+  int64_t waitUs;     // until the earliest deadline, -1 for none
+
+  void watchRead(int fd) {
+    FD_SET(fd, &readSet);
+    maxFd = max(maxFd, fd);
+  }
+
+  void watchWrite(int fd) {
+    FD_SET(fd, &writeSet);
+    maxFd = max(maxFd, fd);
+  }
+
+  void dueIn(int64_t us) {
+    if (us < 0) {
+      us = 0;
+    }
+    if (waitUs < 0 || us < waitUs) {
+      waitUs = us;
+    }
+  }
+
+  // Due periodMs after since, both on millis()
+  void dueAfter(unsigned long since, unsigned long periodMs) {
+    unsigned long elapsed = now - since;
+    dueIn(elapsed >= periodMs ? 0 : (int64_t)(periodMs - elapsed) * 1000);
+  }
+};
+
+enum WakeReason {
+  WAKE_NETWORK,   // a socket became ready
+  WAKE_SIGNAL,    // the engine published a change, or a WiFi event
+  WAKE_DEADLINE,
+  WAKE_REASON_COUNT
+};
+
+const char* const WAKE_REASON_NAMES[WAKE_REASON_COUNT] = {"network", "signal", "deadline"};
+
+int loopWakeFd = -1;
+esp_pm_lock_handle_t loopCpuLock;
+esp_pm_lock_handle_t engineCpuLock;
+bool lightSleepEnabled = false;
+uint32_t loopWakeups[WAKE_REASON_COUNT];
+uint32_t engineWakeups = 0;
+uint64_t loopIdleUs = 0;
+int64_t wakeTime = 0;      // esp_timer time the last network wake ended
+bool wakeAnswered = true;  // its first request has been timed
+
+// LED engine task: applies commands, runs effects and drives the PWM outputs
+// on the second core, so a slow HTTP client never holds up the LEDs
+const BaseType_t ENGINE_CORE = 1;
+const UBaseType_t ENGINE_PRIORITY = 5;
+const uint32_t ENGINE_STACK_SIZE = 4096;
+
+TaskHandle_t engineTaskHandle;
+
+// Logging. LOG_INFO() and friends copy a fixed-size record (time, event,
+// numbers or a short text) into a lock-free ring and return; a low-priority
+// task on the other core formats the records and writes them to Serial. So
+// a control request never waits on the UART and the call never allocates.
+// The task sleeps until a record arrives.
+// Both loop() and the LED engine log, so the ring takes several producers:
+// each slot carries a sequence number saying whose turn it is. A full ring
+// drops the record and counts it. Messages below LOG_LEVEL are compiled out.
+enum LogEvent : uint8_t {
+  LOG_STATE_RESTORED,
+  LOG_WIFI_CONNECTING,
+  LOG_WIFI_CONNECTING_CACHED,
+  LOG_WIFI_CONNECT_FAILED,
+  LOG_WIFI_LOST,
+  LOG_WIFI_CONNECTED,
+  LOG_HTTP_STARTED,
+  LOG_HTTP_URL,
+  LOG_HTTP_LISTEN_FAILED,
+  LOG_HTTP_RESPONSE_TOO_LARGE,
+  LOG_CLIENT_THROTTLED,
+  LOG_SCENE_SAVED,
+  LOG_SCENE_RECALLED,
+  LOG_STREAM_LISTENING,
+  LOG_STREAM_LISTEN_FAILED,
+  LOG_STREAM_STARTED,
+  LOG_STREAM_TIMED_OUT,
+  LOG_BATCH_APPLIED,
+  LOG_ALL_LEDS,
+  LOG_LED_SWITCHED,
+  LOG_LED_SET,
+  LOG_LED_TIMER_EXPIRED,
+  LOG_FLEET_LISTENING,
+  LOG_FLEET_LISTEN_FAILED,
+  LOG_FLEET_CLOCK_STARTED,
+  LOG_FLEET_LEADER,
+  LOG_FLEET_SYNCED,
+  LOG_FLEET_COMMAND_RUN,
+  LOG_FLEET_COMMAND_MISSED,
+  LOG_LIGHT_SLEEP_ENABLED,
+  LOG_LIGHT_SLEEP_UNAVAILABLE,
+  LOG_SHOWS_UNAVAILABLE,
+  LOG_SHOW_STORED,
+  LOG_SHOW_PLAYING,
+  LOG_SHOW_ENDED,
+  LOG_SHOW_READ_FAILED,
+  LOG_EVENT_COUNT
+};
+
+// How a record's arguments feed its format
+enum LogArgs : uint8_t {
+  LOG_NUMBERS,        // up to four, each %ld
+  LOG_TEXT,           // one string
+  LOG_ACTION_FIRST,   // an LEDAction name, then numbers
+  LOG_ACTION_SECOND   // a number, an LEDAction name, then numbers
+};
+
+struct LogFormat {
+  const char* format;
+  LogArgs args;
+};
+
+const LogFormat LOG_FORMATS[LOG_EVENT_COUNT] = {
+  {"LED state restored %ld us after boot", LOG_NUMBERS},
+  {"Connecting to WiFi", LOG_NUMBERS},
+  {"Connecting to WiFi (cached AP)", LOG_NUMBERS},
+  {"WiFi connect failed, retrying in %ld ms", LOG_NUMBERS},
+  {"WiFi connection lost", LOG_NUMBERS},
+  {"WiFi connected! IP address: %ld.%ld.%ld.%ld", LOG_NUMBERS},
+  {"Web server started %ld us after boot", LOG_NUMBERS},
+  {"Open your phone browser and go to: http://%ld.%ld.%ld.%ld", LOG_NUMBERS},
+  {"HTTP listener failed", LOG_NUMBERS},
+  {"HTTP response of %ld bytes too large", LOG_NUMBERS},
+  {"Client %ld.%ld.%ld.%ld throttled", LOG_NUMBERS},
+  {"Scene \"%s\" saved", LOG_TEXT},
+  {"Scene \"%s\" recalled", LOG_TEXT},
+  {"UDP stream listening on port %ld", LOG_NUMBERS},
+  {"UDP stream listener failed", LOG_NUMBERS},
+  {"UDP stream started, priority %ld", LOG_NUMBERS},
+  {"UDP stream timed out", LOG_NUMBERS},
+  {"Batch of %ld ops applied", LOG_NUMBERS},
+  {"All LEDs turned %s", LOG_ACTION_FIRST},
+  {"LED %ld turned %s", LOG_ACTION_SECOND},
+  {"LED %ld %s %ld", LOG_ACTION_SECOND},
+  {"LED %ld timer expired", LOG_NUMBERS},
+  {"Fleet listening on port %ld as node %08lx", LOG_NUMBERS},
+  {"Fleet listener failed", LOG_NUMBERS},
+  {"No synced fleet peers, starting the fleet clock", LOG_NUMBERS},
+  {"Fleet clock leader is node %08lx", LOG_NUMBERS},
+  {"Fleet clock synced to node %08lx, round trip %ld us", LOG_NUMBERS},
+  {"Group command %ld from node %08lx run %ld us late", LOG_NUMBERS},
+  {"Group command %ld from node %08lx missed", LOG_NUMBERS},
+  {"Automatic light sleep enabled, CPU %ld-%ld MHz", LOG_NUMBERS},
+  {"Light sleep not in this build, scaling the CPU clock only", LOG_NUMBERS},
+  {"LittleFS mount failed, shows unavailable", LOG_NUMBERS},
+  {"Show \"%s\" stored", LOG_TEXT},
+  {"Show \"%s\" playing", LOG_TEXT},
+  {"Show \"%s\" ended", LOG_TEXT},
+  {"Show \"%s\" unreadable, stopping", LOG_TEXT},
+};
+
+const int LOG_RING_SIZE = 128;
+const size_t LOG_TEXT_SIZE = 24;
+const size_t LOG_LINE_SIZE = 128;
+const BaseType_t LOG_CORE = 0;
+const UBaseType_t LOG_PRIORITY = 1;
+const uint32_t LOG_STACK_SIZE = 3072;
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "log ring size must be a power of two");
+
+struct LogRecord {
+  uint32_t timeMs;
+  uint8_t level;
+  uint8_t event;  // LogEvent
+  union {
+    int32_t numbers[4];
+    char text[LOG_TEXT_SIZE];
+  };
+};
+
+struct LogSlot {
+  std::atomic<uint32_t> sequence;  // == position: free for the producer there; == position + 1: filled
+  LogRecord record;
+};
+
+static_assert(std::is_trivially_copyable<LogRecord>::value, "log records are copied as plain bytes");
+
+LogSlot logRing[LOG_RING_SIZE];
+std::atomic<uint32_t> logHead(0);  // next position a producer claims
+uint32_t logTail = 0;              // next position the log task reads
+std::atomic<uint32_t> logDropped(0);
+TaskHandle_t logTaskHandle;
+
+// A disabled level still type-checks its calls but generates no code
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logEvent(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { if (false) logEvent(LOG_LEVEL_DEBUG, __VA_ARGS__); } while (0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) logEvent(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { if (false) logEvent(LOG_LEVEL_INFO, __VA_ARGS__); } while (0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) logEvent(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do { if (false) logEvent(LOG_LEVEL_WARN, __VA_ARGS__); } while (0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logEvent(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do { if (false) logEvent(LOG_LEVEL_ERROR, __VA_ARGS__); } while (0)
+#endif
+
+// Per-channel commands accepted by /api/led and /api/batch
+enum LEDAction {
+  ACTION_ON,
+  ACTION_OFF,
+  ACTION_BLINK,
+  ACTION_BRIGHTNESS,
+  ACTION_PULSE,
+  ACTION_TIMER,
+  ACTION_INVALID,
+  ACTION_FRAME,    // engine only: apply the latest stream frame
+  ACTION_SCENE,    // engine only: apply the latest recalled scene
+  ACTION_SHOW      // engine only: show transport, flags = ShowOp, value = generation, fadeMs = position
+};
+
+// /api/batch limits
+const int MAX_BATCH_OPS = 32;
+const size_t BATCH_RESPONSE_SIZE = MAX_BATCH_OPS * 64 + 64;
+
+// Request parsing: the body is parsed in place in the connection's request
+// buffer (ArduinoJson zero-copy mode, strings point into the buffer) into a
+// fixed-size document reused by every request, so parsing a control
+// request never copies the body or touches the heap.
+const size_t MAX_BODY_SIZE = 4096;
+const size_t REQUEST_JSON_CAPACITY = 4096;  // a full batch is about 2.5 KB
+
+StaticJsonDocument<REQUEST_JSON_CAPACITY> requestDoc;
+
+// Commands from the web handlers to the LED engine. loop() is the only
+// producer and the engine the only consumer, so the ring needs no lock.
+const int ALL_LEDS = -1;
+const uint8_t CMD_DEFER = 0x01;  // part of a batch; commit with the last op
+
+struct LEDCommand {
+  uint8_t action;   // LEDAction
+  uint8_t flags;
+  int16_t ledNum;   // or ALL_LEDS
+  int32_t value;
+  uint32_t fadeMs;  // 0 = switch instantly
+};
+
+const uint32_t COMMAND_QUEUE_SIZE = 64;
+
+static_assert((COMMAND_QUEUE_SIZE & (COMMAND_QUEUE_SIZE - 1)) == 0, "queue size must be a power of two");
+static_assert(MAX_BATCH_OPS <= COMMAND_QUEUE_SIZE, "a batch must fit in the command queue");
+
+LEDCommand commandQueue[COMMAND_QUEUE_SIZE];
+std::atomic<uint32_t> commandHead(0);  // next slot the producer fills
+std::atomic<uint32_t> commandTail(0);  // next slot the consumer reads
+
+// Coalescing buffer, loop() only. Single-channel commands wait here until
+// the end of the loop() pass, and a newer command drops any buffered one it
+// makes moot (last writer wins), so a storm of clicks on one channel reaches
+// the engine as one command. Everything else flushes the buffer before it
+// is queued, so the engine still sees commands in order.
+const int COALESCE_SLOTS = 32;
+
+static_assert(COALESCE_SLOTS <= COMMAND_QUEUE_SIZE, "the buffer must fit in the command queue");
+
+LEDCommand coalesced[COALESCE_SLOTS];  // in arrival order
+int coalescedCount = 0;
+uint32_t commandsCoalesced = 0;
+
+// Admission control: a token bucket per client address for the command
+// routes. An empty bucket gets 429 with a Retry-After. A new client takes
+// the slot that has been idle longest. The rate can be set at build time
+// (e.g. -DCLIENT_COMMAND_RATE=1000000 to load-test the server itself).
+const int MAX_RATE_CLIENTS = 8;
+#ifndef CLIENT_COMMAND_RATE
+#define CLIENT_COMMAND_RATE 25  // commands per second
+#endif
+const uint32_t CLIENT_COMMAND_BURST = 50;
+
+struct RateBucket {
+  uint32_t address;          // IPv4, network order; 0 = free
+  uint32_t tokens;           // thousandths of a command
+  unsigned long lastRefill;
+};
+
+RateBucket rateBuckets[MAX_RATE_CLIENTS];
+uint32_t commandsThrottled = 0;
+
+// Engine side of a batch in progress
+ChannelMask pendingOutputs;
+uint32_t pendingFadeMs[NUM_LEDS];
+int pendingOps = 0;
+
+// Engine side fade clock
+int activeFades = 0;
+int64_t nextFadeTick = 0;
+
+// Channel state as published by the engine. The engine writes it under a
+// seqlock and readers copy it out, so neither side ever blocks the other.
+struct LEDStatus {
+  bool isOn;
+  uint8_t brightness;
+  uint8_t effect;
+  uint32_t blinkInterval;
+};
+
+struct LEDSnapshot {
+  uint32_t version;  // /api/status?since=<version> compares against this
+  LEDStatus leds[NUM_LEDS];
+};
+
+LEDSnapshot publishedSnapshot;
+std::atomic<uint32_t> snapshotSeq(0);  // odd while the engine is writing
+bool snapshotDirty = false;
+
+// The web side's copy, refreshed by syncSnapshot()
+LEDSnapshot statusSnapshot;
+uint32_t statusSnapshotSeq = 0;
+
+// Serialized /api/status bodies, rebuilt only when the snapshot version (or
+// the requested page) changes. The JSON form lists up to STATUS_PAGE_SIZE
+// channels per request; ?format=compact packs every channel into a few
+// hex strings, about 3.25 bytes per channel.
+const int STATUS_PAGE_SIZE = NUM_LEDS < 64 ? NUM_LEDS : 64;
+const size_t STATUS_BUFFER_SIZE = STATUS_PAGE_SIZE * 100 + 96;
+const size_t COMPACT_BUFFER_SIZE = (NUM_LEDS + 3) / 4 + NUM_LEDS * 3 + 96;
+
+struct StatusQuery {
+  bool compact;
+  int offset;
+  int count;
+};
+
+char statusCache[STATUS_BUFFER_SIZE];
+size_t statusCacheLength = 0;
+uint32_t statusCacheVersion = 0;
+int statusCacheOffset = 0;
+int statusCacheCount = 0;
+
+char compactCache[COMPACT_BUFFER_SIZE];
+size_t compactCacheLength = 0;
+uint32_t compactCacheVersion = 0;
+
+// Long-poll: /api/status?since=<version>&wait=<ms> is parked here until the
+// state changes or the wait runs out
+const int MAX_LONGPOLL_CLIENTS = 4;
+const unsigned long LONGPOLL_MAX_MS = 30000;
+
+struct LongPollClient {
+  int conn;  // parked server connection
+  bool active;
+  StatusQuery query;
+  uint32_t since;
+  unsigned long startTime;
+  unsigned long timeout;
+};
+
+LongPollClient longPollClients[MAX_LONGPOLL_CLIENTS];
+
+// Server-Sent Events: browsers subscribed to /api/events get a snapshot on
+// connect and then one event per changed channel. Each client has a fixed
+// send buffer; changes that arrive while it is busy are coalesced into a
+// channel set instead of queueing more bytes. Snapshots use the compact
+// status encoding so they fit the buffer at any channel count.
+const int MAX_EVENT_CLIENTS = 4;
+const size_t EVENT_BUFFER_SIZE = COMPACT_BUFFER_SIZE + 128;
+const unsigned long EVENT_KEEPALIVE_MS = 15000;
+const unsigned long EVENT_STALL_TIMEOUT_MS = 5000;
+
+static_assert(COMPACT_BUFFER_SIZE + 32 <= EVENT_BUFFER_SIZE, "snapshot must fit in the event buffer");
+
+struct EventClient {
+  int conn;                     // server connection handed over by stream()
+  bool active;
+  bool needsSnapshot;
+  ChannelMask pendingLEDs;      // channels changed since the last queued event
+  char buffer[EVENT_BUFFER_SIZE];
+  size_t length;                // bytes of the queued event
+  size_t sent;                  // bytes of it already accepted by the socket
+  unsigned long lastWriteTime;
+};
+
+EventClient eventClients[MAX_EVENT_CLIENTS];
+
+// Frames: a level for each of a range of channels, applied by the engine in
+// one pass. UDP streams and scene recalls both arrive this way.
+struct LEDFrame {
+  uint16_t first;
+  uint16_t count;
+  uint32_t fadeMs;  // 0 = switch instantly
+  uint8_t levels[NUM_LEDS];  // 0 = off (brightness kept), else on at that brightness
+};
+
+// Triple buffer between loop() and the engine. loop() fills its own slot and
+// swaps it in as the latest; the engine swaps the latest out for its own.
+// A frame the engine hasn't picked up yet is replaced, never queued. The
+// stream and scene recalls have one each, so a stream frame can't take the
+// place of a recall the engine hasn't applied yet.
+const uint8_t FRAME_FRESH = 0x04;
+
+struct FrameExchange {
+  LEDFrame frames[3];
+  std::atomic<uint8_t> latest{2};
+  uint8_t writeSlot = 0;  // loop() only
+  uint8_t readSlot = 1;   // engine only
+};
+
+FrameExchange streamFrames;
+FrameExchange sceneFrames;
+
+// UDP streaming: binary frames of channel levels for shows driven from a PC
+// or lighting desk at frame rate, with no HTTP or JSON in the path. Frame
+// layout, multi-byte fields big-endian:
+//   0   "LEDF"  magic
+//   4   u8      protocol version (STREAM_VERSION)
+//   5   u8      priority 0-200; the web API counts as STREAM_WEB_PRIORITY
+//   6   u16     sequence number
+//   8   u16     first channel
+//   10  u16     channel count
+//   12  u8[]    one level per channel, 0 = off
+// A stream above the web priority locks the web API out of its channels; one
+// below it yields while the web API is in use. At equal priority the last
+// writer wins. A source is forgotten after STREAM_TIMEOUT_MS of silence.
+const uint16_t STREAM_PORT = 5570;
+const size_t STREAM_HEADER_SIZE = 12;
+const uint8_t STREAM_VERSION = 1;
+const uint8_t STREAM_MAX_PRIORITY = 200;
+const uint8_t STREAM_WEB_PRIORITY = 100;
+const unsigned long STREAM_TIMEOUT_MS = 2500;
+const int STREAM_SEQUENCE_WINDOW = 20;  // further back means the sender restarted
+
+// Receiver state, loop() only
+int streamSocket = -1;
+uint8_t streamPacket[STREAM_HEADER_SIZE + NUM_LEDS + 1];  // +1 detects oversized frames
+bool streamActive = false;
+uint8_t streamPriority = 0;
+uint16_t streamSequence = 0;
+uint16_t streamFirst = 0;
+uint16_t streamCount = 0;
+unsigned long streamLastFrameTime = 0;
+unsigned long lastWebCommandTime = 0;
+bool webCommandSeen = false;
+uint32_t streamFramesApplied = 0;
+uint32_t streamFramesDropped = 0;
+
+// Fleet: controllers on the same LAN find each other and share a clock, so
+// a group command reaches every node's outputs at the same moment instead of
+// staggering over one HTTP round trip per node. Fleet traffic is UDP
+// multicast to FLEET_MULTICAST_ADDRESS; packets, multi-byte fields
+// big-endian:
+//   0   "LEDN"  magic
+//   4   u8      protocol version (FLEET_VERSION)
+//   5   u8      type (FleetPacketType)
+//   6   u32     sender node id
+//   10  u32     addressee node id, 0 = everyone
+//   14          payload, by type:
+//     beacon      u8 synced, char[16] group
+//     sync        i64 t1, the requester's esp_timer time
+//     sync reply  i64 t1 echoed, i64 t2, the replier's fleet clock
+//     command     u16 id, u8 action, u32 fade ms, i64 due (fleet clock), char[16] group
+// The fleet clock is the leader's, the lowest node id among synced nodes.
+// The others sample it NTP-style and use the offset from the exchange with
+// the shortest round trip among the last FLEET_SYNC_SAMPLES. A node that
+// hears no synced peer within FLEET_JOIN_MS of starting starts the clock
+// itself, so a fleet powered up together settles on one clock, and a node
+// joining later takes on the running clock before it can lead. A node that
+// gets a new leader is unsynced until it has sampled the leader's clock:
+// two parts of a fleet that started their clocks apart don't share one.
+const uint16_t FLEET_PORT = 5571;
+const uint32_t FLEET_MULTICAST_ADDRESS = 0xEFFF4C44;  // 239.255.76.68
+const char FLEET_GROUP[] = "default";                  // this node's group
+const uint8_t FLEET_VERSION = 1;
+const size_t FLEET_HEADER_SIZE = 14;
+const size_t FLEET_GROUP_SIZE = 16;                    // with the NUL
+const size_t FLEET_PACKET_SIZE = 64;
+const int MAX_FLEET_PEERS = 32;
+const int FLEET_SYNC_SAMPLES = 8;
+const int MAX_FLEET_SCHEDULED = 4;
+const int FLEET_RECENT_COMMANDS = 8;
+const unsigned long FLEET_BEACON_MS = 1000;
+const unsigned long FLEET_PEER_TIMEOUT_MS = 3500;
+const unsigned long FLEET_JOIN_MS = 3000;
+const unsigned long FLEET_SYNC_MS = 1000;
+const unsigned long FLEET_FAST_SYNC_MS = 100;         // until the sample window is full
+const int64_t FLEET_MAX_ROUND_TRIP_US = 200000;
+const int64_t FLEET_COMMAND_LEAD_US = 100000;         // from the request to the group's commit
+const int FLEET_COMMAND_COPIES = 3;                    // multicast isn't acknowledged
+
+static_assert(sizeof(FLEET_GROUP) <= FLEET_GROUP_SIZE, "FLEET_GROUP too long");
+
+enum FleetPacketType : uint8_t {
+  FLEET_BEACON = 1,
+  FLEET_SYNC,
+  FLEET_SYNC_REPLY,
+  FLEET_COMMAND
+};
+
+struct FleetPeer {
+  uint32_t node;              // 0 = free slot
+  uint32_t address;           // IPv4, network order
+  bool synced;
+  char group[FLEET_GROUP_SIZE];
+  unsigned long lastSeen;
+};
+
+struct FleetSample {
+  int64_t offset;             // leader's fleet clock minus our esp_timer
+  int64_t roundTrip;
+};
+
+struct FleetScheduled {
+  bool active;
+  uint32_t origin;            // node the request came in on
+  uint16_t id;
+  uint8_t action;             // ACTION_ON or ACTION_OFF
+  uint32_t fadeMs;
+  int64_t due;                // fleet clock
+};
+
+// Fleet state, loop() only
+int fleetSocket = -1;
+uint32_t fleetNode = 0;
+uint32_t fleetLeader = 0;     // 0 until some node is synced
+bool fleetSynced = false;
+int64_t fleetOffsetUs = 0;    // fleet clock minus esp_timer
+int64_t fleetRoundTripUs = 0;
+FleetSample fleetSamples[FLEET_SYNC_SAMPLES];
+int fleetSampleCount = 0;
+int fleetSampleNext = 0;
+FleetPeer fleetPeers[MAX_FLEET_PEERS];
+FleetScheduled fleetScheduled[MAX_FLEET_SCHEDULED];
+uint32_t fleetRecent[FLEET_RECENT_COMMANDS][2];  // origin and id of commands seen
+int fleetRecentNext = 0;
+uint16_t fleetNextCommandId = 0;
+unsigned long fleetStartTime = 0;
+unsigned long fleetLastBeacon = 0;
+unsigned long fleetLastSync = 0;
+uint8_t fleetPacket[FLEET_PACKET_SIZE];
+uint32_t fleetCommandsRun = 0;
+uint32_t fleetCommandsMissed = 0;
+
+// The last group command run here, for measuring skew across the fleet
+bool fleetLastValid = false;
+uint32_t fleetLastOrigin = 0;
+uint16_t fleetLastId = 0;
+int64_t fleetLastDue = 0;
+int64_t fleetLastLateUs = 0;
+
+// Scenes: named looks stored as precomputed frames, so a recall is a single
+// frame for the engine however many channels it sets. Owned by loop().
+const int MAX_SCENES = 16;
+const size_t MAX_SCENE_NAME = 23;
+
+struct Scene {
+  char name[MAX_SCENE_NAME + 1];  // empty = free slot
+  uint8_t levels[NUM_LEDS];
+};
+
+Scene scenes[MAX_SCENES];
+
+// Shows: timed cue lists. Cues are uploaded as JSON a few dozen at a time
+// and compiled as they arrive into keyframes, each taking a run of channels
+// to a level over a fade, stored in time order on LittleFS as
+//   ShowHeader, ShowKeyframe[keyframes]
+// Playback streams the file through two small blocks: loop() reads the next
+// block from flash while the engine applies the other one's keyframes as
+// they fall due, each starting a fade that the fade engine then steps. RAM
+// use is the same however long the show. A seek replays the keyframes
+// before the new position to work out the look there, a few hundred per
+// loop() pass so a long show doesn't hold up the web server, sets that, and
+// carries on from the file.
+const char* const SHOW_DIRECTORY = "/shows";
+const uint32_t SHOW_MAGIC = 0x53484F31;         // "SHO1", bump when the layout changes
+const size_t MAX_SHOW_NAME = 23;
+const uint32_t MAX_SHOW_MS = 24UL * 3600 * 1000;
+const uint32_t MIN_LOOP_SHOW_MS = 100;          // shorter shows can't loop
+const int SHOW_BLOCK_KEYFRAMES = 64;
+const int SHOW_READ_CHUNK = 16;                 // keyframes per read while seeking
+const int SHOW_REPLAY_STEP = 256;               // keyframes replayed per loop() pass
+const int MAX_LISTED_SHOWS = 32;
+
+struct ShowHeader {
+  uint32_t magic;
+  uint16_t channels;   // NUM_LEDS it was compiled for
+  uint16_t reserved;
+  uint32_t keyframes;
+  uint32_t durationMs;
+};
+
+struct ShowKeyframe {
+  uint32_t timeMs;     // from the start of the show
+  uint16_t first;
+  uint16_t count;
+  uint32_t fadeMs : 24;
+  uint32_t level : 8;  // 0 = off, brightness kept
+};
+
+static_assert(sizeof(ShowKeyframe) == 12, "keyframes are stored as laid out in memory");
+static_assert(MAX_FADE_MS < (1L << 24), "fades must fit in a keyframe");
+
+// Filled by loop() and emptied by the engine; full says whose turn it is
+struct ShowBlock {
+  ShowKeyframe keyframes[SHOW_BLOCK_KEYFRAMES];
+  uint16_t count;
+  bool last;             // the show ends with this block...
+  uint32_t endMs;        // ...at this time
+  uint32_t generation;   // the play or seek it was read for
+  int64_t baseMs;        // added to the keyframe times, a show length per loop
+  std::atomic<bool> full;
+};
+
+enum ShowOp : uint8_t {
+  SHOW_START,
+  SHOW_PAUSE,
+  SHOW_STOP
+};
+
+ShowBlock showBlocks[2];
+std::atomic<uint32_t> showEndedGeneration(0);
+
+// Engine side
+uint32_t showGeneration = 0;   // playing, 0 for none
+int64_t showStartUs = 0;       // esp_timer time of position 0
+int64_t showNextDue = -1;      // the next keyframe, -1 when none is in hand
+uint8_t showReadBlock = 0;
+uint16_t showReadNext = 0;
+uint32_t showUnderruns = 0;
+
+// loop() side
+enum PlaybackState {
+  PLAYBACK_STOPPED,
+  PLAYBACK_PLAYING,
+  PLAYBACK_PAUSED,
+  PLAYBACK_SEEKING   // replaying up to playbackSeekAt, the engine stopped
+};
+
+const char* const PLAYBACK_STATE_NAMES[] = {"stopped", "playing", "paused", "seeking"};
+
+PlaybackState playbackState = PLAYBACK_STOPPED;
+char playbackName[MAX_SHOW_NAME + 1];
+File playbackFile;
+ShowHeader playbackHeader;
+bool playbackLoop = false;
+uint32_t playbackGeneration = 0;
+int64_t playbackStartUs = 0;
+uint32_t playbackPausedMs = 0;
+uint32_t playbackSeekAt = 0;
+uint32_t playbackNextKeyframe = 0;  // in the file
+int64_t playbackBaseMs = 0;
+uint8_t playbackWriteBlock = 0;
+bool playbackReadDone = false;
+int playbackPreamble = 0;           // seek preamble phase, see fillShowPreamble()
+int playbackPreambleChannel = 0;
+uint32_t playbackPreambleAt = 0;
+
+// Each channel's last ramp before the seek position
+struct SeekRamp {
+  uint32_t startMs;
+  uint32_t fadeMs;
+  uint8_t from;
+  uint8_t to;
+};
+
+SeekRamp seekRamps[NUM_LEDS];
+ChannelMask seekTouched;
+
+// Upload in progress
+bool showsReady = false;            // LittleFS mounted
+File uploadFile;
+char uploadName[MAX_SHOW_NAME + 1];
+uint32_t uploadKeyframes = 0;
+uint32_t uploadLastMs = 0;
+uint32_t uploadEndMs = 0;
+
+// Persistence to NVS. Channel state and scenes are written from loop()
+// once changes have settled, so a burst of commands (or a UDP stream) costs
+// one flash write when it stops rather than one per change. Flash writes
+// stall both cores for a few ms, which is another reason to batch them.
+const char* const PERSIST_NAMESPACE = "led";
+const uint32_t PERSIST_MAGIC = 0x4C454431;        // "LED1", bump when the layout changes
+const unsigned long PERSIST_QUIET_MS = 2000;       // no changes for this long
+const unsigned long PERSIST_MIN_INTERVAL_MS = 10000;  // between state writes
+
+struct SavedState {
+  uint32_t magic;
+  uint16_t count;
+  uint8_t isOn[(NUM_LEDS + 7) / 8];
+  uint8_t brightness[NUM_LEDS];
+};
+
+static_assert(MAX_SCENES <= 32, "dirtyScenes is a 32-bit mask");
+
+Preferences preferences;
+uint32_t persistedVersion = 0;
+unsigned long stateChangeTime = 0;
+unsigned long lastPersistTime = 0;
+uint32_t dirtyScenes = 0;
+int64_t bootRestoreUs = 0;  // esp_timer time when the saved state was back on the outputs
+
+// Runtime metrics, served by /api/metrics. Durations are measured in CPU
+// cycles (one register read) and binned into power-of-two microsecond
+// buckets, so recording costs a few dozen cycles and never allocates.
+// The engine histogram is written on the engine task and read here
+// without a lock; a scrape may see it mid-update, which is harmless.
+const int LATENCY_BUCKETS = 18;  // <= 16 us, <= 32 us, ... <= 1.05 s, +Inf
+
+struct LatencyHistogram {
+  uint32_t buckets[LATENCY_BUCKETS];
+  uint32_t count;
+  uint64_t sumUs;
+  uint32_t maxUs;
+};
+
+enum Route {
+  ROUTE_ROOT,
+  ROUTE_STATUS,
+  ROUTE_LED,
+  ROUTE_ALL,
+  ROUTE_BATCH,
+  ROUTE_EVENTS,
+  ROUTE_SCENES,
+  ROUTE_METRICS,
+  ROUTE_FLEET,
+  ROUTE_SHOWS,
+  ROUTE_PLAYBACK,
+  ROUTE_NOT_FOUND,
+  ROUTE_COUNT
+};
+
+const char* const ROUTE_NAMES[ROUTE_COUNT] = {
+  "/", "/api/status", "/api/led", "/api/all", "/api/batch", "/api/events", "/api/scenes", "/api/metrics",
+  "/api/fleet", "/api/shows", "/api/playback", "not_found"
+};
+
+// Status codes counted per route; anything else lands in "other"
+const int METRIC_STATUS_CODES[] = {200, 304, 400, 404, 409, 413, 429, 503, 507};
+const int METRIC_STATUS_COUNT = sizeof(METRIC_STATUS_CODES) / sizeof(METRIC_STATUS_CODES[0]);
+
+LatencyHistogram loopLatency;
+LatencyHistogram engineLatency;
+LatencyHistogram wakeLatency;
+LatencyHistogram showLateness;  // keyframes, written on the engine task
+LatencyHistogram routeLatency[ROUTE_COUNT];
+uint32_t routeStatusCounts[ROUTE_COUNT][METRIC_STATUS_COUNT + 1];
+uint32_t cyclesPerMicrosecond = 240;
+
+// HTTP server. Connections are non-blocking sockets polled from loop(), so
+// several browsers and scripts are served at once and a slow client only
+// holds up itself. HTTP/1.1 keep-alive and pipelining are supported; request
+// bodies need a Content-Length. Each connection has a fixed request buffer;
+// response buffers come from a smaller pool and are only held while a
+// response is built and sent, so idle keep-alives, long-polls and event
+// streams don't tie one up. Memory stays bounded however many clients turn
+// up. Long-polls and event streams keep their connection (and a slot here)
+// while they wait.
+const uint16_t HTTP_PORT = 80;
+const int MAX_HTTP_CONNECTIONS = 8;
+const int HTTP_RESPONSE_BUFFERS = 3;  // requests wait for one when all are busy
+const int MAX_HTTP_ROUTES = 16;
+const int MAX_HTTP_ARGS = 8;
+const int MAX_HTTP_HEADERS = 16;
+const size_t HTTP_HEADER_SIZE = 1024;  // request line and headers
+const size_t HTTP_REQUEST_BUFFER_SIZE = HTTP_HEADER_SIZE + MAX_BODY_SIZE;
+const size_t HTTP_RESPONSE_HEAD_SIZE = 512;
+const size_t HTTP_MAX_CONTENT = STATUS_BUFFER_SIZE > COMPACT_BUFFER_SIZE ?
+    (STATUS_BUFFER_SIZE > BATCH_RESPONSE_SIZE ? STATUS_BUFFER_SIZE : BATCH_RESPONSE_SIZE) :
+    (COMPACT_BUFFER_SIZE > BATCH_RESPONSE_SIZE ? COMPACT_BUFFER_SIZE : BATCH_RESPONSE_SIZE);
+const size_t HTTP_RESPONSE_BUFFER_SIZE = HTTP_RESPONSE_HEAD_SIZE + HTTP_MAX_CONTENT;
+const size_t HTTP_CHUNK_RESERVE = 7;  // "\r\n" closing a chunk and "0\r\n\r\n" ending the body
+static_assert(HTTP_RESPONSE_BUFFER_SIZE <= 0xffff, "a chunk's size line has room for 4 hex digits");
+const unsigned long HTTP_IDLE_TIMEOUT_MS = 15000;    // keep-alive with no request
+const unsigned long HTTP_REQUEST_TIMEOUT_MS = 5000;  // from the first byte to the whole request
+const unsigned long HTTP_SEND_TIMEOUT_MS = 5000;     // client not taking the response
+
+enum HttpMethod {
+  METHOD_GET,
+  METHOD_POST,
+  METHOD_OPTIONS,
+  METHOD_OTHER
+};
+
+enum HttpConnectionState {
+  HTTP_FREE,
+  HTTP_READING,    // waiting for (the rest of) a request
+  HTTP_WRITING,    // sending a response
+  HTTP_PARKED,     // long-poll, answered later with respond()
+  HTTP_STREAMING   // handed over to an event stream
+};
+
+// Adds the next piece of a chunked response with server.print() and returns
+// false after the last one. cursor starts at 0 and is the writer's to use.
+typedef bool (*HttpChunkWriter)(uint32_t& cursor);
+
+struct HttpPair {
+  const char* name;
+  const char* value;
+};
+
+struct HttpConnection {
+  int fd;
+  uint32_t peer;                // client IPv4 address, network order
+  HttpConnectionState state;
+  unsigned long stateTime;      // last progress: new state, or bytes in or out
+  bool http11;
+  bool keepAlive;
+  bool chunked;
+  bool pipelined;               // request bytes arrived with the last one and aren't parsed yet
+  bool waitingForBuffer;        // a whole request is in, but every response buffer is busy
+
+  // Request; the parsed fields point into request[]
+  char request[HTTP_REQUEST_BUFFER_SIZE + 1];
+  size_t received;
+  size_t headerLength;          // 0 until the head has arrived and been parsed
+  size_t contentLength;
+  HttpMethod method;
+  const char* path;
+  HttpPair args[MAX_HTTP_ARGS];
+  int argCount;
+  HttpPair headers[MAX_HTTP_HEADERS];
+  int headerCount;
+
+  // Response: response[] first, then body (sent from where it lies), then
+  // whatever writer produces. response is from the server's pool, and null
+  // when the connection has no response under way.
+  char* response;
+  size_t responseLength;
+  size_t sent;
+  const char* body;
+  size_t bodyLength;
+  size_t bodySent;
+  HttpChunkWriter writer;
+  uint32_t writerCursor;
+};
+
+struct HttpRoute {
+  const char* path;
+  HttpMethod method;
+  void (*handler)();
+};
+
+class HttpServer {
+ public:
+  int lastStatus = 0;  // code of the last response started, for the metrics
+
+  void on(const char* path, HttpMethod method, void (*handler)());
+  void onNotFound(void (*handler)()) { notFoundHandler = handler; }
+  bool begin(uint16_t port);
+  void handleClient();
+  void addWait(LoopWait& wait) const;
+
+  // The request being handled
+  bool hasArg(const char* name) const;
+  const char* arg(const char* name) const;     // "" if absent
+  const char* header(const char* name) const;  // "" if absent
+  char* body() const { return current->request + current->headerLength; }
+  size_t bodyLength() const { return current->contentLength; }
+  uint32_t clientAddress() const { return current->peer; }
+
+  // Its response. send() copies the content; sendStatic() sends it from
+  // where it is, so it must stay put (flash) until the response is done.
+  void sendHeader(const char* name, const char* value);
+  void send(int code, const char* type = nullptr, const char* content = nullptr);
+  void send(int code, const char* type, const char* content, size_t length);
+  void sendStatic(int code, const char* type, const char* content, size_t length);
+  void sendChunked(int code, const char* type, HttpChunkWriter writer);
+  bool print(const char* format, ...);
+
+  // Connections that outlive their handler. park() holds the request for a
+  // later respond(); stream() hands the socket over until close().
+  int park();
+  int stream();
+  int fd(int conn) const { return connections[conn].fd; }
+  bool peerClosed(int conn) const;
+  bool canRespond() const { return responseBuffersFree != 0; }
+  bool respond(int conn, int code, const char* type, const char* content, size_t length);
+  void close(int conn) { closeConnection(connections[conn]); }
+
+ private:
+  HttpConnection connections[MAX_HTTP_CONNECTIONS];
+  char responseBuffers[HTTP_RESPONSE_BUFFERS][HTTP_RESPONSE_BUFFER_SIZE];
+  uint8_t responseBuffersFree = (1 << HTTP_RESPONSE_BUFFERS) - 1;
+  HttpRoute routes[MAX_HTTP_ROUTES];
+  int routeCount = 0;
+  void (*notFoundHandler)() = nullptr;
+  int listenFd = -1;
+
+  HttpConnection* current = nullptr;  // whose request is being handled
+  char extraHeaders[256];             // from sendHeader(), for its response
+  size_t extraHeadersLength = 0;
+
+  bool takeResponseBuffer(HttpConnection& c);
+  void releaseResponseBuffer(HttpConnection& c);
+  void acceptConnections(unsigned long now);
+  void readRequest(HttpConnection& c, unsigned long now);
+  bool parseHead(HttpConnection& c, char* end);
+  void dispatch(HttpConnection& c);
+  void startResponse(HttpConnection& c, int code, const char* type, long length);
+  void fillChunk(HttpConnection& c);
+  void writeResponse(HttpConnection& c, unsigned long now);
+  void finishResponse(HttpConnection& c, unsigned long now);
+  void reject(HttpConnection& c, int code, const char* message);
+  void closeConnection(HttpConnection& c);
+};
+
+HttpServer server;
+
+void setupWebServer();
+void urlDecode(char* text);
+const char* httpStatusText(int code);
+void handleRoot();
+void handleGetStatus();
+void handleLEDControl();
+void handleAllLEDs();
+void handleBatch();
+bool parseRequestBody();
+bool admitCommand();
+void handleEvents();
+void pumpEvents();
+void addEventWait(LoopWait& wait);
+void pumpLongPolls();
+void addLongPollWait(LoopWait& wait);
+int formatLEDJson(char* buffer, size_t size, int ledNum);
+bool parseStatusQuery(StatusQuery& query);
+const char* statusBody(const StatusQuery& query, size_t& length);
+void refreshStatusCache(int offset, int count);
+void refreshCompactCache();
+void syncSnapshot();
+void setupLoopWait();
+void waitForNextEvent();
+void wakeLoop();
+void setupStream();
+void pumpStream();
+bool acceptStreamFrame(const uint8_t* packet, size_t length);
+bool streamHolds(int ledNum);
+int64_t fleetTime();
+uint64_t readBigEndian(const uint8_t* p, int bytes);
+void writeBigEndian(uint8_t* p, uint64_t value, int bytes);
+void setupFleet();
+void sendFleetPacket(FleetPacketType type, uint32_t to, size_t length);
+void pumpFleet();
+void addFleetWait(LoopWait& wait);
+void handleFleetPacket(size_t length, uint32_t address, unsigned long now);
+FleetPeer* findFleetPeer(uint32_t node, unsigned long now);
+void electFleetLeader();
+void addFleetSample(int64_t offset, int64_t roundTrip);
+bool fleetGroupValid(const char* group);
+bool fleetGroupMatches(const char* group);
+void sendFleetCommand(LEDAction action, unsigned long fadeMs, const char* group, uint16_t& id, int64_t& due);
+void scheduleFleetCommand(uint32_t origin, uint16_t id, uint8_t action, uint32_t fadeMs, int64_t due);
+void runFleetSchedule();
+void handleFleet();
+LEDFrame& nextFrame(FrameExchange& exchange);
+void publishFrame(FrameExchange& exchange);
+void handleGetScenes();
+void handleSceneControl();
+int findScene(const char* name);
+bool showNameValid(const char* name);
+void showPath(char* path, size_t size, const char* name, const char* extension);
+void handleGetShows();
+void handleShowControl();
+const char* validateCue(JsonVariant cue, uint32_t lastMs);
+bool writeCue(JsonVariant cue);
+bool writeKeyframe(uint32_t timeMs, int first, int count, uint8_t level, uint32_t fadeMs);
+void handleGetPlayback();
+void handlePlaybackControl();
+uint32_t playbackPosition();
+bool startPlayback(uint32_t at);
+void stopPlayback();
+bool replayShow();
+uint8_t seekLevelAt(int ledNum, uint32_t t);
+bool preambleKeyframe(int ledNum, uint8_t& level, uint32_t& fadeMs);
+void fillShowPreamble(ShowBlock& block);
+void pumpShow();
+bool queueShowCommand(ShowOp op, uint32_t generation, uint32_t positionMs);
+void restoreState();
+void loadScenes();
+void pumpPersistence();
+void addPersistenceWait(LoopWait& wait);
+void beginWiFiAttempt(unsigned long now);
+void pumpWiFi();
+void addWiFiWait(LoopWait& wait);
+void onWiFiEvent(arduino_event_id_t event);
+void onWiFiConnected(unsigned long now);
+void handleMetrics();
+void handleNotFound();
+void timeRoute(Route route, void (*handler)());
+void countRouteStatus(Route route, int code);
+void recordLatency(LatencyHistogram& histogram, uint32_t startCycles);
+void recordMicros(LatencyHistogram& histogram, uint32_t us);
+LEDAction parseLEDAction(const char* name);
+const char* validateLEDCommand(int ledNum, LEDAction action, long value, long fadeMs);
+bool queueLEDCommand(LEDAction action, int ledNum, long value, unsigned long fadeMs, uint8_t flags);
+bool postLEDCommand(LEDAction action, int ledNum, long value, unsigned long fadeMs = 0);
+bool supersedes(const LEDCommand& newer, const LEDCommand& older);
+bool flushCommands();
+bool pushCommand(const LEDCommand& cmd);
+bool popCommand(LEDCommand& cmd);
+uint32_t commandQueueSpace();
+void wakeLEDEngine();
+bool turnOnLED(int ledNum, unsigned long fadeMs = 0);
+bool turnOffLED(int ledNum, unsigned long fadeMs = 0);
+bool blinkLED(int ledNum, unsigned long interval);
+bool setLEDBrightness(int ledNum, int brightness, unsigned long fadeMs = 0);
+bool pulseLED(int ledNum, unsigned long duration);
+bool setLEDTimer(int ledNum, unsigned long delayMs);
+bool turnOnAllLEDs(unsigned long fadeMs = 0);
+bool turnOffAllLEDs(unsigned long fadeMs = 0);
+
+// LED engine task
+void ledEngineTask(void* param);
+void runEngine();
+void executeCommand(const LEDCommand& cmd);
+void logCommand(const LEDCommand& cmd, int ops);
+void publishSnapshot();
+void applyLEDState(int ledNum, LEDAction action, long value);
+void applyFrame(FrameExchange& exchange);
+void setChannelLevel(int ledNum, uint8_t level, uint32_t fadeMs);
+void executeShowCommand(const LEDCommand& cmd);
+void runShow();
+void holdFade(int ledNum);
+void stopFade(int ledNum);
+void notifyLEDChange(int ledNum);
+void writeLEDOutput(int ledNum);
+uint16_t targetLevel(int ledNum);
+void setOutputDuty(int ledNum, uint32_t duty);
+void setupOutputs();
+void flushOutputs();
+void startFade(int ledNum, uint32_t fadeMs);
+void runFades();
+uint32_t gammaDuty(uint16_t level);
+void runEffects();
+void waitForEngineEvent();
+void setupLogging();
+LogRecord* claimLogRecord(uint8_t level, LogEvent event, uint32_t& position);
+void logEvent(uint8_t level, LogEvent event, int32_t a = 0, int32_t b = 0, int32_t c = 0, int32_t d = 0);
+void logEvent(uint8_t level, LogEvent event, const char* text);
+bool popLogRecord(LogRecord& record);
+int formatLogRecord(char* line, size_t size, const LogRecord& record);
+void logTask(void*);
+void scheduleEffect(int ledNum, int64_t due);
+void cancelEffect(int ledNum);
+
+void setup() {
+  Serial.begin(115200);
+  setupLogging();
+  cyclesPerMicrosecond = getCpuFrequencyMhz();
+  
+  
+  for (int i = 0; i < NUM_LEDS; i++) {
+    // Initialize LED states
+    channels.isOn[i] = false;
+    channels.brightness[i] = 255;
+    channels.blinkInterval[i] = 0;
+    channels.blinkState[i] = false;
+    channels.effect[i] = EFFECT_NONE;
+    channels.level[i] = 0;
+    channels.fadeTicks[i] = 0;
+    outputDuty[i] = 0;
+    effectHeapIndex[i] = -1;
+  }
+  
+  // Bring back the state from before power was lost (all off if none),
+  // before anything slow like WiFi
+  preferences.begin(PERSIST_NAMESPACE);
+  restoreState();
+  setupOutputs();
+  dirtyLow = 0;
+  dirtyHigh = NUM_LEDS - 1;
+  flushOutputs();
+  bootRestoreUs = esp_timer_get_time();
+  LOG_INFO(LOG_STATE_RESTORED, (int32_t)bootRestoreUs);
+  loadScenes();
+  
+  // Shows live on LittleFS, formatted on first use
+  showsReady = LittleFS.begin(true);
+  if (showsReady) {
+    LittleFS.mkdir(SHOW_DIRECTORY);
+  } else {
+    LOG_ERROR(LOG_SHOWS_UNAVAILABLE);
+  }
+  
+  publishSnapshot();
+  persistedVersion = publishedSnapshot.version;
+  
+  // Start the LED engine before WiFi; effect deadlines wake it via esp_timer
+  setupLoopWait();
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = [](void*) { xTaskNotifyGive(engineTaskHandle); };
+  timerArgs.name = "effects";
+  esp_timer_create(&timerArgs, &effectTimer);
+  xTaskCreatePinnedToCore(ledEngineTask, "led-engine", ENGINE_STACK_SIZE, nullptr,
+                          ENGINE_PRIORITY, &engineTaskHandle, ENGINE_CORE);
+  
+  // Setup web server routes; the server starts once WiFi is up
+  setupWebServer();
+  
+  // Connect to WiFi in the background, see pumpWiFi()
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent(onWiFiEvent);
+  if (LIGHT_SLEEP) {
+    // Light sleep needs the radio off between beacons too
+    WiFi.setSleep(WIFI_PS_MIN_MODEM);
+  }
+  if (USE_STATIC_IP) {
+    WiFi.config(STATIC_IP, STATIC_GATEWAY, STATIC_SUBNET, STATIC_DNS);
+  }
+  wifiCacheValid = preferences.getBytes("wifi", &wifiCache, sizeof(wifiCache)) == sizeof(wifiCache);
+  beginWiFiAttempt(millis());
+}
+
+void loop() {
+  uint32_t start = ESP.getCycleCount();
+  pumpWiFi();
+  if (httpReady) {
+    server.handleClient();
+  }
+  flushCommands();
+  pumpStream();
+  pumpFleet();
+  pumpShow();
+  syncSnapshot();
+  pumpEvents();
+  pumpLongPolls();
+  pumpPersistence();
+  recordLatency(loopLatency, start);
+  waitForNextEvent();
+}
+
+// Log records are buffered from here on and printed once the task runs
+void setupLogging() {
+  for (int i = 0; i < LOG_RING_SIZE; i++) {
+    logRing[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  xTaskCreatePinnedToCore(logTask, "log", LOG_STACK_SIZE, nullptr, LOG_PRIORITY, &logTaskHandle, LOG_CORE);
+}
+
+// The first attempt after a successful connection goes straight to the
+// cached AP; if that fails, later attempts scan
+void beginWiFiAttempt(unsigned long now) {
+  bool fast = wifiCacheValid && wifiFailures == 0;
+  if (fast) {
+    WiFi.begin(ssid, password, wifiCache.channel, wifiCache.bssid);
+  } else {
+    WiFi.begin(ssid, password);
+  }
+  wifiState = WIFI_CONNECTING;
+  wifiStateTime = now;
+  wifiTimeout = fast ? WIFI_FAST_CONNECT_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS;
+  LOG_INFO(fast ? LOG_WIFI_CONNECTING_CACHED : LOG_WIFI_CONNECTING);
+}
+
+void pumpWiFi() {
+  unsigned long now = millis();
+  wl_status_t status = WiFi.status();
+  
+  switch (wifiState) {
+    case WIFI_CONNECTING:
+      if (status == WL_CONNECTED) {
+        onWiFiConnected(now);
+      } else if (status == WL_CONNECT_FAILED || now - wifiStateTime >= wifiTimeout) {
+        WiFi.disconnect();
+        wifiFailures++;
+        wifiState = WIFI_BACKOFF;
+        wifiStateTime = now;
+        wifiTimeout = min(WIFI_BACKOFF_MIN_MS << min(wifiFailures - 1, 6), WIFI_BACKOFF_MAX_MS);
+        LOG_WARN(LOG_WIFI_CONNECT_FAILED, wifiTimeout);
+      }
+      break;
+    case WIFI_CONNECTED:
+      if (status != WL_CONNECTED) {
+        LOG_WARN(LOG_WIFI_LOST);
+        wifiFailures = 0;
+        beginWiFiAttempt(now);
+      }
+      break;
+    case WIFI_BACKOFF:
+      if (now - wifiStateTime >= wifiTimeout) {
+        beginWiFiAttempt(now);
+      }
+      break;
+  }
+}
+
+void addWiFiWait(LoopWait& wait) {
+  if (wifiState != WIFI_CONNECTED) {
+    wait.dueAfter(wifiStateTime, wifiTimeout);
+  }
+}
+
+// Runs on the WiFi event task; status changes are handled by pumpWiFi()
+void onWiFiEvent(arduino_event_id_t event) {
+  wakeLoop();
+}
+
+void onWiFiConnected(unsigned long now) {
+  wifiState = WIFI_CONNECTED;
+  wifiStateTime = now;
+  wifiFailures = 0;
+  wifiConnects++;
+  IPAddress ip = WiFi.localIP();
+  LOG_INFO(LOG_WIFI_CONNECTED, ip[0], ip[1], ip[2], ip[3]);
+  
+  // Remember where the AP is for the next connect
+  WiFiCache found;
+  memcpy(found.bssid, WiFi.BSSID(), sizeof(found.bssid));
+  found.channel = WiFi.channel();
+  if (!wifiCacheValid || memcmp(&found, &wifiCache, sizeof(found)) != 0) {
+    wifiCache = found;
+    wifiCacheValid = true;
+    preferences.putBytes("wifi", &wifiCache, sizeof(wifiCache));
+  }
+  
+  if (!httpReady) {
+    server.begin(HTTP_PORT);
+    setupStream();
+    setupFleet();
+    httpReady = true;
+    httpReadyUs = esp_timer_get_time();
+    LOG_INFO(LOG_HTTP_STARTED, (int32_t)httpReadyUs);
+    LOG_INFO(LOG_HTTP_URL, ip[0], ip[1], ip[2], ip[3]);
+  }
+}
+
+void HttpServer::on(const char* path, HttpMethod method, void (*handler)()) {
+  if (routeCount < MAX_HTTP_ROUTES) {
+    routes[routeCount++] = {path, method, handler};
+  }
+}
+
+bool HttpServer::begin(uint16_t port) {
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    connections[i].fd = -1;
+    connections[i].state = HTTP_FREE;
+  }
+
+  listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  int reuse = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+      listen(listenFd, MAX_HTTP_CONNECTIONS) < 0) {
+    LOG_ERROR(LOG_HTTP_LISTEN_FAILED);
+    listenFd = -1;
+    return false;
+  }
+  fcntl(listenFd, F_SETFL, O_NONBLOCK);
+  return true;
+}
+
+// Takes every connection as far as it can go without blocking
+void HttpServer::handleClient() {
+  if (listenFd < 0) {
+    return;
+  }
+
+  unsigned long now = millis();
+  acceptConnections(now);
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    HttpConnection& c = connections[i];
+    if (c.state == HTTP_READING) {
+      readRequest(c, now);
+    }
+    if (c.state == HTTP_WRITING) {
+      writeResponse(c, now);
+    }
+  }
+}
+
+// Sockets and timeouts for loop()'s wait. Parked and streaming connections
+// are left to the long-poll and event pumps.
+void HttpServer::addWait(LoopWait& wait) const {
+  if (listenFd < 0) {
+    return;
+  }
+  wait.watchRead(listenFd);
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    const HttpConnection& c = connections[i];
+    if (c.state == HTTP_READING && c.waitingForBuffer) {
+      // Woken by the writer that gives one back
+      if (responseBuffersFree != 0) {
+        wait.dueIn(0);
+      }
+    } else if (c.state == HTTP_READING) {
+      if (c.pipelined) {
+        wait.dueIn(0);
+      }
+      wait.watchRead(c.fd);
+      wait.dueAfter(c.stateTime, c.received == 0 ? HTTP_IDLE_TIMEOUT_MS : HTTP_REQUEST_TIMEOUT_MS);
+    } else if (c.state == HTTP_WRITING) {
+      wait.watchWrite(c.fd);
+      wait.dueAfter(c.stateTime, HTTP_SEND_TIMEOUT_MS);
+    }
+  }
+}
+
+void HttpServer::acceptConnections(unsigned long now) {
+  int fd;
+  sockaddr_in peer;
+  socklen_t peerLength = sizeof(peer);
+  while ((fd = accept(listenFd, (sockaddr*)&peer, &peerLength)) >= 0) {
+    HttpConnection* c = nullptr;
+    for (int i = 0; i < MAX_HTTP_CONNECTIONS && c == nullptr; i++) {
+      if (connections[i].state == HTTP_FREE) {
+        c = &connections[i];
+      }
+    }
+
+    // Out of connections: a quick 503 rather than leaving the client hanging
+    if (c == nullptr) {
+      static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\n"
+                                 "Content-Length: 0\r\n"
+                                 "Connection: close\r\n\r\n";
+      ::send(fd, busy, sizeof(busy) - 1, MSG_DONTWAIT);
+      ::close(fd);
+      continue;
+    }
+
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    c->fd = fd;
+    c->peer = peer.sin_addr.s_addr;
+    c->state = HTTP_READING;
+    c->stateTime = now;
+    c->received = 0;
+    c->request[0] = '\0';  // the last client's request is still in the buffer
+    c->headerLength = 0;
+    c->pipelined = false;
+    c->waitingForBuffer = false;
+  }
+}
+
+// A buffer for c's response, if it hasn't one already and one is free
+bool HttpServer::takeResponseBuffer(HttpConnection& c) {
+  if (c.response != nullptr) {
+    return true;
+  }
+  for (int b = 0; b < HTTP_RESPONSE_BUFFERS; b++) {
+    if (responseBuffersFree & (1 << b)) {
+      responseBuffersFree &= ~(1 << b);
+      c.response = responseBuffers[b];
+      return true;
+    }
+  }
+  return false;
+}
+
+void HttpServer::releaseResponseBuffer(HttpConnection& c) {
+  if (c.response != nullptr) {
+    responseBuffersFree |= 1 << ((c.response - responseBuffers[0]) / HTTP_RESPONSE_BUFFER_SIZE);
+    c.response = nullptr;
+  }
+}
+
+void HttpServer::readRequest(HttpConnection& c, unsigned long now) {
+  c.pipelined = false;
+  if (c.received < HTTP_REQUEST_BUFFER_SIZE) {
+    int n = ::recv(c.fd, c.request + c.received, HTTP_REQUEST_BUFFER_SIZE - c.received, MSG_DONTWAIT);
+    if (n > 0) {
+      if (c.received == 0) {
+        c.stateTime = now;  // the request timeout runs from its first byte
+      }
+      c.received += n;
+      c.request[c.received] = '\0';
+    } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+      closeConnection(c);
+      return;
+    }
+  }
+
+  bool complete = false;
+  if (c.headerLength == 0) {
+    char* end = strstr(c.request, "\r\n\r\n");
+    if (end != nullptr) {
+      if (!parseHead(c, end)) {
+        return;
+      }
+    } else if (c.received >= HTTP_HEADER_SIZE) {
+      reject(c, 431, "Headers too large");
+      return;
+    }
+  }
+  if (c.headerLength > 0) {
+    complete = c.received >= c.headerLength + c.contentLength;
+  }
+
+  if (complete) {
+    c.waitingForBuffer = !takeResponseBuffer(c);
+    if (!c.waitingForBuffer) {
+      dispatch(c);
+    }
+  } else if (c.received == 0 && now - c.stateTime >= HTTP_IDLE_TIMEOUT_MS) {
+    closeConnection(c);
+  } else if (c.received > 0 && now - c.stateTime >= HTTP_REQUEST_TIMEOUT_MS) {
+    reject(c, 408, "Request timeout");
+  }
+}
+
+// Decodes %XX and '+' in place
+void urlDecode(char* text) {
+  char* out = text;
+  for (char* in = text; *in; in++) {
+    if (*in == '+') {
+      *out++ = ' ';
+    } else if (*in == '%' && isxdigit((unsigned char)in[1]) && isxdigit((unsigned char)in[2])) {
+      char hex[3] = {in[1], in[2], '\0'};
+      *out++ = strtol(hex, nullptr, 16);
+      in += 2;
+    } else {
+      *out++ = *in;
+    }
+  }
+  *out = '\0';
+}
+
+// Splits the request line, query and headers in place. end points at the
+// blank line. Returns false if the request was rejected.
+bool HttpServer::parseHead(HttpConnection& c, char* end) {
+  size_t headerLength = end + 4 - c.request;
+  if (headerLength > HTTP_HEADER_SIZE) {
+    reject(c, 431, "Headers too large");
+    return false;
+  }
+  end[2] = '\0';  // the head is now one string of CRLF-terminated lines
+
+  // METHOD /path?query HTTP/1.x
+  char* line = c.request;
+  char* eol = strstr(line, "\r\n");
+  *eol = '\0';
+  char* target = strchr(line, ' ');
+  char* version = target != nullptr ? strchr(target + 1, ' ') : nullptr;
+  if (version == nullptr || strncmp(version + 1, "HTTP/1.", 7) != 0) {
+    reject(c, 400, "Bad request");
+    return false;
+  }
+  *target++ = '\0';
+  *version++ = '\0';
+
+  c.method = strcmp(line, "GET") == 0 ? METHOD_GET :
+             strcmp(line, "POST") == 0 ? METHOD_POST :
+             strcmp(line, "OPTIONS") == 0 ? METHOD_OPTIONS : METHOD_OTHER;
+  c.http11 = strcmp(version, "HTTP/1.0") != 0;
+
+  c.argCount = 0;
+  char* query = strchr(target, '?');
+  if (query != nullptr) {
+    *query++ = '\0';
+  }
+  while (query != nullptr && *query != '\0' && c.argCount < MAX_HTTP_ARGS) {
+    char* next = strchr(query, '&');
+    if (next != nullptr) {
+      *next++ = '\0';
+    }
+    char* value = strchr(query, '=');
+    if (value != nullptr) {
+      *value++ = '\0';
+    } else {
+      value = query + strlen(query);
+    }
+    urlDecode(query);
+    urlDecode(value);
+    c.args[c.argCount++] = {query, value};
+    query = next;
+  }
+  urlDecode(target);
+  c.path = target;
+
+  c.headerCount = 0;
+  for (line = eol + 2; *line != '\0'; line = eol + 2) {
+    eol = strstr(line, "\r\n");
+    *eol = '\0';
+    char* colon = strchr(line, ':');
+    if (colon != nullptr && c.headerCount < MAX_HTTP_HEADERS) {
+      *colon = '\0';
+      char* value = colon + 1;
+      while (*value == ' ' || *value == '\t') {
+        value++;
+      }
+      c.headers[c.headerCount++] = {line, value};
+    }
+  }
+
+  // Header lookups below go through header(), which reads current
+  current = &c;
+  const char* connection = header("Connection");
+  c.keepAlive = c.http11 ? strcasecmp(connection, "close") != 0 : strcasecmp(connection, "keep-alive") == 0;
+
+  if (header("Transfer-Encoding")[0] != '\0') {
+    reject(c, 411, "Content-Length required");
+    return false;
+  }
+  char* lengthEnd;
+  unsigned long length = strtoul(header("Content-Length"), &lengthEnd, 10);
+  if (*lengthEnd != '\0') {
+    reject(c, 400, "Bad request");
+    return false;
+  }
+  if (length > MAX_BODY_SIZE) {
+    reject(c, 413, "Body too large");
+    return false;
+  }
+
+  c.headerLength = headerLength;
+  c.contentLength = length;
+
+  if (length > 0 && c.received < headerLength + length && strcasecmp(header("Expect"), "100-continue") == 0) {
+    static const char proceed[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    ::send(c.fd, proceed, sizeof(proceed) - 1, MSG_DONTWAIT);
+  }
+  current = nullptr;
+  return true;
+}
+
+void HttpServer::dispatch(HttpConnection& c) {
+  current = &c;
+  extraHeadersLength = 0;
+
+  if (c.method == METHOD_OPTIONS) {
+    // CORS preflight, for any path
+    sendHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    sendHeader("Access-Control-Allow-Headers", "Content-Type");
+    sendHeader("Access-Control-Max-Age", "600");
+    send(204);
+  } else {
+    void (*handler)() = notFoundHandler;
+    for (int r = 0; r < routeCount; r++) {
+      if (routes[r].method == c.method && strcmp(routes[r].path, c.path) == 0) {
+        handler = routes[r].handler;
+        break;
+      }
+    }
+    if (handler != nullptr) {
+      handler();
+    }
+    if (c.state == HTTP_READING) {
+      send(500, "application/json", "{\"error\":\"No response\"}");
+    }
+  }
+
+  current = nullptr;
+}
+
+bool HttpServer::hasArg(const char* name) const {
+  for (int i = 0; i < current->argCount; i++) {
+    if (strcmp(current->args[i].name, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* HttpServer::arg(const char* name) const {
+  for (int i = 0; i < current->argCount; i++) {
+    if (strcmp(current->args[i].name, name) == 0) {
+      return current->args[i].value;
+    }
+  }
+  return "";
+}
+
+const char* HttpServer::header(const char* name) const {
+  for (int i = 0; i < current->headerCount; i++) {
+    if (strcasecmp(current->headers[i].name, name) == 0) {
+      return current->headers[i].value;
+    }
+  }
+  return "";
+}
+
+void HttpServer::sendHeader(const char* name, const char* value) {
+  size_t room = sizeof(extraHeaders) - extraHeadersLength;
+  int n = snprintf(extraHeaders + extraHeadersLength, room, "%s: %s\r\n", name, value);
+  if (n > 0 && (size_t)n < room) {
+    extraHeadersLength += n;
+  }
+}
+
+const char* httpStatusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    case 507: return "Insufficient Storage";
+    default: return "Unknown";
+  }
+}
+
+// Writes the status line and headers into response[]. A negative length
+// means the body length isn't known up front: it is sent chunked, or to
+// HTTP/1.0 clients delimited by closing the connection.
+void HttpServer::startResponse(HttpConnection& c, int code, const char* type, long length) {
+  c.chunked = length < 0 && c.http11;
+  if (length < 0 && !c.http11) {
+    c.keepAlive = false;
+  }
+
+  char* out = c.response;
+  size_t size = HTTP_RESPONSE_HEAD_SIZE;
+  size_t n = snprintf(out, size, "HTTP/1.1 %d %s\r\nAccess-Control-Allow-Origin: *\r\n",
+                      code, httpStatusText(code));
+  if (type != nullptr) {
+    n += snprintf(out + n, size - n, "Content-Type: %s\r\n", type);
+  }
+  if (&c == current) {
+    memcpy(out + n, extraHeaders, extraHeadersLength);
+    n += extraHeadersLength;
+  }
+  if (c.chunked) {
+    n += snprintf(out + n, size - n, "Transfer-Encoding: chunked\r\n");
+  } else if (length >= 0 && code != 204 && code != 304) {
+    n += snprintf(out + n, size - n, "Content-Length: %ld\r\n", length);
+  }
+  n += snprintf(out + n, size - n, "Connection: %s\r\n\r\n", c.keepAlive ? "keep-alive" : "close");
+
+  c.responseLength = n;
+  c.sent = 0;
+  c.body = nullptr;
+  c.bodyLength = 0;
+  c.bodySent = 0;
+  c.writer = nullptr;
+  c.state = HTTP_WRITING;
+  c.stateTime = millis();
+  lastStatus = code;
+}
+
+void HttpServer::send(int code, const char* type, const char* content) {
+  send(code, type, content, content != nullptr ? strlen(content) : 0);
+}
+
+void HttpServer::send(int code, const char* type, const char* content, size_t length) {
+  if (length > HTTP_MAX_CONTENT) {
+    LOG_ERROR(LOG_HTTP_RESPONSE_TOO_LARGE, length);
+    code = 500;
+    type = nullptr;
+    length = 0;
+  }
+  startResponse(*current, code, type, length);
+  if (length > 0) {
+    memcpy(current->response + current->responseLength, content, length);
+    current->responseLength += length;
+  }
+}
+
+void HttpServer::sendStatic(int code, const char* type, const char* content, size_t length) {
+  startResponse(*current, code, type, length);
+  current->body = content;
+  current->bodyLength = length;
+}
+
+void HttpServer::sendChunked(int code, const char* type, HttpChunkWriter writer) {
+  startResponse(*current, code, type, -1);
+  current->writer = writer;
+  current->writerCursor = 0;
+}
+
+// Appends to the chunk being filled. Returns false, adding nothing, if the
+// text doesn't fit; writers keep each piece well inside the buffer.
+bool HttpServer::print(const char* format, ...) {
+  HttpConnection& c = *current;
+  size_t room = HTTP_RESPONSE_BUFFER_SIZE - HTTP_CHUNK_RESERVE - c.responseLength;
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(c.response + c.responseLength, room, format, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= room) {
+    return false;
+  }
+  c.responseLength += n;
+  return true;
+}
+
+// Refills response[] with the writer's next piece, framed as a chunk
+void HttpServer::fillChunk(HttpConnection& c) {
+  size_t start = c.chunked ? 6 : 0;  // room for the longest size line, "xxxx\r\n"
+  HttpConnection* handling = current;
+  current = &c;
+  c.responseLength = start;
+  bool more = c.writer(c.writerCursor);
+  current = handling;
+
+  size_t payload = c.responseLength - start;
+  c.sent = 0;
+  if (c.chunked) {
+    if (payload > 0) {
+      // Right-aligned against the payload, and sent from where it starts
+      char sizeLine[7];
+      int n = snprintf(sizeLine, sizeof(sizeLine), "%x\r\n", (unsigned)payload);
+      c.sent = start - n;
+      memcpy(c.response + c.sent, sizeLine, n);
+      memcpy(c.response + c.responseLength, "\r\n", 2);
+      c.responseLength += 2;
+    } else {
+      c.sent = start;
+    }
+    if (!more) {
+      memcpy(c.response + c.responseLength, "0\r\n\r\n", 5);
+      c.responseLength += 5;
+    }
+  }
+  if (!more) {
+    c.writer = nullptr;
+  }
+}
+
+void HttpServer::writeResponse(HttpConnection& c, unsigned long now) {
+  for (;;) {
+    bool fromBody = false;
+    const char* data;
+    size_t length;
+    if (c.sent < c.responseLength) {
+      data = c.response + c.sent;
+      length = c.responseLength - c.sent;
+    } else if (c.bodySent < c.bodyLength) {
+      data = c.body + c.bodySent;
+      length = c.bodyLength - c.bodySent;
+      fromBody = true;
+    } else if (c.writer != nullptr) {
+      fillChunk(c);
+      continue;
+    } else {
+      finishResponse(c, now);
+      return;
+    }
+
+    int n = ::send(c.fd, data, length, MSG_DONTWAIT);
+    if (n > 0) {
+      if (fromBody) {
+        c.bodySent += n;
+      } else {
+        c.sent += n;
+      }
+      c.stateTime = now;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (now - c.stateTime >= HTTP_SEND_TIMEOUT_MS) {
+        closeConnection(c);
+      }
+      return;
+    } else {
+      closeConnection(c);
+      return;
+    }
+  }
+}
+
+// Back to reading on a keep-alive connection, keeping any pipelined request
+// that already arrived behind this one
+void HttpServer::finishResponse(HttpConnection& c, unsigned long now) {
+  if (!c.keepAlive) {
+    closeConnection(c);
+    return;
+  }
+
+  releaseResponseBuffer(c);
+  size_t used = c.headerLength + c.contentLength;
+  c.received -= used;
+  memmove(c.request, c.request + used, c.received);
+  c.request[c.received] = '\0';
+  c.pipelined = c.received > 0;
+  c.headerLength = 0;
+  c.contentLength = 0;
+  c.state = HTTP_READING;
+  c.stateTime = now;
+}
+
+// Error response for a request that never reached a handler. The rest of
+// it is unread, so the connection closes afterwards; with no response
+// buffer free it just closes.
+void HttpServer::reject(HttpConnection& c, int code, const char* message) {
+  if (!takeResponseBuffer(c)) {
+    closeConnection(c);
+    return;
+  }
+  char content[64];
+  int n = snprintf(content, sizeof(content), "{\"error\":\"%s\"}", message);
+  c.keepAlive = false;
+  current = &c;
+  extraHeadersLength = 0;
+  send(code, "application/json", content, n);
+  current = nullptr;
+}
+
+int HttpServer::park() {
+  current->state = HTTP_PARKED;
+  releaseResponseBuffer(*current);
+  return current - connections;
+}
+
+int HttpServer::stream() {
+  current->state = HTTP_STREAMING;
+  releaseResponseBuffer(*current);
+  current->keepAlive = false;
+  return current - connections;
+}
+
+// For parked and streaming connections, which nothing reads from
+bool HttpServer::peerClosed(int conn) const {
+  char probe;
+  int n = ::recv(connections[conn].fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+  return n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+// Answers a parked request; the connection then carries on as keep-alive.
+// False, leaving it parked, while every response buffer is busy.
+bool HttpServer::respond(int conn, int code, const char* type, const char* content, size_t length) {
+  if (!takeResponseBuffer(connections[conn])) {
+    return false;
+  }
+  current = &connections[conn];
+  extraHeadersLength = 0;
+  send(code, type, content, length);
+  current = nullptr;
+  return true;
+}
+
+void HttpServer::closeConnection(HttpConnection& c) {
+  releaseResponseBuffer(c);
+  ::close(c.fd);
+  c.fd = -1;
+  c.state = HTTP_FREE;
+}
+
+void setupWebServer() {
+  // Serve the main HTML page
+  server.on("/", METHOD_GET, []() { timeRoute(ROUTE_ROOT, handleRoot); });
+  
+  // API endpoints
+  server.on("/api/status", METHOD_GET, []() { timeRoute(ROUTE_STATUS, handleGetStatus); });
+  server.on("/api/led", METHOD_POST, []() { timeRoute(ROUTE_LED, handleLEDControl); });
+  server.on("/api/all", METHOD_POST, []() { timeRoute(ROUTE_ALL, handleAllLEDs); });
+  server.on("/api/batch", METHOD_POST, []() { timeRoute(ROUTE_BATCH, handleBatch); });
+  server.on("/api/events", METHOD_GET, []() { timeRoute(ROUTE_EVENTS, handleEvents); });
+  server.on("/api/scenes", METHOD_GET, []() { timeRoute(ROUTE_SCENES, handleGetScenes); });
+  server.on("/api/scenes", METHOD_POST, []() { timeRoute(ROUTE_SCENES, handleSceneControl); });
+  server.on("/api/metrics", METHOD_GET, []() { timeRoute(ROUTE_METRICS, handleMetrics); });
+  server.on("/api/fleet", METHOD_GET, []() { timeRoute(ROUTE_FLEET, handleFleet); });
+  server.on("/api/shows", METHOD_GET, []() { timeRoute(ROUTE_SHOWS, handleGetShows); });
+  server.on("/api/shows", METHOD_POST, []() { timeRoute(ROUTE_SHOWS, handleShowControl); });
+  server.on("/api/playback", METHOD_GET, []() { timeRoute(ROUTE_PLAYBACK, handleGetPlayback); });
+  server.on("/api/playback", METHOD_POST, []() { timeRoute(ROUTE_PLAYBACK, handlePlaybackControl); });
+  server.onNotFound([]() { timeRoute(ROUTE_NOT_FOUND, handleNotFound); });
+  // Every response carries Access-Control-Allow-Origin; OPTIONS preflights
+  // are answered by the server itself
+}
+void handleRoot() {
+  // The page is prebuilt by tools/build_dashboard.py into a gzip blob in flash.
+  // Browsers revalidate on reload and get a bodyless 304 while it is unchanged.
+  server.sendHeader("ETag", DASHBOARD_ETAG);
+  server.sendHeader("Cache-Control", "no-cache");
+
+  if (strstr(server.header("If-None-Match"), DASHBOARD_ETAG) != nullptr) {
+    server.send(304);
+    return;
+  }
+
+  server.sendHeader("Content-Encoding", "gzip");
+  server.sendStatic(200, "text/html", (const char*)DASHBOARD_HTML_GZ, DASHBOARD_HTML_GZ_LEN);
+}
+
+// Applies a list of per-channel operations as one scene change:
+//   {"ops":[{"led":0,"action":"on"},{"led":1,"action":"brightness","value":64},...]}
+// Ops may carry "fade":<ms>; fades in one batch start on the same tick, which
+// makes a batch a crossfade between scenes.
+// Every op is validated before any is applied, so a bad op rejects the whole
+// batch. The LED engine applies the ops in one pass and writes the PWM
+// outputs together afterwards, so channels never show a half-applied scene.
+void handleBatch() {
+  if (!admitCommand() || !parseRequestBody()) {
+    return;
+  }
+  
+  JsonArray ops = requestDoc["ops"];
+  if (ops.isNull() || ops.size() == 0 || ops.size() > MAX_BATCH_OPS) {
+    server.send(400, "application/json", "{\"error\":\"Invalid ops list\"}");
+    return;
+  }
+  
+  int count = ops.size();
+  int ledIndex[MAX_BATCH_OPS];
+  LEDAction action[MAX_BATCH_OPS];
+  long value[MAX_BATCH_OPS];
+  long fadeMs[MAX_BATCH_OPS];
+  const char* error[MAX_BATCH_OPS];
+  bool valid = true;
+  
+  for (int op = 0; op < count; op++) {
+    ledIndex[op] = ops[op]["led"] | -1;
+    action[op] = parseLEDAction(ops[op]["action"] | "");
+    value[op] = ops[op]["value"] | 0;
+    fadeMs[op] = ops[op]["fade"] | 0;
+    error[op] = validateLEDCommand(ledIndex[op], action[op], value[op], fadeMs[op]);
+    if (error[op] == nullptr && streamHolds(ledIndex[op])) {
+      error[op] = "Channel is streaming";
+    }
+    if (error[op] != nullptr) {
+      valid = false;
+    }
+  }
+  
+  if (valid) {
+    // The engine holds back the commit until the op without CMD_DEFER
+    if (!flushCommands() || commandQueueSpace() < (uint32_t)count) {
+      server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+      return;
+    }
+    for (int op = 0; op < count; op++) {
+      queueLEDCommand(action[op], ledIndex[op], value[op], fadeMs[op], op < count - 1 ? CMD_DEFER : 0);
+    }
+    wakeLEDEngine();
+  }
+  
+  static char response[BATCH_RESPONSE_SIZE];
+  size_t size = sizeof(response);
+  size_t n = snprintf(response, size, "{\"success\":%s,\"results\":[", valid ? "true" : "false");
+  for (int op = 0; op < count; op++) {
+    if (op > 0) {
+      response[n++] = ',';
+    }
+    if (error[op] == nullptr) {
+      n += snprintf(response + n, size - n, "{\"led\":%d,\"ok\":true}", ledIndex[op]);
+    } else {
+      n += snprintf(response + n, size - n, "{\"led\":%d,\"ok\":false,\"error\":\"%s\"}", ledIndex[op], error[op]);
+    }
+  }
+  n += snprintf(response + n, size - n, "]}");
+  
+  server.send(valid ? 200 : 400, "application/json", response, n);
+}
+
+// One page of channels: {"version":N,"count":<total>,"offset":<first>,"leds":[...]}
+void refreshStatusCache(int offset, int count) {
+  if (statusCacheVersion == statusSnapshot.version && statusCacheOffset == offset &&
+      statusCacheCount == count) {
+    return;
+  }
+  
+  char* out = statusCache;
+  size_t size = STATUS_BUFFER_SIZE;
+  size_t n = snprintf(out, size, "{\"version\":%lu,\"count\":%d,\"offset\":%d,\"leds\":[",
+                      (unsigned long)statusSnapshot.version, NUM_LEDS, offset);
+  for (int i = offset; i < offset + count; i++) {
+    if (i > offset) {
+      out[n++] = ',';
+    }
+    n += formatLEDJson(out + n, size - n, i);
+  }
+  n += snprintf(out + n, size - n, "]}");
+  
+  statusCacheLength = n;
+  statusCacheVersion = statusSnapshot.version;
+  statusCacheOffset = offset;
+  statusCacheCount = count;
+}
+
+// Every channel at once: "on" is a bitmask in hex, four channels per digit
+// with the lowest channel in the lowest bit; "brightness" is two hex digits
+// and "effect" one decimal digit (EffectType) per channel
+void refreshCompactCache() {
+  if (compactCacheVersion == statusSnapshot.version) {
+    return;
+  }
+  
+  static const char hexDigits[] = "0123456789abcdef";
+  char* out = compactCache;
+  size_t size = COMPACT_BUFFER_SIZE;
+  size_t n = snprintf(out, size, "{\"version\":%lu,\"count\":%d,\"on\":\"",
+                      (unsigned long)statusSnapshot.version, NUM_LEDS);
+  for (int i = 0; i < NUM_LEDS; i += 4) {
+    int nibble = 0;
+    for (int bit = 0; bit < 4 && i + bit < NUM_LEDS; bit++) {
+      nibble |= statusSnapshot.leds[i + bit].isOn << bit;
+    }
+    out[n++] = hexDigits[nibble];
+  }
+  n += snprintf(out + n, size - n, "\",\"brightness\":\"");
+  for (int i = 0; i < NUM_LEDS; i++) {
+    out[n++] = hexDigits[statusSnapshot.leds[i].brightness >> 4];
+    out[n++] = hexDigits[statusSnapshot.leds[i].brightness & 0x0F];
+  }
+  n += snprintf(out + n, size - n, "\",\"effect\":\"");
+  for (int i = 0; i < NUM_LEDS; i++) {
+    out[n++] = '0' + statusSnapshot.leds[i].effect;
+  }
+  n += snprintf(out + n, size - n, "\"}");
+  
+  compactCacheLength = n;
+  compactCacheVersion = statusSnapshot.version;
+}
+
+// ?format=compact, or ?offset=<first>&limit=<n> for the paged JSON form.
+// Returns false if an argument is out of range.
+bool parseStatusQuery(StatusQuery& query) {
+  const char* format = server.arg("format");
+  long offset = server.hasArg("offset") ? strtol(server.arg("offset"), nullptr, 10) : 0;
+  long limit = server.hasArg("limit") ? strtol(server.arg("limit"), nullptr, 10) : STATUS_PAGE_SIZE;
+  
+  bool compact = strcmp(format, "compact") == 0;
+  if (format[0] != '\0' && strcmp(format, "json") != 0 && !compact) {
+    return false;
+  }
+  if (offset < 0 || offset >= NUM_LEDS || limit < 1 || limit > STATUS_PAGE_SIZE) {
+    return false;
+  }
+  
+  query.compact = compact;
+  query.offset = offset;
+  query.count = min(limit, (long)NUM_LEDS - offset);
+  return true;
+}
+
+const char* statusBody(const StatusQuery& query, size_t& length) {
+  if (query.compact) {
+    refreshCompactCache();
+    length = compactCacheLength;
+    return compactCache;
+  }
+  refreshStatusCache(query.offset, query.count);
+  length = statusCacheLength;
+  return statusCache;
+}
+
+void handleGetStatus() {
+  syncSnapshot();
+  
+  StatusQuery query;
+  if (!parseStatusQuery(query)) {
+    server.send(400, "application/json", "{\"error\":\"Invalid status query\"}");
+    return;
+  }
+  
+  if (server.hasArg("since")) {
+    uint32_t since = strtoul(server.arg("since"), nullptr, 10);
+    if (since == statusSnapshot.version) {
+      unsigned long wait = server.hasArg("wait") ? strtoul(server.arg("wait"), nullptr, 10) : 0;
+      if (wait > 0) {
+        for (int c = 0; c < MAX_LONGPOLL_CLIENTS; c++) {
+          LongPollClient& lp = longPollClients[c];
+          if (!lp.active) {
+            // Answered later from pumpLongPolls(), same as an event stream
+            lp.conn = server.park();
+            lp.active = true;
+            lp.query = query;
+            lp.since = since;
+            lp.startTime = millis();
+            lp.timeout = min(wait, LONGPOLL_MAX_MS);
+            return;
+          }
+        }
+      }
+      // Nothing changed (or no long-poll slot free): no body to send
+      server.send(304);
+      return;
+    }
+  }
+  
+  size_t length;
+  const char* body = statusBody(query, length);
+  server.send(200, "application/json", body, length);
+}
+
+// Completes parked long-poll requests once the state changes or they time out
+void pumpLongPolls() {
+  unsigned long now = millis();
+  for (int c = 0; c < MAX_LONGPOLL_CLIENTS; c++) {
+    LongPollClient& lp = longPollClients[c];
+    if (!lp.active) {
+      continue;
+    }
+    
+    if (server.peerClosed(lp.conn)) {
+      server.close(lp.conn);
+    } else if (lp.since != statusSnapshot.version) {
+      size_t length;
+      const char* body = statusBody(lp.query, length);
+      if (!server.respond(lp.conn, 200, "application/json", body, length)) {
+        continue;  // tried again once a response buffer is free
+      }
+      countRouteStatus(ROUTE_STATUS, 200);
+    } else if (now - lp.startTime >= lp.timeout) {
+      if (!server.respond(lp.conn, 304, nullptr, nullptr, 0)) {
+        continue;
+      }
+      countRouteStatus(ROUTE_STATUS, 304);
+    } else {
+      continue;
+    }
+    
+    lp.active = false;
+  }
+}
+
+// Readable means the client went away; state changes come in as a signal.
+// A timeout can only be answered once a response buffer is free.
+void addLongPollWait(LoopWait& wait) {
+  for (int c = 0; c < MAX_LONGPOLL_CLIENTS; c++) {
+    const LongPollClient& lp = longPollClients[c];
+    if (lp.active) {
+      wait.watchRead(server.fd(lp.conn));
+      if (server.canRespond()) {
+        wait.dueAfter(lp.startTime, lp.timeout);
+      }
+    }
+  }
+}
+
+void handleLEDControl() {
+  if (!admitCommand() || !parseRequestBody()) {
+    return;
+  }
+  
+  int ledIndex = requestDoc["led"] | -1;
+  LEDAction action = parseLEDAction(requestDoc["action"] | "");
+  long value = requestDoc["value"] | 0;
+  long fadeMs = requestDoc["fade"] | 0;
+  
+  const char* error = validateLEDCommand(ledIndex, action, value, fadeMs);
+  if (error != nullptr) {
+    char response[64];
+    snprintf(response, sizeof(response), "{\"error\":\"%s\"}", error);
+    server.send(400, "application/json", response);
+    return;
+  }
+  
+  if (streamHolds(ledIndex)) {
+    server.send(409, "application/json", "{\"error\":\"Channel is streaming\"}");
+    return;
+  }
+  
+  bool queued = false;
+  switch (action) {
+    case ACTION_ON:
+      queued = turnOnLED(ledIndex, fadeMs);
+      break;
+    case ACTION_OFF:
+      queued = turnOffLED(ledIndex, fadeMs);
+      break;
+    case ACTION_BLINK:
+      queued = blinkLED(ledIndex, value);
+      break;
+    case ACTION_BRIGHTNESS:
+      queued = setLEDBrightness(ledIndex, value, fadeMs);
+      break;
+    case ACTION_PULSE:
+      queued = pulseLED(ledIndex, value);
+      break;
+    case ACTION_TIMER:
+      queued = setLEDTimer(ledIndex, value);
+      break;
+    default:
+      break;
+  }
+  
+  if (!queued) {
+    server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+    return;
+  }
+  
+  server.send(200, "application/json", "{\"success\":true}");
+}
+
+void handleAllLEDs() {
+  if (!admitCommand() || !parseRequestBody()) {
+    return;
+  }
+  
+  LEDAction action = parseLEDAction(requestDoc["action"] | "");
+  long fadeMs = requestDoc["fade"] | 0;
+  
+  if (action != ACTION_ON && action != ACTION_OFF) {
+    server.send(400, "application/json", "{\"error\":\"Invalid action\"}");
+    return;
+  }
+  if (fadeMs < 0 || fadeMs > MAX_FADE_MS) {
+    server.send(400, "application/json", "{\"error\":\"Invalid fade\"}");
+    return;
+  }
+  
+  // With a group the command goes to every node in it, this one included
+  // if it's a member, and they all commit it at the same fleet time
+  const char* group = requestDoc["group"].as<const char*>();
+  if (group != nullptr) {
+    if (!fleetGroupValid(group)) {
+      server.send(400, "application/json", "{\"error\":\"Invalid group\"}");
+      return;
+    }
+    if (fleetSocket < 0 || !fleetSynced) {
+      server.send(503, "application/json", "{\"error\":\"Fleet clock not synced\"}");
+      return;
+    }
+    if (fleetGroupMatches(group) && streamHolds(ALL_LEDS)) {
+      server.send(409, "application/json", "{\"error\":\"Channel is streaming\"}");
+      return;
+    }
+    uint16_t id;
+    int64_t due;
+    sendFleetCommand(action, fadeMs, group, id, due);
+    char response[96];
+    snprintf(response, sizeof(response), "{\"success\":true,\"id\":%u,\"dueUs\":%lld}", id, (long long)due);
+    server.send(200, "application/json", response);
+    return;
+  }
+  
+  if (streamHolds(ALL_LEDS)) {
+    server.send(409, "application/json", "{\"error\":\"Channel is streaming\"}");
+    return;
+  }
+  
+  bool queued = action == ACTION_ON ? turnOnAllLEDs(fadeMs) : turnOffAllLEDs(fadeMs);
+  
+  if (!queued) {
+    server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+    return;
+  }
+  
+  server.send(200, "application/json", "{\"success\":true}");
+}
+
+int formatLEDJson(char* buffer, size_t size, int ledNum) {
+  static const char* const effectNames[] = {"none", "blink", "pulse", "timer"};
+  return snprintf(buffer, size, "{\"led\":%d,\"isOn\":%s,\"brightness\":%d,\"blinkInterval\":%lu,\"effect\":\"%s\"}",
+                  ledNum, statusSnapshot.leds[ledNum].isOn ? "true" : "false",
+                  statusSnapshot.leds[ledNum].brightness,
+                  (unsigned long)statusSnapshot.leds[ledNum].blinkInterval,
+                  effectNames[statusSnapshot.leds[ledNum].effect]);
+}
+
+void handleEvents() {
+  EventClient* slot = nullptr;
+  for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+    if (!eventClients[c].active) {
+      slot = &eventClients[c];
+      break;
+    }
+  }
+  
+  // Browsers that can't get a slot keep polling /api/status
+  if (slot == nullptr) {
+    server.send(503, "application/json", "{\"error\":\"Too many event clients\"}");
+    return;
+  }
+  
+  // The stream outlives this request, so take the connection over from the
+  // server and queue the response head as the first bytes to send
+  slot->conn = server.stream();
+  slot->length = snprintf(slot->buffer, EVENT_BUFFER_SIZE,
+                          "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: text/event-stream\r\n"
+                          "Cache-Control: no-cache\r\n"
+                          "Connection: keep-alive\r\n"
+                          "Access-Control-Allow-Origin: *\r\n\r\n");
+  slot->sent = 0;
+  server.lastStatus = 200;
+  
+  slot->active = true;
+  slot->needsSnapshot = true;
+  slot->pendingLEDs.clear();
+  slot->lastWriteTime = millis();
+}
+
+// Formats the next event for a client into its buffer. Returns false if
+// there is nothing to send.
+bool queueEvent(EventClient& ec, unsigned long now) {
+  char* out = ec.buffer;
+  size_t size = EVENT_BUFFER_SIZE;
+  size_t n = 0;
+  
+  // When most channels changed at once a snapshot is cheaper than deltas
+  int ledNum = ec.pendingLEDs.next();
+  if (ec.needsSnapshot || ec.pendingLEDs.count() > NUM_LEDS / 2) {
+    refreshCompactCache();
+    n += snprintf(out + n, size - n, "event: snapshot\ndata: ");
+    memcpy(out + n, compactCache, compactCacheLength);
+    n += compactCacheLength;
+    n += snprintf(out + n, size - n, "\n\n");
+    ec.needsSnapshot = false;
+    ec.pendingLEDs.clear();
+  } else if (ledNum >= 0) {
+    ec.pendingLEDs.reset(ledNum);
+    n += snprintf(out + n, size - n, "event: led\ndata: ");
+    n += formatLEDJson(out + n, size - n, ledNum);
+    n += snprintf(out + n, size - n, "\n\n");
+  } else if (now - ec.lastWriteTime >= EVENT_KEEPALIVE_MS) {
+    n += snprintf(out + n, size - n, ": ping\n\n");
+  } else {
+    return false;
+  }
+  
+  ec.length = n;
+  ec.sent = 0;
+  return true;
+}
+
+// Writes as much of the queued event as the socket accepts without
+// blocking. Returns false if the client is gone or has stalled too long.
+bool flushEvent(EventClient& ec, unsigned long now) {
+  while (ec.sent < ec.length) {
+    int n = send(server.fd(ec.conn), ec.buffer + ec.sent, ec.length - ec.sent, MSG_DONTWAIT);
+    if (n > 0) {
+      ec.sent += n;
+      ec.lastWriteTime = now;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return now - ec.lastWriteTime < EVENT_STALL_TIMEOUT_MS;
+    } else {
+      return false;
+    }
+  }
+  ec.length = 0;
+  ec.sent = 0;
+  return true;
+}
+
+// Pushes pending changes to every subscribed browser, once per loop()
+void pumpEvents() {
+  unsigned long now = millis();
+  for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+    EventClient& ec = eventClients[c];
+    if (!ec.active) {
+      continue;
+    }
+    
+    bool ok = !server.peerClosed(ec.conn) && flushEvent(ec, now);
+    while (ok && ec.length == 0 && queueEvent(ec, now)) {
+      ok = flushEvent(ec, now);
+    }
+    
+    if (!ok) {
+      server.close(ec.conn);
+      ec.active = false;
+      ec.length = 0;
+      ec.sent = 0;
+    }
+  }
+}
+
+// An event left half-sent waits for the socket, or times out as stalled;
+// otherwise the next one due is the keep-alive ping
+void addEventWait(LoopWait& wait) {
+  for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+    const EventClient& ec = eventClients[c];
+    if (!ec.active) {
+      continue;
+    }
+    int fd = server.fd(ec.conn);
+    wait.watchRead(fd);
+    if (ec.sent < ec.length) {
+      wait.watchWrite(fd);
+      wait.dueAfter(ec.lastWriteTime, EVENT_STALL_TIMEOUT_MS);
+    } else {
+      wait.dueAfter(ec.lastWriteTime, EVENT_KEEPALIVE_MS);
+    }
+  }
+}
+
+// Takes a token from the client's bucket, or answers 429
+bool admitCommand() {
+  const uint32_t COST = 1000;
+  const uint32_t CAPACITY = CLIENT_COMMAND_BURST * COST;
+  uint32_t address = server.clientAddress();
+  unsigned long now = millis();
+  
+  RateBucket* bucket = nullptr;
+  RateBucket* idlest = &rateBuckets[0];
+  for (int i = 0; i < MAX_RATE_CLIENTS && bucket == nullptr; i++) {
+    if (rateBuckets[i].address == address) {
+      bucket = &rateBuckets[i];
+    } else if (rateBuckets[i].address == 0 ||
+               (idlest->address != 0 && now - rateBuckets[i].lastRefill > now - idlest->lastRefill)) {
+      idlest = &rateBuckets[i];
+    }
+  }
+  if (bucket == nullptr) {
+    bucket = idlest;
+    bucket->address = address;
+    bucket->tokens = CAPACITY;
+    bucket->lastRefill = now;
+  }
+  
+  // Long idle fills the bucket outright (and keeps the product in range)
+  unsigned long elapsed = now - bucket->lastRefill;
+  bucket->lastRefill = now;
+  if (elapsed >= CAPACITY / CLIENT_COMMAND_RATE) {
+    bucket->tokens = CAPACITY;
+  } else {
+    bucket->tokens = min(CAPACITY, bucket->tokens + (uint32_t)elapsed * CLIENT_COMMAND_RATE);
+  }
+  if (bucket->tokens >= COST) {
+    bucket->tokens -= COST;
+    return true;
+  }
+  
+  char retryAfter[12];
+  uint32_t rate = CLIENT_COMMAND_RATE * 1000;
+  snprintf(retryAfter, sizeof(retryAfter), "%lu", (unsigned long)((COST - bucket->tokens + rate - 1) / rate));
+  commandsThrottled++;
+  LOG_DEBUG(LOG_CLIENT_THROTTLED, address & 0xFF, (address >> 8) & 0xFF, (address >> 16) & 0xFF, address >> 24);
+  server.sendHeader("Retry-After", retryAfter);
+  server.send(429, "application/json", "{\"error\":\"Too many requests\"}");
+  return false;
+}
+
+// Parses the POST body into requestDoc. On failure the error response has
+// already been sent and the handler should return.
+// The server has already turned away bodies over MAX_BODY_SIZE.
+bool parseRequestBody() {
+  if (server.bodyLength() == 0) {
+    server.send(400, "application/json", "{\"error\":\"No body\"}");
+    return false;
+  }
+  
+  DeserializationError error = deserializeJson(requestDoc, server.body(), server.bodyLength());
+  if (error.code() == DeserializationError::NoMemory) {
+    server.send(413, "application/json", "{\"error\":\"Body too complex\"}");
+    return false;
+  }
+  if (error) {
+    server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+    return false;
+  }
+  if (!requestDoc.is<JsonObject>()) {
+    server.send(400, "application/json", "{\"error\":\"Expected a JSON object\"}");
+    return false;
+  }
+  return true;
+}
+
+void handleNotFound() {
+  server.send(404, "application/json", "{\"error\":\"Not found\"}");
+}
+
+// Runs a route handler and records its duration and response code. Requests
+// parked for later (long-poll) are counted when they complete.
+void timeRoute(Route route, void (*handler)()) {
+  uint32_t start = ESP.getCycleCount();
+  server.lastStatus = 0;
+  handler();
+  recordLatency(routeLatency[route], start);
+  if (!wakeAnswered) {
+    wakeAnswered = true;
+    recordMicros(wakeLatency, esp_timer_get_time() - wakeTime);
+  }
+  if (server.lastStatus != 0) {
+    countRouteStatus(route, server.lastStatus);
+  }
+}
+
+void countRouteStatus(Route route, int code) {
+  int slot = 0;
+  while (slot < METRIC_STATUS_COUNT && METRIC_STATUS_CODES[slot] != code) {
+    slot++;
+  }
+  routeStatusCounts[route][slot]++;
+}
+
+void recordLatency(LatencyHistogram& histogram, uint32_t startCycles) {
+  recordMicros(histogram, (ESP.getCycleCount() - startCycles) / cyclesPerMicrosecond);
+}
+
+void recordMicros(LatencyHistogram& histogram, uint32_t us) {
+  // Bucket i holds durations up to 16 << i us
+  int bucket = us <= 16 ? 0 : 32 - __builtin_clz(us - 1) - 4;
+  if (bucket >= LATENCY_BUCKETS) {
+    bucket = LATENCY_BUCKETS - 1;
+  }
+  histogram.buckets[bucket]++;
+  histogram.count++;
+  histogram.sumUs += us;
+  if (us > histogram.maxUs) {
+    histogram.maxUs = us;
+  }
+}
+
+// labels is either "" or a list like route="/api/led"
+void writePrometheusHistogram(const char* name, const char* labels, const LatencyHistogram& histogram) {
+  const char* separator = labels[0] ? "," : "";
+  uint32_t cumulative = 0;
+  for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+    cumulative += histogram.buckets[i];
+    server.print("%s_bucket{%s%sle=\"%g\"} %lu\n", name, labels, separator,
+                 (16UL << i) / 1e6, (unsigned long)cumulative);
+  }
+  server.print("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, separator, (unsigned long)histogram.count);
+  char braced[64] = "";
+  if (labels[0]) {
+    snprintf(braced, sizeof(braced), "{%s}", labels);
+  }
+  server.print("%s_sum%s %.6f\n", name, braced, histogram.sumUs / 1e6);
+  server.print("%s_count%s %lu\n", name, braced, (unsigned long)histogram.count);
+}
+
+// Writes one section per call (gauges, each histogram, each route's codes),
+// each of which fits in a single chunk
+bool writePrometheusMetrics(uint32_t& section) {
+  const uint32_t ROUTE_HISTOGRAMS = 5;
+  const uint32_t ROUTE_CODES = ROUTE_HISTOGRAMS + ROUTE_COUNT;
+  const uint32_t LAST_SECTION = ROUTE_CODES + ROUTE_COUNT;
+  uint32_t s = section++;
+  
+  if (s == 0) {
+    server.print("# TYPE led_uptime_seconds gauge\nled_uptime_seconds %lu\n", millis() / 1000);
+    server.print("# HELP led_boot_restore_seconds Time from boot until the saved state was on the outputs\n"
+                 "# TYPE led_boot_restore_seconds gauge\nled_boot_restore_seconds %.6f\n", bootRestoreUs / 1e6);
+    server.print("# HELP led_boot_http_ready_seconds Time from boot until the web server started\n"
+                 "# TYPE led_boot_http_ready_seconds gauge\nled_boot_http_ready_seconds %.6f\n", httpReadyUs / 1e6);
+    server.print("# TYPE led_wifi_connects_total counter\nled_wifi_connects_total %lu\n",
+                 (unsigned long)wifiConnects);
+    server.print("# TYPE led_wifi_rssi_dbm gauge\nled_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+    server.print("# TYPE led_heap_free_bytes gauge\nled_heap_free_bytes %lu\n",
+                 (unsigned long)ESP.getFreeHeap());
+    server.print("# TYPE led_heap_largest_free_block_bytes gauge\nled_heap_largest_free_block_bytes %lu\n",
+                 (unsigned long)ESP.getMaxAllocHeap());
+    server.print("# TYPE led_heap_min_free_bytes gauge\nled_heap_min_free_bytes %lu\n",
+                 (unsigned long)ESP.getMinFreeHeap());
+    server.print("# HELP led_light_sleep Automatic light sleep is on\n"
+                 "# TYPE led_light_sleep gauge\nled_light_sleep %d\n", lightSleepEnabled);
+    server.print("# HELP led_loop_idle_seconds_total Time loop() spent waiting for work\n"
+                 "# TYPE led_loop_idle_seconds_total counter\nled_loop_idle_seconds_total %.6f\n",
+                 loopIdleUs / 1e6);
+    server.print("# TYPE led_loop_wakeups_total counter\n");
+    for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+      server.print("led_loop_wakeups_total{reason=\"%s\"} %lu\n", WAKE_REASON_NAMES[r],
+                   (unsigned long)loopWakeups[r]);
+    }
+    server.print("# TYPE led_engine_wakeups_total counter\nled_engine_wakeups_total %lu\n",
+                 (unsigned long)engineWakeups);
+  } else if (s == 1) {
+    server.print("# HELP led_loop_duration_seconds Time spent in one loop() pass, excluding the idle wait\n"
+                 "# TYPE led_loop_duration_seconds histogram\n");
+    writePrometheusHistogram("led_loop_duration_seconds", "", loopLatency);
+  } else if (s == 2) {
+    server.print("# HELP led_engine_pass_duration_seconds Time spent in one LED engine pass\n"
+                 "# TYPE led_engine_pass_duration_seconds histogram\n");
+    writePrometheusHistogram("led_engine_pass_duration_seconds", "", engineLatency);
+  } else if (s == 3) {
+    server.print("# HELP led_wake_response_seconds From loop() waking for a request to its handler finishing\n"
+                 "# TYPE led_wake_response_seconds histogram\n");
+    writePrometheusHistogram("led_wake_response_seconds", "", wakeLatency);
+  } else if (s == 4) {
+    server.print("# HELP led_show_keyframe_late_seconds How late show keyframes were applied\n"
+                 "# TYPE led_show_keyframe_late_seconds histogram\n");
+    writePrometheusHistogram("led_show_keyframe_late_seconds", "", showLateness);
+  } else if (s < ROUTE_CODES) {
+    int r = s - ROUTE_HISTOGRAMS;
+    if (r == 0) {
+      server.print("# TYPE led_http_request_duration_seconds histogram\n");
+    }
+    char labels[48];
+    snprintf(labels, sizeof(labels), "route=\"%s\"", ROUTE_NAMES[r]);
+    writePrometheusHistogram("led_http_request_duration_seconds", labels, routeLatency[r]);
+  } else if (s < LAST_SECTION) {
+    int r = s - ROUTE_CODES;
+    if (r == 0) {
+      server.print("# TYPE led_http_responses_total counter\n");
+    }
+    for (int code = 0; code <= METRIC_STATUS_COUNT; code++) {
+      if (routeStatusCounts[r][code] == 0) {
+        continue;
+      }
+      if (code < METRIC_STATUS_COUNT) {
+        server.print("led_http_responses_total{route=\"%s\",code=\"%d\"} %lu\n", ROUTE_NAMES[r],
+                     METRIC_STATUS_CODES[code], (unsigned long)routeStatusCounts[r][code]);
+      } else {
+        server.print("led_http_responses_total{route=\"%s\",code=\"other\"} %lu\n", ROUTE_NAMES[r],
+                     (unsigned long)routeStatusCounts[r][code]);
+      }
+    }
+  } else {
+    int eventClientCount = 0;
+    for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+      eventClientCount += eventClients[c].active;
+    }
+    server.print("# TYPE led_event_clients gauge\nled_event_clients %d\n", eventClientCount);
+    server.print("# TYPE led_stream_frames_total counter\n"
+                 "led_stream_frames_total{result=\"applied\"} %lu\n"
+                 "led_stream_frames_total{result=\"dropped\"} %lu\n",
+                 (unsigned long)streamFramesApplied, (unsigned long)streamFramesDropped);
+    server.print("# HELP led_commands_coalesced_total Commands dropped because a newer one replaced them\n"
+                 "# TYPE led_commands_coalesced_total counter\nled_commands_coalesced_total %lu\n",
+                 (unsigned long)commandsCoalesced);
+    server.print("# HELP led_commands_throttled_total Command requests refused with 429\n"
+                 "# TYPE led_commands_throttled_total counter\nled_commands_throttled_total %lu\n",
+                 (unsigned long)commandsThrottled);
+    server.print("# HELP led_log_records_dropped_total Log records lost to a full log ring\n"
+                 "# TYPE led_log_records_dropped_total counter\nled_log_records_dropped_total %lu\n",
+                 (unsigned long)logDropped.load(std::memory_order_relaxed));
+    int fleetPeerCount = 0;
+    for (int p = 0; p < MAX_FLEET_PEERS; p++) {
+      fleetPeerCount += fleetPeers[p].node != 0;
+    }
+    server.print("# TYPE led_fleet_peers gauge\nled_fleet_peers %d\n", fleetPeerCount);
+    server.print("# TYPE led_fleet_synced gauge\nled_fleet_synced %d\n", fleetSynced);
+    server.print("# HELP led_fleet_sync_round_trip_seconds Round trip of the clock sample in use\n"
+                 "# TYPE led_fleet_sync_round_trip_seconds gauge\nled_fleet_sync_round_trip_seconds %.6f\n",
+                 fleetRoundTripUs / 1e6);
+    server.print("# TYPE led_fleet_commands_total counter\n"
+                 "led_fleet_commands_total{result=\"run\"} %lu\n"
+                 "led_fleet_commands_total{result=\"missed\"} %lu\n",
+                 (unsigned long)fleetCommandsRun, (unsigned long)fleetCommandsMissed);
+    server.print("# TYPE led_show_playing gauge\nled_show_playing %d\n", playbackState == PLAYBACK_PLAYING);
+    server.print("# HELP led_show_underruns_total Show blocks used up before the next was read from flash\n"
+                 "# TYPE led_show_underruns_total counter\nled_show_underruns_total %lu\n",
+                 (unsigned long)showUnderruns);
+    return false;
+  }
+  return true;
+}
+
+// Buckets are per bucket here, not cumulative as in the Prometheus form
+void writeJsonHistogram(const LatencyHistogram& histogram) {
+  server.print("{\"count\":%lu,\"sumUs\":%llu,\"maxUs\":%lu,\"buckets\":[",
+               (unsigned long)histogram.count, (unsigned long long)histogram.sumUs,
+               (unsigned long)histogram.maxUs);
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    server.print(i > 0 ? ",%lu" : "%lu", (unsigned long)histogram.buckets[i]);
+  }
+  server.print("]}");
+}
+
+// The totals and the loop and engine histograms first, then one route per call
+bool writeJsonMetrics(uint32_t& section) {
+  uint32_t s = section++;
+  
+  if (s == 0) {
+    server.print("{\"uptimeMs\":%lu,\"bootRestoreUs\":%lld,\"httpReadyUs\":%lld,\"wifiConnects\":%lu,\"heap\":{\"free\":%lu,\"largestBlock\":%lu,\"minFree\":%lu},"
+                 "\"streamFrames\":{\"applied\":%lu,\"dropped\":%lu},\"commands\":{\"coalesced\":%lu,\"throttled\":%lu},\"logDropped\":%lu,"
+                 "\"fleet\":{\"synced\":%s,\"roundTripUs\":%lld,\"run\":%lu,\"missed\":%lu},\"bucketLimitsUs\":[",
+                 millis(), bootRestoreUs, httpReadyUs, (unsigned long)wifiConnects, (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMaxAllocHeap(),
+                 (unsigned long)ESP.getMinFreeHeap(), (unsigned long)streamFramesApplied,
+                 (unsigned long)streamFramesDropped, (unsigned long)commandsCoalesced, (unsigned long)commandsThrottled,
+                 (unsigned long)logDropped.load(std::memory_order_relaxed), fleetSynced ? "true" : "false",
+                 (long long)fleetRoundTripUs, (unsigned long)fleetCommandsRun, (unsigned long)fleetCommandsMissed);
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+      server.print(i > 0 ? ",%lu" : "%lu", 16UL << i);
+    }
+    server.print("],\"lightSleep\":%s,\"idleUs\":%llu,\"wakeups\":{", lightSleepEnabled ? "true" : "false",
+                 (unsigned long long)loopIdleUs);
+    for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+      server.print("\"%s\":%lu,", WAKE_REASON_NAMES[r], (unsigned long)loopWakeups[r]);
+    }
+    server.print("\"engine\":%lu},\"loop\":", (unsigned long)engineWakeups);
+    writeJsonHistogram(loopLatency);
+    server.print(",\"engine\":");
+    writeJsonHistogram(engineLatency);
+    server.print(",\"wake\":");
+    writeJsonHistogram(wakeLatency);
+    server.print(",\"show\":{\"state\":\"%s\",\"underruns\":%lu,\"late\":", PLAYBACK_STATE_NAMES[playbackState],
+                 (unsigned long)showUnderruns);
+    writeJsonHistogram(showLateness);
+    server.print("}");
+    server.print(",\"routes\":[");
+    return true;
+  }
+  
+  int r = s - 1;
+  server.print("%s{\"route\":\"%s\",\"latency\":", r > 0 ? "," : "", ROUTE_NAMES[r]);
+  writeJsonHistogram(routeLatency[r]);
+  server.print(",\"codes\":{");
+  for (int code = 0; code < METRIC_STATUS_COUNT; code++) {
+    server.print("\"%d\":%lu,", METRIC_STATUS_CODES[code], (unsigned long)routeStatusCounts[r][code]);
+  }
+  server.print("\"other\":%lu}}", (unsigned long)routeStatusCounts[r][METRIC_STATUS_COUNT]);
+  if (r == ROUTE_COUNT - 1) {
+    server.print("]}");
+    return false;
+  }
+  return true;
+}
+
+// /api/metrics in Prometheus text format, or ?format=json. The body is
+// generated a section at a time as the client takes it (chunked encoding),
+// so it never has to fit in one buffer.
+void handleMetrics() {
+  bool json = strcmp(server.arg("format"), "json") == 0;
+  server.sendHeader("Cache-Control", "no-cache");
+  server.sendChunked(200, json ? "application/json" : "text/plain; version=0.0.4",
+                     json ? writeJsonMetrics : writePrometheusMetrics);
+}
+
+// GET /api/scenes: {"max":16,"scenes":["evening","party",...]}
+void handleGetScenes() {
+  static char response[MAX_SCENES * (MAX_SCENE_NAME + 3) + 32];
+  size_t size = sizeof(response);
+  size_t n = snprintf(response, size, "{\"max\":%d,\"scenes\":[", MAX_SCENES);
+  bool first = true;
+  for (int s = 0; s < MAX_SCENES; s++) {
+    if (scenes[s].name[0] != '\0') {
+      n += snprintf(response + n, size - n, "%s\"%s\"", first ? "" : ",", scenes[s].name);
+      first = false;
+    }
+  }
+  n += snprintf(response + n, size - n, "]}");
+  server.send(200, "application/json", response, n);
+}
+
+// POST /api/scenes:
+//   {"action":"save","name":"evening"}               capture the current state
+//   {"action":"recall","name":"evening","fade":2000}  apply it in one commit
+//   {"action":"delete","name":"evening"}
+// Scenes hold on/off and brightness, not running effects.
+void handleSceneControl() {
+  if (!admitCommand() || !parseRequestBody()) {
+    return;
+  }
+  
+  const char* action = requestDoc["action"] | "";
+  const char* name = requestDoc["name"] | "";
+  long fadeMs = requestDoc["fade"] | 0;
+  
+  size_t nameLength = strlen(name);
+  bool nameValid = nameLength > 0 && nameLength <= MAX_SCENE_NAME;
+  for (size_t i = 0; i < nameLength; i++) {
+    if (name[i] < 0x20 || name[i] == '"' || name[i] == '\\') {
+      nameValid = false;
+    }
+  }
+  if (!nameValid) {
+    server.send(400, "application/json", "{\"error\":\"Invalid scene name\"}");
+    return;
+  }
+  
+  int slot = findScene(name);
+  
+  if (strcmp(action, "save") == 0) {
+    if (slot < 0) {
+      slot = findScene("");
+    }
+    if (slot < 0) {
+      server.send(507, "application/json", "{\"error\":\"Scene store full\"}");
+      return;
+    }
+    syncSnapshot();
+    Scene& scene = scenes[slot];
+    strcpy(scene.name, name);
+    for (int i = 0; i < NUM_LEDS; i++) {
+      const LEDStatus& status = statusSnapshot.leds[i];
+      scene.levels[i] = status.isOn ? max<uint8_t>(status.brightness, 1) : 0;
+    }
+    dirtyScenes |= 1UL << slot;
+    LOG_INFO(LOG_SCENE_SAVED, name);
+  } else if (strcmp(action, "recall") == 0) {
+    if (slot < 0) {
+      server.send(404, "application/json", "{\"error\":\"No such scene\"}");
+      return;
+    }
+    if (fadeMs < 0 || fadeMs > MAX_FADE_MS) {
+      server.send(400, "application/json", "{\"error\":\"Invalid fade\"}");
+      return;
+    }
+    if (streamHolds(ALL_LEDS)) {
+      server.send(409, "application/json", "{\"error\":\"Channel is streaming\"}");
+      return;
+    }
+    if (!flushCommands() || commandQueueSpace() == 0) {
+      server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+      return;
+    }
+    LEDFrame& frame = nextFrame(sceneFrames);
+    frame.first = 0;
+    frame.count = NUM_LEDS;
+    frame.fadeMs = fadeMs;
+    memcpy(frame.levels, scenes[slot].levels, NUM_LEDS);
+    publishFrame(sceneFrames);
+    postLEDCommand(ACTION_SCENE, ALL_LEDS, 0);
+    LOG_INFO(LOG_SCENE_RECALLED, name);
+  } else if (strcmp(action, "delete") == 0) {
+    if (slot < 0) {
+      server.send(404, "application/json", "{\"error\":\"No such scene\"}");
+      return;
+    }
+    scenes[slot].name[0] = '\0';
+    dirtyScenes |= 1UL << slot;
+  } else {
+    server.send(400, "application/json", "{\"error\":\"Invalid action\"}");
+    return;
+  }
+  
+  server.send(200, "application/json", "{\"success\":true}");
+}
+
+// Slot holding the named scene, or -1. An empty name finds a free slot.
+int findScene(const char* name) {
+  for (int s = 0; s < MAX_SCENES; s++) {
+    if (strcmp(scenes[s].name, name) == 0) {
+      return s;
+    }
+  }
+  return -1;
+}
+
+// Show names become file names, so they are kept to [A-Za-z0-9_-]
+bool showNameValid(const char* name) {
+  size_t length = strlen(name);
+  if (length == 0 || length > MAX_SHOW_NAME) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char)name[i]) && name[i] != '-' && name[i] != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+void showPath(char* path, size_t size, const char* name, const char* extension) {
+  snprintf(path, size, "%s/%s.%s", SHOW_DIRECTORY, name, extension);
+}
+
+// GET /api/shows:
+//   {"shows":[{"name":"finale","keyframes":412,"durationMs":180000},...],"upload":null}
+// "upload" is {"name":...,"keyframes":...} while one is in progress.
+void handleGetShows() {
+  if (!showsReady) {
+    server.send(503, "application/json", "{\"error\":\"No filesystem\"}");
+    return;
+  }
+  static char response[MAX_LISTED_SHOWS * (MAX_SHOW_NAME + 56) + MAX_SHOW_NAME + 80];
+  size_t size = sizeof(response);
+  size_t n = snprintf(response, size, "{\"shows\":[");
+  int listed = 0;
+  File directory = LittleFS.open(SHOW_DIRECTORY);
+  for (File file = directory.openNextFile(); file && listed < MAX_LISTED_SHOWS; file = directory.openNextFile()) {
+    const char* name = file.name();
+    const char* extension = strrchr(name, '.');
+    ShowHeader header;
+    if (extension == nullptr || strcmp(extension, ".show") != 0 || extension - name > (int)MAX_SHOW_NAME ||
+        file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != SHOW_MAGIC) {
+      continue;
+    }
+    n += snprintf(response + n, size - n, "%s{\"name\":\"%.*s\",\"keyframes\":%lu,\"durationMs\":%lu}",
+                  listed > 0 ? "," : "", (int)(extension - name), name, (unsigned long)header.keyframes,
+                  (unsigned long)header.durationMs);
+    listed++;
+  }
+  if (uploadFile) {
+    n += snprintf(response + n, size - n, "],\"upload\":{\"name\":\"%s\",\"keyframes\":%lu}}", uploadName,
+                  (unsigned long)uploadKeyframes);
+  } else {
+    n += snprintf(response + n, size - n, "],\"upload\":null}");
+  }
+  server.send(200, "application/json", response, n);
+}
+
+// POST /api/shows uploads a cue list in pieces:
+//   {"action":"create","name":"finale"}
+//   {"action":"append","cues":[{"t":0,"level":255,"fade":500},{"t":1500,"leds":[0,1,2,5],"level":0}]}
+//   {"action":"finish","duration":180000}
+//   {"action":"delete","name":"finale"}
+// A cue is for "led", "leds", or "first" and "count" ("first" alone is one
+// channel, "count" needs "first"), and otherwise for every channel. "t" is
+// ms from the start and never goes back. The length of the show defaults to
+// the end of its last fade.
+void handleShowControl() {
+  if (!admitCommand() || !parseRequestBody()) {
+    return;
+  }
+  if (!showsReady) {
+    server.send(503, "application/json", "{\"error\":\"No filesystem\"}");
+    return;
+  }
+  
+  const char* action = requestDoc["action"] | "";
+  char path[48];
+  char response[96];
+  
+  if (strcmp(action, "create") == 0 || strcmp(action, "delete") == 0) {
+    const char* name = requestDoc["name"] | "";
+    if (!showNameValid(name)) {
+      server.send(400, "application/json", "{\"error\":\"Invalid show name\"}");
+      return;
+    }
+    if (strcmp(action, "create") == 0) {
+      // An upload never finished is dropped with its file
+      if (uploadFile) {
+        uploadFile.close();
+        showPath(path, sizeof(path), uploadName, "tmp");
+        LittleFS.remove(path);
+      }
+      showPath(path, sizeof(path), name, "tmp");
+      uploadFile = LittleFS.open(path, "w");
+      // The header is written for real by "finish"
+      ShowHeader header = {};
+      if (!uploadFile || uploadFile.write((const uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+        uploadFile.close();
+        server.send(507, "application/json", "{\"error\":\"Cannot write show\"}");
+        return;
+      }
+      strcpy(uploadName, name);
+      uploadKeyframes = 0;
+      uploadLastMs = 0;
+      uploadEndMs = 0;
+    } else {
+      if (playbackState != PLAYBACK_STOPPED && strcmp(playbackName, name) == 0) {
+        server.send(409, "application/json", "{\"error\":\"Show is playing\"}");
+        return;
+      }
+      showPath(path, sizeof(path), name, "show");
+      if (!LittleFS.remove(path)) {
+        server.send(404, "application/json", "{\"error\":\"No such show\"}");
+        return;
+      }
+    }
+    server.send(200, "application/json", "{\"success\":true}");
+  } else if (strcmp(action, "append") == 0) {
+    if (!uploadFile) {
+      server.send(409, "application/json", "{\"error\":\"No upload in progress\"}");
+      return;
+    }
+    JsonArray cues = requestDoc["cues"];
+    if (cues.isNull() || cues.size() == 0) {
+      server.send(400, "application/json", "{\"error\":\"Expected cues\"}");
+      return;
+    }
+    // All checked first, so a bad cue leaves the upload as it was
+    int count = cues.size();
+    uint32_t lastMs = uploadLastMs;
+    for (int c = 0; c < count; c++) {
+      const char* error = validateCue(cues[c], lastMs);
+      if (error != nullptr) {
+        snprintf(response, sizeof(response), "{\"error\":\"Cue %d: %s\"}", c, error);
+        server.send(400, "application/json", response);
+        return;
+      }
+      lastMs = cues[c]["t"] | 0L;
+    }
+    for (int c = 0; c < count; c++) {
+      if (!writeCue(cues[c])) {
+        uploadFile.close();
+        showPath(path, sizeof(path), uploadName, "tmp");
+        LittleFS.remove(path);
+        server.send(507, "application/json", "{\"error\":\"Show storage full\"}");
+        return;
+      }
+    }
+    int n = snprintf(response, sizeof(response), "{\"success\":true,\"keyframes\":%lu}",
+                     (unsigned long)uploadKeyframes);
+    server.send(200, "application/json", response, n);
+  } else if (strcmp(action, "finish") == 0) {
+    if (!uploadFile) {
+      server.send(409, "application/json", "{\"error\":\"No upload in progress\"}");
+      return;
+    }
+    if (playbackState != PLAYBACK_STOPPED && strcmp(playbackName, uploadName) == 0) {
+      server.send(409, "application/json", "{\"error\":\"Show is playing\"}");
+      return;
+    }
+    uint32_t durationMs = uploadEndMs;
+    if (!requestDoc["duration"].isNull()) {
+      long duration = requestDoc["duration"] | -1L;
+      if (duration < (long)uploadLastMs || duration > (long)MAX_SHOW_MS) {
+        server.send(400, "application/json", "{\"error\":\"Invalid duration\"}");
+        return;
+      }
+      durationMs = duration;
+    }
+    ShowHeader header = {SHOW_MAGIC, NUM_LEDS, 0, uploadKeyframes, durationMs};
+    bool written = uploadFile.seek(0) &&
+                   uploadFile.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    uploadFile.close();
+    char showFile[48];
+    showPath(path, sizeof(path), uploadName, "tmp");
+    showPath(showFile, sizeof(showFile), uploadName, "show");
+    if (written) {
+      LittleFS.remove(showFile);
+      written = LittleFS.rename(path, showFile);
+    }
+    if (!written) {
+      LittleFS.remove(path);
+      server.send(507, "application/json", "{\"error\":\"Cannot write show\"}");
+      return;
+    }
+    LOG_INFO(LOG_SHOW_STORED, uploadName);
+    int n = snprintf(response, sizeof(response), "{\"success\":true,\"keyframes\":%lu,\"durationMs\":%lu}",
+                     (unsigned long)uploadKeyframes, (unsigned long)durationMs);
+    server.send(200, "application/json", response, n);
+  } else {
+    server.send(400, "application/json", "{\"error\":\"Invalid action\"}");
+  }
+}
+
+// Error text for a bad cue, or nullptr
+const char* validateCue(JsonVariant cue, uint32_t lastMs) {
+  long timeMs = cue["t"] | -1L;
+  if (timeMs < 0 || timeMs > (long)MAX_SHOW_MS) {
+    return "Invalid time";
+  }
+  if (timeMs < (long)lastMs) {
+    return "Out of time order";
+  }
+  int level = cue["level"] | -1;
+  if (level < 0 || level > 255) {
+    return "Invalid level";
+  }
+  long fadeMs = cue["fade"] | 0L;
+  if (fadeMs < 0 || fadeMs > MAX_FADE_MS) {
+    return "Invalid fade";
+  }
+  
+  if (!cue["led"].isNull()) {
+    int led = cue["led"] | -1;
+    if (led < 0 || led >= NUM_LEDS) {
+      return "Invalid led";
+    }
+  } else if (!cue["leds"].isNull()) {
+    JsonArray leds = cue["leds"];
+    int count = leds.size();
+    if (count == 0) {
+      return "Invalid leds";
+    }
+    for (int i = 0; i < count; i++) {
+      int led = leds[i] | -1;
+      if (led < 0 || led >= NUM_LEDS) {
+        return "Invalid leds";
+      }
+    }
+  } else if (!cue["first"].isNull() || !cue["count"].isNull()) {
+    if (cue["first"].isNull()) {
+      return "Count without first";
+    }
+    int first = cue["first"] | -1;
+    int count = cue["count"] | 1;
+    if (first < 0 || count < 1 || count > NUM_LEDS - first) {
+      return "Invalid range";
+    }
+  }
+  return nullptr;
+}
+
+// Compiles a checked cue into keyframes, one per run of adjacent channels
+bool writeCue(JsonVariant cue) {
+  uint32_t timeMs = cue["t"] | 0L;
+  uint8_t level = cue["level"] | 0;
+  uint32_t fadeMs = cue["fade"] | 0L;
+  uploadLastMs = timeMs;
+  uploadEndMs = max(uploadEndMs, timeMs + fadeMs);
+  
+  if (!cue["led"].isNull()) {
+    return writeKeyframe(timeMs, cue["led"] | 0, 1, level, fadeMs);
+  }
+  if (!cue["leds"].isNull()) {
+    JsonArray leds = cue["leds"];
+    int count = leds.size();
+    int first = leds[0] | 0;
+    int run = 1;
+    for (int i = 1; i < count; i++) {
+      int led = leds[i] | 0;
+      if (led == first + run) {
+        run++;
+        continue;
+      }
+      if (!writeKeyframe(timeMs, first, run, level, fadeMs)) {
+        return false;
+      }
+      first = led;
+      run = 1;
+    }
+    return writeKeyframe(timeMs, first, run, level, fadeMs);
+  }
+  if (!cue["first"].isNull() || !cue["count"].isNull()) {
+    // validateCue() turned away a count without a first
+    if (cue["first"].isNull()) {
+      return false;
+    }
+    return writeKeyframe(timeMs, cue["first"] | 0, cue["count"] | 1, level, fadeMs);
+  }
+  return writeKeyframe(timeMs, 0, NUM_LEDS, level, fadeMs);
+}
+
+bool writeKeyframe(uint32_t timeMs, int first, int count, uint8_t level, uint32_t fadeMs) {
+  ShowKeyframe keyframe = {};
+  keyframe.timeMs = timeMs;
+  keyframe.first = first;
+  keyframe.count = count;
+  keyframe.level = level;
+  keyframe.fadeMs = fadeMs;
+  if (uploadFile.write((const uint8_t*)&keyframe, sizeof(keyframe)) != sizeof(keyframe)) {
+    return false;
+  }
+  uploadKeyframes++;
+  return true;
+}
+
+// GET /api/playback:
+//   {"state":"playing","show":"finale","positionMs":61250,"durationMs":180000,"loop":true}
+void handleGetPlayback() {
+  char response[160];
+  int n;
+  if (playbackState == PLAYBACK_STOPPED) {
+    n = snprintf(response, sizeof(response), "{\"state\":\"stopped\"}");
+  } else {
+    n = snprintf(response, sizeof(response),
+                 "{\"state\":\"%s\",\"show\":\"%s\",\"positionMs\":%lu,\"durationMs\":%lu,\"loop\":%s}",
+                 PLAYBACK_STATE_NAMES[playbackState], playbackName, (unsigned long)playbackPosition(),
+                 (unsigned long)playbackHeader.durationMs, playbackLoop ? "true" : "false");
+  }
+  server.send(200, "application/json", response, n);
+}
+
+// POST /api/playback:
+//   {"action":"play","name":"finale","loop":true,"at":0}
+//   {"action":"pause"}
+//   {"action":"resume"}
+//   {"action":"seek","at":60000}
+//   {"action":"stop"}
+// Pausing holds every fade where it is; a seek while paused moves where
+// resume picks up. Stopping leaves the channels as they are. A play, resume
+// or seek far into a long show answers "seeking" until the replay is done.
+void handlePlaybackControl() {
+  if (!admitCommand() || !parseRequestBody()) {
+    return;
+  }
+  
+  const char* action = requestDoc["action"] | "";
+  long at = requestDoc["at"] | 0L;
+  bool started = true;
+  
+  if (strcmp(action, "play") == 0) {
+    const char* name = requestDoc["name"] | "";
+    bool loop = requestDoc["loop"] | false;
+    if (!showsReady) {
+      server.send(503, "application/json", "{\"error\":\"No filesystem\"}");
+      return;
+    }
+    if (!showNameValid(name)) {
+      server.send(400, "application/json", "{\"error\":\"Invalid show name\"}");
+      return;
+    }
+    char path[48];
+    showPath(path, sizeof(path), name, "show");
+    File file = LittleFS.open(path, "r");
+    ShowHeader header;
+    if (!file || file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != SHOW_MAGIC) {
+      server.send(404, "application/json", "{\"error\":\"No such show\"}");
+      return;
+    }
+    if (header.channels != NUM_LEDS) {
+      server.send(409, "application/json", "{\"error\":\"Show is for a different channel count\"}");
+      return;
+    }
+    if (header.keyframes == 0 || (loop && header.durationMs < MIN_LOOP_SHOW_MS)) {
+      server.send(400, "application/json", "{\"error\":\"Show too short\"}");
+      return;
+    }
+    if (at < 0 || (uint32_t)at > header.durationMs) {
+      server.send(400, "application/json", "{\"error\":\"Invalid position\"}");
+      return;
+    }
+    if (streamHolds(ALL_LEDS)) {
+      server.send(409, "application/json", "{\"error\":\"Channel is streaming\"}");
+      return;
+    }
+    if (!flushCommands() || commandQueueSpace() == 0) {
+      server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+      return;
+    }
+    stopPlayback();
+    playbackFile = file;
+    playbackHeader = header;
+    playbackLoop = loop;
+    strcpy(playbackName, name);
+    started = startPlayback(at);
+    if (started) {
+      LOG_INFO(LOG_SHOW_PLAYING, playbackName);
+    }
+  } else if (strcmp(action, "pause") == 0) {
+    if (playbackState != PLAYBACK_PLAYING && playbackState != PLAYBACK_SEEKING) {
+      server.send(409, "application/json", "{\"error\":\"Not playing\"}");
+      return;
+    }
+    if (!queueShowCommand(SHOW_PAUSE, 0, 0)) {
+      server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+      return;
+    }
+    playbackPausedMs = playbackPosition();
+    playbackState = PLAYBACK_PAUSED;
+  } else if (strcmp(action, "resume") == 0) {
+    if (playbackState != PLAYBACK_PAUSED) {
+      server.send(409, "application/json", "{\"error\":\"Not paused\"}");
+      return;
+    }
+    started = startPlayback(playbackPausedMs);
+  } else if (strcmp(action, "seek") == 0) {
+    if (playbackState == PLAYBACK_STOPPED) {
+      server.send(409, "application/json", "{\"error\":\"Not playing\"}");
+      return;
+    }
+    if (at < 0 || (uint32_t)at > playbackHeader.durationMs) {
+      server.send(400, "application/json", "{\"error\":\"Invalid position\"}");
+      return;
+    }
+    if (playbackState == PLAYBACK_PAUSED) {
+      playbackPausedMs = at;
+    } else {
+      started = startPlayback(at);
+    }
+  } else if (strcmp(action, "stop") == 0) {
+    if (playbackState != PLAYBACK_STOPPED && !queueShowCommand(SHOW_STOP, 0, 0)) {
+      server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+      return;
+    }
+    stopPlayback();
+  } else {
+    server.send(400, "application/json", "{\"error\":\"Invalid action\"}");
+    return;
+  }
+  
+  if (!started) {
+    server.send(503, "application/json", "{\"error\":\"LED engine busy\"}");
+    return;
+  }
+  handleGetPlayback();
+}
+
+// Where the show is, in ms from its start
+uint32_t playbackPosition() {
+  if (playbackState == PLAYBACK_PAUSED) {
+    return playbackPausedMs;
+  }
+  if (playbackState == PLAYBACK_SEEKING) {
+    return playbackSeekAt;
+  }
+  int64_t position = (esp_timer_get_time() - playbackStartUs) / 1000;
+  if (playbackLoop) {
+    return position % playbackHeader.durationMs;
+  }
+  return min<int64_t>(position, playbackHeader.durationMs);
+}
+
+// Plays from at ms: stops the engine's show and starts the replay that
+// works out the look there. pumpShow() carries the replay on and, once it
+// has reached at, has the engine start its clock and keeps it fed. False
+// means the engine queue was full and nothing changed.
+bool startPlayback(uint32_t at) {
+  if (!flushCommands() || commandQueueSpace() == 0) {
+    return false;
+  }
+  queueShowCommand(SHOW_STOP, 0, 0);
+  seekTouched.clear();
+  playbackSeekAt = at;
+  playbackNextKeyframe = 0;
+  playbackState = PLAYBACK_SEEKING;
+  if (!playbackFile.seek(sizeof(ShowHeader))) {
+    LOG_WARN(LOG_SHOW_READ_FAILED, playbackName);
+    stopPlayback();
+    return true;
+  }
+  pumpShow();
+  return true;
+}
+
+void stopPlayback() {
+  playbackState = PLAYBACK_STOPPED;
+  playbackFile.close();
+}
+
+// Replays up to SHOW_REPLAY_STEP more keyframes before playbackSeekAt into
+// seekRamps. Once it gets there it leaves the file at the first keyframe
+// from then on and starts the show; false while there is more to replay, or
+// the engine queue has no room for the start.
+bool replayShow() {
+  static ShowKeyframe chunk[SHOW_READ_CHUNK];
+  if (!flushCommands() || commandQueueSpace() == 0) {
+    return false;
+  }
+  uint32_t at = playbackSeekAt;
+  uint32_t index = playbackNextKeyframe;
+  uint32_t stepEnd = min<uint32_t>(index + SHOW_REPLAY_STEP, playbackHeader.keyframes);
+  bool reached = index == playbackHeader.keyframes;
+  while (index < stepEnd && !reached) {
+    uint32_t n = min<uint32_t>(SHOW_READ_CHUNK, stepEnd - index);
+    if (playbackFile.read((uint8_t*)chunk, n * sizeof(ShowKeyframe)) != n * sizeof(ShowKeyframe)) {
+      LOG_WARN(LOG_SHOW_READ_FAILED, playbackName);
+      stopPlayback();
+      return false;
+    }
+    for (uint32_t k = 0; k < n; k++) {
+      const ShowKeyframe& keyframe = chunk[k];
+      if (keyframe.timeMs >= at) {
+        reached = true;
+        break;
+      }
+      int end = min<int>(keyframe.first + keyframe.count, NUM_LEDS);
+      for (int i = keyframe.first; i < end; i++) {
+        // A channel's first ramp starts from wherever it was before the show
+        const LEDStatus& status = statusSnapshot.leds[i];
+        uint8_t from = seekTouched.test(i) ? seekLevelAt(i, keyframe.timeMs) :
+                       (status.isOn ? status.brightness : 0);
+        seekRamps[i] = {keyframe.timeMs, keyframe.fadeMs, from, (uint8_t)keyframe.level};
+        seekTouched.set(i);
+      }
+      index++;
+    }
+  }
+  playbackNextKeyframe = index;
+  if (!reached && index < playbackHeader.keyframes) {
+    return false;
+  }
+  if (!playbackFile.seek(sizeof(ShowHeader) + index * sizeof(ShowKeyframe))) {
+    LOG_WARN(LOG_SHOW_READ_FAILED, playbackName);
+    stopPlayback();
+    return false;
+  }
+  
+  playbackGeneration = playbackGeneration + 1 == 0 ? 1 : playbackGeneration + 1;
+  queueShowCommand(SHOW_START, playbackGeneration, at);
+  playbackStartUs = esp_timer_get_time() - at * 1000LL;
+  playbackState = PLAYBACK_PLAYING;
+  playbackBaseMs = 0;
+  playbackWriteBlock = 0;
+  playbackReadDone = false;
+  playbackPreamble = 1;
+  playbackPreambleChannel = 0;
+  playbackPreambleAt = at;
+  return true;
+}
+
+// A channel's level at t ms into the replay
+uint8_t seekLevelAt(int ledNum, uint32_t t) {
+  const SeekRamp& ramp = seekRamps[ledNum];
+  if (t >= ramp.startMs + ramp.fadeMs) {
+    return ramp.to;
+  }
+  return ramp.from + ((int32_t)ramp.to - ramp.from) * (int32_t)(t - ramp.startMs) / (int32_t)ramp.fadeMs;
+}
+
+// The channel's keyframe in the current preamble phase, if it has one
+bool preambleKeyframe(int ledNum, uint8_t& level, uint32_t& fadeMs) {
+  if (!seekTouched.test(ledNum)) {
+    return false;
+  }
+  const SeekRamp& ramp = seekRamps[ledNum];
+  uint32_t at = playbackPreambleAt;
+  if (playbackPreamble == 1) {
+    level = seekLevelAt(ledNum, at);
+    fadeMs = 0;
+    return true;
+  }
+  if (ramp.startMs + ramp.fadeMs <= at) {
+    return false;
+  }
+  level = ramp.to;
+  fadeMs = ramp.startMs + ramp.fadeMs - at;
+  return true;
+}
+
+// After a seek the show starts with keyframes that set the look at the seek
+// position: phase 1 puts every channel the show has touched at its level
+// there, phase 2 restarts the fades still running. Neighbouring channels
+// that match share a keyframe.
+void fillShowPreamble(ShowBlock& block) {
+  while (playbackPreamble != 0 && block.count < SHOW_BLOCK_KEYFRAMES) {
+    int first = playbackPreambleChannel;
+    if (first >= NUM_LEDS) {
+      playbackPreamble = playbackPreamble == 1 ? 2 : 0;
+      playbackPreambleChannel = 0;
+      continue;
+    }
+    uint8_t level;
+    uint32_t fadeMs;
+    if (!preambleKeyframe(first, level, fadeMs)) {
+      playbackPreambleChannel++;
+      continue;
+    }
+    int count = 1;
+    uint8_t nextLevel;
+    uint32_t nextFadeMs;
+    while (first + count < NUM_LEDS && preambleKeyframe(first + count, nextLevel, nextFadeMs) &&
+           nextLevel == level && nextFadeMs == fadeMs) {
+      count++;
+    }
+    ShowKeyframe& keyframe = block.keyframes[block.count++];
+    keyframe.timeMs = playbackPreambleAt;
+    keyframe.first = first;
+    keyframe.count = count;
+    keyframe.level = level;
+    keyframe.fadeMs = fadeMs;
+    playbackPreambleChannel = first + count;
+  }
+}
+
+// Carries on a replay, keeps both blocks filled ahead of the engine, and
+// notices the end
+void pumpShow() {
+  if (playbackState == PLAYBACK_SEEKING && !replayShow()) {
+    return;
+  }
+  if (playbackState == PLAYBACK_PLAYING &&
+      showEndedGeneration.load(std::memory_order_acquire) == playbackGeneration) {
+    stopPlayback();
+    LOG_INFO(LOG_SHOW_ENDED, playbackName);
+    return;
+  }
+  
+  while (playbackState == PLAYBACK_PLAYING && !playbackReadDone) {
+    ShowBlock& block = showBlocks[playbackWriteBlock];
+    if (block.full.load(std::memory_order_acquire)) {
+      return;
+    }
+    block.count = 0;
+    block.last = false;
+    block.generation = playbackGeneration;
+    block.baseMs = playbackBaseMs;
+    fillShowPreamble(block);
+    
+    if (playbackPreamble == 0) {
+      uint32_t n = min<uint32_t>(SHOW_BLOCK_KEYFRAMES - block.count,
+                                 playbackHeader.keyframes - playbackNextKeyframe);
+      size_t bytes = n * sizeof(ShowKeyframe);
+      if (playbackFile.read((uint8_t*)(block.keyframes + block.count), bytes) != bytes) {
+        LOG_WARN(LOG_SHOW_READ_FAILED, playbackName);
+        n = 0;
+        playbackNextKeyframe = playbackHeader.keyframes;
+        playbackLoop = false;
+      }
+      block.count += n;
+      playbackNextKeyframe += n;
+      
+      // A block ends at the end of the file, so all of it has one base
+      if (playbackNextKeyframe == playbackHeader.keyframes) {
+        if (playbackLoop && playbackFile.seek(sizeof(ShowHeader))) {
+          playbackBaseMs += playbackHeader.durationMs;
+          playbackNextKeyframe = 0;
+        } else {
+          block.last = true;
+          block.endMs = playbackHeader.durationMs;
+          playbackReadDone = true;
+        }
+      }
+    }
+    
+    block.full.store(true, std::memory_order_release);
+    playbackWriteBlock ^= 1;
+    wakeLEDEngine();
+  }
+}
+
+// Show transport goes to the engine behind any buffered commands
+bool queueShowCommand(ShowOp op, uint32_t generation, uint32_t positionMs) {
+  LEDCommand cmd = {};
+  cmd.action = ACTION_SHOW;
+  cmd.flags = op;
+  cmd.ledNum = ALL_LEDS;
+  cmd.value = generation;
+  cmd.fadeMs = positionMs;
+  if (!flushCommands() || !pushCommand(cmd)) {
+    return false;
+  }
+  wakeLEDEngine();
+  return true;
+}
+
+// Runs in setup() before the engine starts, so it writes the channel store
+// directly
+void restoreState() {
+  static SavedState saved;
+  if (preferences.getBytes("state", &saved, sizeof(saved)) != sizeof(saved) ||
+      saved.magic != PERSIST_MAGIC || saved.count != NUM_LEDS) {
+    return;
+  }
+  for (int i = 0; i < NUM_LEDS; i++) {
+    channels.isOn[i] = saved.isOn[i / 8] & (1 << (i % 8));
+    channels.brightness[i] = saved.brightness[i];
+    channels.level[i] = (uint32_t)targetLevel(i) << 16;
+    outputDuty[i] = gammaDuty(channels.level[i] >> 16);
+  }
+}
+
+void loadScenes() {
+  char key[8];
+  for (int s = 0; s < MAX_SCENES; s++) {
+    snprintf(key, sizeof(key), "scene%d", s);
+    if (preferences.getBytes(key, &scenes[s], sizeof(Scene)) != sizeof(Scene)) {
+      scenes[s].name[0] = '\0';
+    }
+  }
+}
+
+// Writes whatever has changed and settled. Called from loop().
+void pumpPersistence() {
+  unsigned long now = millis();
+  
+  while (dirtyScenes != 0) {
+    int s = __builtin_ctz(dirtyScenes);
+    dirtyScenes &= ~(1UL << s);
+    char key[8];
+    snprintf(key, sizeof(key), "scene%d", s);
+    if (scenes[s].name[0] == '\0') {
+      preferences.remove(key);
+    } else {
+      preferences.putBytes(key, &scenes[s], sizeof(Scene));
+    }
+  }
+  
+  if (persistedVersion == statusSnapshot.version || now - stateChangeTime < PERSIST_QUIET_MS ||
+      now - lastPersistTime < PERSIST_MIN_INTERVAL_MS) {
+    return;
+  }
+  
+  static SavedState saved;
+  memset(&saved, 0, sizeof(saved));
+  saved.magic = PERSIST_MAGIC;
+  saved.count = NUM_LEDS;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    if (statusSnapshot.leds[i].isOn) {
+      saved.isOn[i / 8] |= 1 << (i % 8);
+    }
+    saved.brightness[i] = statusSnapshot.leds[i].brightness;
+  }
+  preferences.putBytes("state", &saved, sizeof(saved));
+  persistedVersion = statusSnapshot.version;
+  lastPersistTime = now;
+}
+
+// An unsaved state is due once it has settled and the last write is far
+// enough back, whichever comes later
+void addPersistenceWait(LoopWait& wait) {
+  if (persistedVersion == statusSnapshot.version) {
+    return;
+  }
+  unsigned long quiet = wait.now - stateChangeTime;
+  unsigned long spacing = wait.now - lastPersistTime;
+  unsigned long quietLeft = quiet >= PERSIST_QUIET_MS ? 0 : PERSIST_QUIET_MS - quiet;
+  unsigned long spacingLeft = spacing >= PERSIST_MIN_INTERVAL_MS ? 0 : PERSIST_MIN_INTERVAL_MS - spacing;
+  wait.dueIn(max(quietLeft, spacingLeft) * 1000LL);
+}
+
+LEDAction parseLEDAction(const char* name) {
+  if (strcmp(name, "on") == 0) return ACTION_ON;
+  if (strcmp(name, "off") == 0) return ACTION_OFF;
+  if (strcmp(name, "blink") == 0) return ACTION_BLINK;
+  if (strcmp(name, "brightness") == 0) return ACTION_BRIGHTNESS;
+  if (strcmp(name, "pulse") == 0) return ACTION_PULSE;
+  if (strcmp(name, "timer") == 0) return ACTION_TIMER;
+  return ACTION_INVALID;
+}
+
+// Returns nullptr if the command can be applied, otherwise the error message
+const char* validateLEDCommand(int ledNum, LEDAction action, long value, long fadeMs) {
+  if (ledNum < 0 || ledNum >= NUM_LEDS) {
+    return "Invalid LED index";
+  }
+  if (fadeMs < 0 || fadeMs > MAX_FADE_MS) {
+    return "Invalid fade";
+  }
+  switch (action) {
+    case ACTION_ON:
+    case ACTION_OFF:
+      return nullptr;
+    case ACTION_BLINK:
+      return value > 0 ? nullptr : "Invalid blink interval";
+    case ACTION_BRIGHTNESS:
+      return value >= 0 && value <= 255 ? nullptr : "Invalid brightness";
+    case ACTION_PULSE:
+    case ACTION_TIMER:
+      return value > 0 ? nullptr : "Invalid duration";
+    default:
+      return "Invalid action";
+  }
+}
+
+// Logging: producers (any task)
+LogRecord* claimLogRecord(uint8_t level, LogEvent event, uint32_t& position) {
+  position = logHead.load(std::memory_order_relaxed);
+  for (;;) {
+    LogSlot& slot = logRing[position % LOG_RING_SIZE];
+    int32_t lag = slot.sequence.load(std::memory_order_acquire) - position;
+    if (lag < 0) {
+      // The log task hasn't read this slot since last time round
+      logDropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    if (lag == 0 && logHead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+      slot.record.timeMs = millis();
+      slot.record.level = level;
+      slot.record.event = event;
+      return &slot.record;
+    }
+    if (lag > 0) {
+      // Another producer took it first
+      position = logHead.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void logEvent(uint8_t level, LogEvent event, int32_t a, int32_t b, int32_t c, int32_t d) {
+  uint32_t position;
+  LogRecord* record = claimLogRecord(level, event, position);
+  if (record == nullptr) {
+    return;
+  }
+  record->numbers[0] = a;
+  record->numbers[1] = b;
+  record->numbers[2] = c;
+  record->numbers[3] = d;
+  logRing[position % LOG_RING_SIZE].sequence.store(position + 1, std::memory_order_release);
+  xTaskNotifyGive(logTaskHandle);
+}
+
+void logEvent(uint8_t level, LogEvent event, const char* text) {
+  uint32_t position;
+  LogRecord* record = claimLogRecord(level, event, position);
+  if (record == nullptr) {
+    return;
+  }
+  size_t i = 0;
+  for (; i < LOG_TEXT_SIZE - 1 && text[i] != '\0'; i++) {
+    record->text[i] = text[i];
+  }
+  record->text[i] = '\0';
+  logRing[position % LOG_RING_SIZE].sequence.store(position + 1, std::memory_order_release);
+  xTaskNotifyGive(logTaskHandle);
+}
+
+// Logging: the log task, the only consumer
+bool popLogRecord(LogRecord& record) {
+  LogSlot& slot = logRing[logTail % LOG_RING_SIZE];
+  if (slot.sequence.load(std::memory_order_acquire) != logTail + 1) {
+    return false;
+  }
+  record = slot.record;
+  slot.sequence.store(logTail + LOG_RING_SIZE, std::memory_order_release);
+  logTail++;
+  return true;
+}
+
+int formatLogRecord(char* line, size_t size, const LogRecord& record) {
+  static const char levelNames[] = "DIWE";
+  static const char* const actionNames[] = {"ON", "OFF", "blinking", "brightness", "pulse", "timer"};
+  const LogFormat& format = LOG_FORMATS[record.event];
+  const int32_t* v = record.numbers;
+  
+  int n = snprintf(line, size, "%lu.%03lu %c ", (unsigned long)(record.timeMs / 1000),
+                   (unsigned long)(record.timeMs % 1000), levelNames[record.level]);
+  switch (format.args) {
+    case LOG_TEXT:
+      n += snprintf(line + n, size - n, format.format, record.text);
+      break;
+    case LOG_ACTION_FIRST:
+      n += snprintf(line + n, size - n, format.format, actionNames[v[0]], (long)v[1], (long)v[2], (long)v[3]);
+      break;
+    case LOG_ACTION_SECOND:
+      n += snprintf(line + n, size - n, format.format, (long)v[0], actionNames[v[1]], (long)v[2], (long)v[3]);
+      break;
+    default:
+      n += snprintf(line + n, size - n, format.format, (long)v[0], (long)v[1], (long)v[2], (long)v[3]);
+      break;
+  }
+  n = min(n, (int)size - 2);
+  line[n++] = '\n';
+  line[n] = '\0';
+  return n;
+}
+
+void logTask(void*) {
+  char line[LOG_LINE_SIZE];
+  uint32_t droppedReported = 0;
+  for (;;) {
+    LogRecord record;
+    while (popLogRecord(record)) {
+      Serial.write((const uint8_t*)line, formatLogRecord(line, sizeof(line), record));
+    }
+    uint32_t dropped = logDropped.load(std::memory_order_relaxed);
+    if (dropped != droppedReported) {
+      Serial.printf("(%lu log records dropped)\n", (unsigned long)(dropped - droppedReported));
+      droppedReported = dropped;
+    }
+    // Done with the UART before the clock can stop under it
+    Serial.flush();
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+// Posts a command for the LED engine. Returns false if the queue is full.
+bool queueLEDCommand(LEDAction action, int ledNum, long value, unsigned long fadeMs, uint8_t flags) {
+  LEDCommand cmd;
+  cmd.action = action;
+  cmd.flags = flags;
+  cmd.ledNum = ledNum;
+  cmd.value = value;
+  cmd.fadeMs = fadeMs;
+  lastWebCommandTime = millis();
+  webCommandSeen = true;
+  return pushCommand(cmd);
+}
+
+// Single-channel commands go to the coalescing buffer, anything else to the
+// queue after whatever is buffered. Returns false if there's no room.
+bool postLEDCommand(LEDAction action, int ledNum, long value, unsigned long fadeMs) {
+  LEDCommand cmd = {};
+  cmd.action = action;
+  cmd.ledNum = ledNum;
+  cmd.value = value;
+  cmd.fadeMs = fadeMs;
+  bool buffered = ledNum != ALL_LEDS && action != ACTION_FRAME;
+  
+  int kept = 0;
+  for (int i = 0; i < coalescedCount; i++) {
+    kept += !supersedes(cmd, coalesced[i]);
+  }
+  if (!buffered && commandQueueSpace() < (uint32_t)kept + 1) {
+    return false;
+  }
+  
+  kept = 0;
+  for (int i = 0; i < coalescedCount; i++) {
+    if (supersedes(cmd, coalesced[i])) {
+      commandsCoalesced++;
+    } else {
+      coalesced[kept++] = coalesced[i];
+    }
+  }
+  coalescedCount = kept;
+  
+  if (buffered) {
+    if (coalescedCount == COALESCE_SLOTS) {
+      flushCommands();
+    }
+    if (coalescedCount == COALESCE_SLOTS) {
+      return false;
+    }
+    coalesced[coalescedCount++] = cmd;
+  } else {
+    flushCommands();
+    pushCommand(cmd);
+    wakeLEDEngine();
+  }
+  lastWebCommandTime = millis();
+  webCommandSeen = true;
+  return true;
+}
+
+// Whether a newer command leaves nothing of an older one. on/off/blink/pulse
+// set a channel's mode outright; a timer only replaces a timer, since it
+// keeps the channel's on state; brightness only replaces brightness.
+bool supersedes(const LEDCommand& newer, const LEDCommand& older) {
+  if (newer.ledNum != ALL_LEDS && newer.ledNum != older.ledNum) {
+    return false;
+  }
+  switch (newer.action) {
+    case ACTION_ON:
+    case ACTION_OFF:
+    case ACTION_BLINK:
+    case ACTION_PULSE:
+      return older.action != ACTION_BRIGHTNESS;
+    case ACTION_TIMER:
+    case ACTION_BRIGHTNESS:
+      return older.action == newer.action;
+    default:
+      return false;
+  }
+}
+
+// Hands buffered commands to the engine, as many as the queue takes.
+// Returns true once the buffer is empty.
+bool flushCommands() {
+  int sent = 0;
+  while (sent < coalescedCount && pushCommand(coalesced[sent])) {
+    sent++;
+  }
+  if (sent > 0) {
+    memmove(coalesced, coalesced + sent, (coalescedCount - sent) * sizeof(LEDCommand));
+    coalescedCount -= sent;
+    wakeLEDEngine();
+  }
+  return coalescedCount == 0;
+}
+
+bool turnOnLED(int ledNum, unsigned long fadeMs) {
+  return postLEDCommand(ACTION_ON, ledNum, 0, fadeMs);
+}
+
+bool turnOffLED(int ledNum, unsigned long fadeMs) {
+  return postLEDCommand(ACTION_OFF, ledNum, 0, fadeMs);
+}
+
+bool blinkLED(int ledNum, unsigned long interval) {
+  return postLEDCommand(ACTION_BLINK, ledNum, interval);
+}
+
+// A blinking LED picks the new level up on its next ON phase
+bool setLEDBrightness(int ledNum, int brightness, unsigned long fadeMs) {
+  return postLEDCommand(ACTION_BRIGHTNESS, ledNum, brightness, fadeMs);
+}
+
+bool pulseLED(int ledNum, unsigned long duration) {
+  return postLEDCommand(ACTION_PULSE, ledNum, duration);
+}
+
+bool setLEDTimer(int ledNum, unsigned long delayMs) {
+  return postLEDCommand(ACTION_TIMER, ledNum, delayMs);
+}
+
+bool turnOffAllLEDs(unsigned long fadeMs) {
+  return postLEDCommand(ACTION_OFF, ALL_LEDS, 0, fadeMs);
+}
+
+bool turnOnAllLEDs(unsigned long fadeMs) {
+  return postLEDCommand(ACTION_ON, ALL_LEDS, 0, fadeMs);
+}
+
+// Single-producer/single-consumer ring between loop() and the LED engine
+bool pushCommand(const LEDCommand& cmd) {
+  uint32_t head = commandHead.load(std::memory_order_relaxed);
+  if (head - commandTail.load(std::memory_order_acquire) >= COMMAND_QUEUE_SIZE) {
+    return false;
+  }
+  commandQueue[head % COMMAND_QUEUE_SIZE] = cmd;
+  commandHead.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+bool popCommand(LEDCommand& cmd) {
+  uint32_t tail = commandTail.load(std::memory_order_relaxed);
+  if (tail == commandHead.load(std::memory_order_acquire)) {
+    return false;
+  }
+  cmd = commandQueue[tail % COMMAND_QUEUE_SIZE];
+  commandTail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t commandQueueSpace() {
+  return COMMAND_QUEUE_SIZE - (commandHead.load(std::memory_order_relaxed) -
+                               commandTail.load(std::memory_order_acquire));
+}
+
+void wakeLEDEngine() {
+  xTaskNotifyGive(engineTaskHandle);
+}
+
+// Fleet: loop() only
+int64_t fleetTime() {
+  return esp_timer_get_time() + fleetOffsetUs;
+}
+
+uint64_t readBigEndian(const uint8_t* p, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+void writeBigEndian(uint8_t* p, uint64_t value, int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    p[i] = value & 0xFF;
+    value >>= 8;
+  }
+}
+
+void setupFleet() {
+  // The last four bytes of the MAC; never 0, which means "everyone"
+  fleetNode = (uint32_t)(ESP.getEfuseMac() >> 16) | 1;
+  fleetStartTime = millis();
+  
+  fleetSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  int reuse = 1;
+  setsockopt(fleetSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(FLEET_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  ip_mreq membership = {};
+  membership.imr_multiaddr.s_addr = htonl(FLEET_MULTICAST_ADDRESS);
+  membership.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (fleetSocket < 0 || bind(fleetSocket, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+      setsockopt(fleetSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+    LOG_ERROR(LOG_FLEET_LISTEN_FAILED);
+    if (fleetSocket >= 0) {
+      close(fleetSocket);
+      fleetSocket = -1;
+    }
+    return;
+  }
+  
+  // Lets tools find the controllers without knowing their addresses
+  char hostname[16];
+  snprintf(hostname, sizeof(hostname), "led-%08lx", (unsigned long)fleetNode);
+  if (MDNS.begin(hostname)) {
+    MDNS.addService("http", "tcp", HTTP_PORT);
+    MDNS.addService("ledfleet", "udp", FLEET_PORT);
+    MDNS.addServiceTxt("ledfleet", "udp", "group", FLEET_GROUP);
+  }
+  LOG_INFO(LOG_FLEET_LISTENING, FLEET_PORT, fleetNode);
+}
+
+// Fills in the header and multicasts the packet
+void sendFleetPacket(FleetPacketType type, uint32_t to, size_t length) {
+  memcpy(fleetPacket, "LEDN", 4);
+  fleetPacket[4] = FLEET_VERSION;
+  fleetPacket[5] = type;
+  writeBigEndian(fleetPacket + 6, fleetNode, 4);
+  writeBigEndian(fleetPacket + 10, to, 4);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(FLEET_PORT);
+  addr.sin_addr.s_addr = htonl(FLEET_MULTICAST_ADDRESS);
+  sendto(fleetSocket, fleetPacket, FLEET_HEADER_SIZE + length, MSG_DONTWAIT, (sockaddr*)&addr, sizeof(addr));
+}
+
+void pumpFleet() {
+  if (fleetSocket < 0) {
+    return;
+  }
+  unsigned long now = millis();
+  
+  sockaddr_in from;
+  socklen_t fromLength = sizeof(from);
+  int n;
+  while ((n = recvfrom(fleetSocket, fleetPacket, sizeof(fleetPacket), MSG_DONTWAIT,
+                       (sockaddr*)&from, &fromLength)) > 0) {
+    handleFleetPacket(n, from.sin_addr.s_addr, now);
+  }
+  
+  bool syncedPeer = false;
+  for (int p = 0; p < MAX_FLEET_PEERS; p++) {
+    if (fleetPeers[p].node != 0 && now - fleetPeers[p].lastSeen >= FLEET_PEER_TIMEOUT_MS) {
+      fleetPeers[p].node = 0;
+    }
+    syncedPeer |= fleetPeers[p].node != 0 && fleetPeers[p].synced;
+  }
+  if (!fleetSynced && !syncedPeer && now - fleetStartTime >= FLEET_JOIN_MS) {
+    fleetSynced = true;
+    LOG_INFO(LOG_FLEET_CLOCK_STARTED);
+  }
+  electFleetLeader();
+  
+  if (now - fleetLastBeacon >= FLEET_BEACON_MS) {
+    fleetLastBeacon = now;
+    fleetPacket[FLEET_HEADER_SIZE] = fleetSynced;
+    strncpy((char*)fleetPacket + FLEET_HEADER_SIZE + 1, FLEET_GROUP, FLEET_GROUP_SIZE);
+    sendFleetPacket(FLEET_BEACON, 0, 1 + FLEET_GROUP_SIZE);
+  }
+  
+  unsigned long syncInterval = fleetSampleCount < FLEET_SYNC_SAMPLES ? FLEET_FAST_SYNC_MS : FLEET_SYNC_MS;
+  if (fleetLeader != 0 && fleetLeader != fleetNode && now - fleetLastSync >= syncInterval) {
+    fleetLastSync = now;
+    writeBigEndian(fleetPacket + FLEET_HEADER_SIZE, esp_timer_get_time(), 8);
+    sendFleetPacket(FLEET_SYNC, fleetLeader, 8);
+  }
+  
+  runFleetSchedule();
+}
 
-// LED pin definitions
-const int LED_PINS[] = {2, 4, 5, 18, 19, 21, 22, 23};
-const int NUM_LEDS = sizeof(LED_PINS) / sizeof(LED_PINS[0]);
+void addFleetWait(LoopWait& wait) {
+  if (fleetSocket < 0) {
+    return;
+  }
+  wait.watchRead(fleetSocket);
+  wait.dueAfter(fleetLastBeacon, FLEET_BEACON_MS);
+  if (!fleetSynced) {
+    wait.dueAfter(fleetStartTime, FLEET_JOIN_MS);
+  }
+  if (fleetLeader != 0 && fleetLeader != fleetNode) {
+    wait.dueAfter(fleetLastSync, fleetSampleCount < FLEET_SYNC_SAMPLES ? FLEET_FAST_SYNC_MS : FLEET_SYNC_MS);
+  }
+  for (int p = 0; p < MAX_FLEET_PEERS; p++) {
+    if (fleetPeers[p].node != 0) {
+      wait.dueAfter(fleetPeers[p].lastSeen, FLEET_PEER_TIMEOUT_MS);
+    }
+  }
+  // An overdue command whose post failed on a full queue retries at once
+  int64_t now = fleetTime();
+  for (int s = 0; s < MAX_FLEET_SCHEDULED; s++) {
+    if (fleetScheduled[s].active) {
+      wait.dueIn(fleetScheduled[s].due - now);
+    }
+  }
+}
 
-// PWM properties for brightness control
-const int PWM_FREQ = 5000;
-const int PWM_RESOLUTION = 8; 
+void handleFleetPacket(size_t length, uint32_t address, unsigned long now) {
+  const uint8_t* packet = fleetPacket;
+  if (length < FLEET_HEADER_SIZE || memcmp(packet, "LEDN", 4) != 0 || packet[4] != FLEET_VERSION) {
+    return;
+  }
+  uint8_t type = packet[5];
+  uint32_t sender = readBigEndian(packet + 6, 4);
+  uint32_t to = readBigEndian(packet + 10, 4);
+  const uint8_t* payload = packet + FLEET_HEADER_SIZE;
+  length -= FLEET_HEADER_SIZE;
+  if (sender == 0 || sender == fleetNode || (to != 0 && to != fleetNode)) {
+    return;
+  }
+  FleetPeer* peer = findFleetPeer(sender, now);
+  peer->address = address;
+  peer->lastSeen = now;
+  
+  if (type == FLEET_BEACON && length >= 1 + FLEET_GROUP_SIZE) {
+    peer->synced = payload[0] != 0;
+    memcpy(peer->group, payload + 1, FLEET_GROUP_SIZE);
+    peer->group[FLEET_GROUP_SIZE - 1] = '\0';
+    if (!fleetGroupValid(peer->group)) {
+      strcpy(peer->group, "?");
+    }
+  } else if (type == FLEET_SYNC && length >= 8 && fleetSynced) {
+    // The request's t1 is already in place for the reply
+    writeBigEndian(fleetPacket + FLEET_HEADER_SIZE + 8, fleetTime(), 8);
+    sendFleetPacket(FLEET_SYNC_REPLY, sender, 16);
+  } else if (type == FLEET_SYNC_REPLY && length >= 16 && sender == fleetLeader) {
+    int64_t t4 = esp_timer_get_time();
+    int64_t t1 = readBigEndian(payload, 8);
+    int64_t t2 = readBigEndian(payload + 8, 8);
+    addFleetSample(t2 - (t1 + t4) / 2, t4 - t1);
+  } else if (type == FLEET_COMMAND && length >= 15 + FLEET_GROUP_SIZE) {
+    uint16_t id = readBigEndian(payload, 2);
+    uint8_t action = payload[2];
+    uint32_t fadeMs = readBigEndian(payload + 3, 4);
+    int64_t due = readBigEndian(payload + 7, 8);
+    char group[FLEET_GROUP_SIZE];
+    memcpy(group, payload + 15, FLEET_GROUP_SIZE);
+    group[FLEET_GROUP_SIZE - 1] = '\0';
+    if ((action == ACTION_ON || action == ACTION_OFF) && fadeMs <= MAX_FADE_MS && fleetGroupValid(group) &&
+        fleetGroupMatches(group)) {
+      scheduleFleetCommand(sender, id, action, fadeMs, due);
+    }
+  }
+}
 
-// LED states
-struct LEDState {
-  bool isOn;
-};
+// The peer's slot, taking a free one or the one heard from longest ago
+FleetPeer* findFleetPeer(uint32_t node, unsigned long now) {
+  FleetPeer* oldest = &fleetPeers[0];
+  for (int p = 0; p < MAX_FLEET_PEERS; p++) {
+    if (fleetPeers[p].node == node) {
+      return &fleetPeers[p];
+    }
+    if (oldest->node != 0 && (fleetPeers[p].node == 0 || now - fleetPeers[p].lastSeen > now - oldest->lastSeen)) {
+      oldest = &fleetPeers[p];
+    }
+  }
+  memset(oldest, 0, sizeof(*oldest));
+  oldest->node = node;
+  return oldest;
+}
 
-LEDState ledStates[8];  
+void electFleetLeader() {
+  uint32_t leader = fleetSynced ? fleetNode : 0;
+  for (int p = 0; p < MAX_FLEET_PEERS; p++) {
+    if (fleetPeers[p].node != 0 && fleetPeers[p].synced && (leader == 0 || fleetPeers[p].node < leader)) {
+      leader = fleetPeers[p].node;
+    }
+  }
+  if (leader != fleetLeader) {
+    // Samples from the old leader say nothing about the new one. Taking
+    // over keeps the clock this node already runs; following another node
+    // waits for its first sample, which sets the offset.
+    fleetLeader = leader;
+    fleetSampleCount = 0;
+    fleetSampleNext = 0;
+    fleetLastSync = 0;
+    if (leader == fleetNode) {
+      fleetRoundTripUs = 0;
+    } else if (leader != 0) {
+      fleetSynced = false;
+    }
+    LOG_INFO(LOG_FLEET_LEADER, leader);
+  }
+}
 
-void setup() {
-  Serial.begin(115200);
+void addFleetSample(int64_t offset, int64_t roundTrip) {
+  if (roundTrip < 0 || roundTrip > FLEET_MAX_ROUND_TRIP_US) {
+    return;
+  }
+  fleetSamples[fleetSampleNext] = {offset, roundTrip};
+  fleetSampleNext = (fleetSampleNext + 1) % FLEET_SYNC_SAMPLES;
+  if (fleetSampleCount < FLEET_SYNC_SAMPLES) {
+    fleetSampleCount++;
+  }
   
+  // The shortest round trip had the least room for asymmetric delay
+  const FleetSample* best = &fleetSamples[0];
+  for (int i = 1; i < fleetSampleCount; i++) {
+    if (fleetSamples[i].roundTrip < best->roundTrip) {
+      best = &fleetSamples[i];
+    }
+  }
+  fleetOffsetUs = best->offset;
+  fleetRoundTripUs = best->roundTrip;
+  if (!fleetSynced) {
+    fleetSynced = true;
+    LOG_INFO(LOG_FLEET_SYNCED, fleetLeader, (int32_t)fleetRoundTripUs);
+  }
+}
+
+// A name of letters, digits, '-' and '_', or "*" for every node
+bool fleetGroupValid(const char* group) {
+  size_t length = strlen(group);
+  if (length == 0 || length >= FLEET_GROUP_SIZE) {
+    return false;
+  }
+  if (strcmp(group, "*") == 0) {
+    return true;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char)group[i]) && group[i] != '-' && group[i] != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool fleetGroupMatches(const char* group) {
+  return strcmp(group, "*") == 0 || strcmp(group, FLEET_GROUP) == 0;
+}
+
+// Multicasts an all-channel command for a group, to be committed by every
+// member FLEET_COMMAND_LEAD_US from now on the fleet clock
+void sendFleetCommand(LEDAction action, unsigned long fadeMs, const char* group, uint16_t& id, int64_t& due) {
+  id = ++fleetNextCommandId;
+  due = fleetTime() + FLEET_COMMAND_LEAD_US;
+  for (int copy = 0; copy < FLEET_COMMAND_COPIES; copy++) {
+    uint8_t* payload = fleetPacket + FLEET_HEADER_SIZE;
+    writeBigEndian(payload, id, 2);
+    payload[2] = action;
+    writeBigEndian(payload + 3, fadeMs, 4);
+    writeBigEndian(payload + 7, due, 8);
+    strncpy((char*)payload + 15, group, FLEET_GROUP_SIZE);
+    sendFleetPacket(FLEET_COMMAND, 0, 15 + FLEET_GROUP_SIZE);
+  }
+  if (fleetGroupMatches(group)) {
+    scheduleFleetCommand(fleetNode, id, action, fadeMs, due);
+  }
+}
+
+// Copies of a command are recognised by origin and id and scheduled once.
+// Stream priority is checked here, as for a command from this node's own
+// web server, not when the command falls due.
+void scheduleFleetCommand(uint32_t origin, uint16_t id, uint8_t action, uint32_t fadeMs, int64_t due) {
+  for (int i = 0; i < FLEET_RECENT_COMMANDS; i++) {
+    if (fleetRecent[i][0] == origin && fleetRecent[i][1] == id) {
+      return;
+    }
+  }
+  fleetRecent[fleetRecentNext][0] = origin;
+  fleetRecent[fleetRecentNext][1] = id;
+  fleetRecentNext = (fleetRecentNext + 1) % FLEET_RECENT_COMMANDS;
   
-  for (int i = 0; i < NUM_LEDS; i++) {
-    pinMode(LED_PINS[i], OUTPUT);
-    
-    
-    ledcAttach(LED_PINS[i], PWM_FREQ, PWM_RESOLUTION);
-    
-    // Initialize LED states
-    ledStates[i].isOn = false;
-    ledStates[i].brightness = 255;
-    ledStates[i].blinkInterval = 0;
-    ledStates[i].lastBlinkTime = 0;
-    ledStates[i].blinkState = false;
-    
-    // Turn off all LEDs initially
-    ledcWrite(LED_PINS[i], 0);
+  if (streamHolds(ALL_LEDS)) {
+    fleetCommandsMissed++;
+    LOG_WARN(LOG_FLEET_COMMAND_MISSED, id, origin);
+    return;
+  }
+  for (int s = 0; s < MAX_FLEET_SCHEDULED; s++) {
+    if (!fleetScheduled[s].active) {
+      fleetScheduled[s] = {true, origin, id, action, fadeMs, due};
+      return;
+    }
+  }
+  fleetCommandsMissed++;
+  LOG_WARN(LOG_FLEET_COMMAND_MISSED, id, origin);
+}
+
+void runFleetSchedule() {
+  for (int s = 0; s < MAX_FLEET_SCHEDULED; s++) {
+    FleetScheduled& cmd = fleetScheduled[s];
+    if (!cmd.active || fleetTime() < cmd.due) {
+      continue;
+    }
+    if (!postLEDCommand((LEDAction)cmd.action, ALL_LEDS, 0, cmd.fadeMs)) {
+      continue;  // queue full, next pass
+    }
+    cmd.active = false;
+    fleetCommandsRun++;
+    fleetLastValid = true;
+    fleetLastOrigin = cmd.origin;
+    fleetLastId = cmd.id;
+    fleetLastDue = cmd.due;
+    fleetLastLateUs = fleetTime() - cmd.due;
+    LOG_INFO(LOG_FLEET_COMMAND_RUN, cmd.id, cmd.origin, (int32_t)fleetLastLateUs);
+  }
+}
+
+void handleFleet() {
+  static char response[MAX_FLEET_PEERS * 112 + 384];
+  size_t size = sizeof(response);
+  size_t n = snprintf(response, size,
+                      "{\"node\":\"%08lx\",\"group\":\"%s\",\"synced\":%s,\"leader\":\"%08lx\",\"offsetUs\":%lld,"
+                      "\"roundTripUs\":%lld,\"fleetTimeUs\":%lld,\"lastCommand\":",
+                      (unsigned long)fleetNode, FLEET_GROUP, fleetSynced ? "true" : "false",
+                      (unsigned long)fleetLeader, (long long)fleetOffsetUs, (long long)fleetRoundTripUs,
+                      (long long)fleetTime());
+  if (fleetLastValid) {
+    n += snprintf(response + n, size - n, "{\"origin\":\"%08lx\",\"id\":%u,\"dueUs\":%lld,\"lateUs\":%lld}",
+                  (unsigned long)fleetLastOrigin, fleetLastId, (long long)fleetLastDue, (long long)fleetLastLateUs);
+  } else {
+    n += snprintf(response + n, size - n, "null");
+  }
+  n += snprintf(response + n, size - n, ",\"peers\":[");
+  bool first = true;
+  unsigned long now = millis();
+  for (int p = 0; p < MAX_FLEET_PEERS; p++) {
+    const FleetPeer& peer = fleetPeers[p];
+    if (peer.node == 0) {
+      continue;
+    }
+    uint32_t ip = peer.address;
+    n += snprintf(response + n, size - n,
+                  "%s{\"node\":\"%08lx\",\"ip\":\"%u.%u.%u.%u\",\"group\":\"%s\",\"synced\":%s,\"ageMs\":%lu}",
+                  first ? "" : ",", (unsigned long)peer.node, (unsigned)(ip & 0xFF), (unsigned)((ip >> 8) & 0xFF),
+                  (unsigned)((ip >> 16) & 0xFF), (unsigned)(ip >> 24), peer.group, peer.synced ? "true" : "false",
+                  now - peer.lastSeen);
+    first = false;
+  }
+  n += snprintf(response + n, size - n, "]}");
+  server.send(200, "application/json", response, n);
+}
+
+// UDP frame stream, loop() side: receives and vets frames, then hands the
+// winner to the engine through the frame triple buffer
+void setupStream() {
+  streamSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(STREAM_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (streamSocket < 0 || bind(streamSocket, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    LOG_ERROR(LOG_STREAM_LISTEN_FAILED);
+    if (streamSocket >= 0) {
+      close(streamSocket);
+      streamSocket = -1;
+    }
+    return;
+  }
+  LOG_INFO(LOG_STREAM_LISTENING, STREAM_PORT);
+}
+
+// Drains the UDP socket without blocking. Only the newest accepted frame
+// matters, so the engine is handed at most one per loop().
+void pumpStream() {
+  if (streamSocket < 0) {
+    return;
   }
   
-  // Connect to WiFi
-  WiFi.begin(ssid, password);
-  Serial.print("Connecting to WiFi");
+  bool accepted = false;
+  int n;
+  while ((n = recv(streamSocket, streamPacket, sizeof(streamPacket), MSG_DONTWAIT)) > 0) {
+    if (acceptStreamFrame(streamPacket, n)) {
+      accepted = true;
+    } else {
+      streamFramesDropped++;
+    }
+  }
   
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(1000);
-    Serial.print(".");
+  if (accepted) {
+    LEDCommand cmd = {};
+    cmd.action = ACTION_FRAME;
+    if (pushCommand(cmd)) {
+      wakeLEDEngine();
+      streamFramesApplied++;
+    } else {
+      streamFramesDropped++;
+    }
+  }
+}
+
+// Validates a frame against the sequence and priority rules and, if it
+// wins, publishes it as the latest frame for the engine
+bool acceptStreamFrame(const uint8_t* packet, size_t length) {
+  if (length < STREAM_HEADER_SIZE || memcmp(packet, "LEDF", 4) != 0 || packet[4] != STREAM_VERSION) {
+    return false;
+  }
+  uint8_t priority = packet[5];
+  uint16_t sequence = (packet[6] << 8) | packet[7];
+  uint16_t first = (packet[8] << 8) | packet[9];
+  uint16_t count = (packet[10] << 8) | packet[11];
+  if (priority > STREAM_MAX_PRIORITY || count == 0 || first + count > NUM_LEDS ||
+      length != STREAM_HEADER_SIZE + count) {
+    return false;
   }
   
-  Serial.println();
-  Serial.println("WiFi connected!");
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
+  unsigned long now = millis();
+  if (streamActive && now - streamLastFrameTime >= STREAM_TIMEOUT_MS) {
+    streamActive = false;
+    LOG_WARN(LOG_STREAM_TIMED_OUT);
+  }
+  if (priority < STREAM_WEB_PRIORITY && webCommandSeen && now - lastWebCommandTime < STREAM_TIMEOUT_MS) {
+    return false;
+  }
+  if (streamActive) {
+    if (priority < streamPriority) {
+      return false;
+    }
+    // Late or repeated frames are dropped; a jump far backwards is a
+    // sender that restarted its count
+    int16_t delta = sequence - streamSequence;
+    if (priority == streamPriority && delta <= 0 && delta > -STREAM_SEQUENCE_WINDOW) {
+      return false;
+    }
+  } else {
+    LOG_INFO(LOG_STREAM_STARTED, priority);
+  }
   
-  // Setup web server routes
-  setupWebServer();
+  streamActive = true;
+  streamPriority = priority;
+  streamSequence = sequence;
+  streamFirst = first;
+  streamCount = count;
+  streamLastFrameTime = now;
   
-  server.begin();
-  Serial.println("Web server started!");
-  Serial.println("Open your phone browser and go to: http://" + WiFi.localIP().toString());
+  LEDFrame& frame = nextFrame(streamFrames);
+  frame.first = first;
+  frame.count = count;
+  frame.fadeMs = 0;
+  memcpy(frame.levels, packet + STREAM_HEADER_SIZE, count);
+  publishFrame(streamFrames);
+  return true;
 }
 
-void loop() {
-  server.handleClient();
-  handleBlinking();
-  delay(10);
+// loop() side of a frame triple buffer: fill nextFrame(), then publish it
+// and queue the command that applies it (ACTION_FRAME or ACTION_SCENE)
+LEDFrame& nextFrame(FrameExchange& exchange) {
+  return exchange.frames[exchange.writeSlot];
 }
 
-void setupWebServer() {
-  // Serve the main HTML page
-  server.on("/", handleRoot);
-  
-  // API endpoints
-  server.on("/api/status", HTTP_GET, handleGetStatus);
-  server.on("/api/led", HTTP_POST, handleLEDControl);
-  server.on("/api/all", HTTP_POST, handleAllLEDs);
-  
-  // Handle CORS for API calls
-  server.enableCORS(true);
+void publishFrame(FrameExchange& exchange) {
+  exchange.writeSlot = exchange.latest.exchange(exchange.writeSlot | FRAME_FRESH, std::memory_order_acq_rel) & 3;
 }
-void handleRoot() {
-  String html = "<!DOCTYPE html><html lang=\"en\"><head><meta charset=\"UTF-8\">";
-  html += "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">";
-  html += "<title>LED Control System by Angelo</title>";
-  html += "<link rel=\"preconnect\" href=\"https://fonts.googleapis.com\">";
-  html += "<link rel=\"preconnect\" href=\"https://fonts.gstatic.com\" crossorigin>";
-  html += "<link href=\"https://fonts.googleapis.com/css2?family=Inter:wght@300;400;500;600;700;800;900&display=swap\" rel=\"stylesheet\">";
-  html += "<style>";
-  
-  // Enhanced professional color system with modern gradients
-  html += ":root{";
-  html += "--primary:#3b82f6;--primary-dark:#1e40af;--primary-light:#60a5fa;";
-  html += "--success:#10b981;--success-dark:#059669;--success-light:#34d399;";
-  html += "--danger:#ef4444;--danger-dark:#dc2626;--danger-light:#f87171;";
-  html += "--warning:#f59e0b;--warning-dark:#d97706;--warning-light:#fbbf24;";
-  html += "--neutral-50:#fafafa;--neutral-100:#f5f5f5;--neutral-200:#e5e5e5;";
-  html += "--neutral-300:#d4d4d4;--neutral-400:#a3a3a3;--neutral-500:#737373;";
-  html += "--neutral-600:#525252;--neutral-700:#404040;--neutral-800:#262626;";
-  html += "--neutral-900:#171717;";
-  html += "--gradient-primary:linear-gradient(135deg,var(--primary) 0%,var(--primary-light) 100%);";
-  html += "--gradient-success:linear-gradient(135deg,var(--success) 0%,var(--success-light) 100%);";
-  html += "--gradient-danger:linear-gradient(135deg,var(--danger) 0%,var(--danger-light) 100%);";
-  html += "--glass-bg:rgba(255,255,255,0.85);";
-  html += "--glass-border:rgba(255,255,255,0.2);";
-  html += "--shadow-xs:0 1px 2px 0 rgb(0 0 0 / 0.05);";
-  html += "--shadow-sm:0 1px 3px 0 rgb(0 0 0 / 0.1), 0 1px 2px -1px rgb(0 0 0 / 0.1);";
-  html += "--shadow-md:0 4px 6px -1px rgb(0 0 0 / 0.1), 0 2px 4px -2px rgb(0 0 0 / 0.1);";
-  html += "--shadow-lg:0 10px 15px -3px rgb(0 0 0 / 0.1), 0 4px 6px -4px rgb(0 0 0 / 0.1);";
-  html += "--shadow-xl:0 20px 25px -5px rgb(0 0 0 / 0.1), 0 8px 10px -6px rgb(0 0 0 / 0.1);";
-  html += "--shadow-2xl:0 25px 50px -12px rgb(0 0 0 / 0.25);";
-  html += "}";
-  
-  // Modern reset and base typography
-  html += "*{box-sizing:border-box;margin:0;padding:0}";
-  html += "body{font-family:'Inter',system-ui,-apple-system,BlinkMacSystemFont,sans-serif;";
-  html += "background:linear-gradient(135deg,#f8fafc 0%,#e2e8f0 50%,#cbd5e1 100%);";
-  html += "min-height:100vh;color:var(--neutral-800);line-height:1.6;font-weight:400;";
-  html += "background-attachment:fixed;-webkit-font-smoothing:antialiased;-moz-osx-font-smoothing:grayscale}";
-  
-  //container
-  html += ".container{max-width:1400px;margin:0 auto;padding:32px 24px;min-height:100vh;";
-  html += "display:flex;flex-direction:column;gap:32px}";
-  
-  //header
-  html += ".header{display: flex;align-items:center;padding: 10px 20px;}";
-
-  html += ".company-logo{width:80px;height:80px;margin-right:15px;";
-  html += "background:var(--gradient-primary);border-radius:20px;";
-  html += "display:flex;align-items:center;justify-content:center;";
-  html += "box-shadow:var(--shadow-lg);position:relative}";
-  html += ".company-logo::before{content:'⚡';font-size:40px;color:white;filter:drop-shadow(0 2px 4px rgba(0,0,0,0.1))}";
-  html += ".company-name{font-size:42px;font-weight:900;color:var(--neutral-900);";
-  html += "margin-bottom:12px;letter-spacing:-0.02em;";
-  html += "background:linear-gradient(135deg,var(--neutral-900),var(--neutral-600));";
-  html += "-webkit-background-clip:text;-webkit-text-fill-color:transparent;background-clip:text}";
-  html += ".tagline{font-size:14px;color:var(--neutral-500);font-weight:500;";
-  html += "text-transform:uppercase;letter-spacing:0.1em;opacity:0.8}";
-  
-  //status card
-  html += ".status-card{display:flex;align-items:center;justify-content:center;";
-  html += "transition:all 0.3s cubic-bezier(0.4,0,0.2,1);position:relative;overflow:hidden}";
-  html += ".status-card::before{content:'';position:absolute;inset:0;";
-  html += "background:linear-gradient(45deg,transparent 30%,rgba(255,255,255,0.1) 50%,transparent 70%);";
-  html += "transform:translateX(-100%);transition:transform 0.6s ease;z-index:0}";
-  html += ".status-card:hover::before{transform:translateX(100%)}";
-  html += ".status-content{display:flex;align-items:center;gap:16px;position:relative;z-index:1}";
-  html += ".status-icon{width:16px;height:16px;border-radius:50%;";
-  html += "background:var(--danger);flex-shrink:0;position:relative;";
-  html += "transition:all 0.3s ease}";
-  html += ".status-icon::after{content:'';position:absolute;inset:-4px;";
-  html += "border-radius:50%;background:inherit;opacity:0.2;";
-  html += "animation:pulse 2s infinite}";
-  html += ".status-icon.online{background:var(--success)}";
-  html += ".status-icon.warning{background:var(--warning)}";
-  html += ".status-text{font-size:18px;font-weight:600;color:var(--neutral-700);";
-  html += "transition:color 0.3s ease}";
-  html += "@keyframes pulse{0%,100%{transform:scale(1);opacity:0.2}50%{transform:scale(1.2);opacity:0.1}}";
-  
-  // Premium LED control grid
-  html += ".control-grid{display:grid;grid-template-columns:repeat(auto-fill,minmax(380px,1fr));";
-  html += "gap:24px;align-items:start}";
-  
-  // Enhanced LED cards with premium styling
-  html += ".led-card{background:var(--glass-bg);backdrop-filter:blur(20px);";
-  html += "border:1px solid var(--glass-border);border-radius:20px;";
-  html += "padding:28px;box-shadow:var(--shadow-md);position:relative;";
-  html += "transition:all 0.3s cubic-bezier(0.4,0,0.2,1);overflow:hidden}";
-  html += ".led-card::before{content:'';position:absolute;inset:0;";
-  html += "background:linear-gradient(135deg,rgba(255,255,255,0.1),transparent);";
-  html += "opacity:0;transition:opacity 0.3s ease;z-index:0}";
-  html += ".led-card:hover{transform:translateY(-4px);box-shadow:var(--shadow-xl);";
-  html += "border-color:rgba(59,130,246,0.3)}";
-  html += ".led-card:hover::before{opacity:1}";
-  html += ".led-card.active{border-color:var(--success);";
-  html += "box-shadow:0 8px 32px -8px rgba(16,185,129,0.3)}";
-  html += ".led-card.active::after{content:'';position:absolute;inset:0;";
-  html += "background:linear-gradient(135deg,rgba(16,185,129,0.05),transparent);z-index:0}";
-  
-  // Premium LED card header
-  html += ".led-header{display:flex;justify-content:space-between;align-items:center;";
-  html += "margin-bottom:24px;position:relative;z-index:1}";
-  html += ".led-title{font-size:20px;font-weight:700;color:var(--neutral-900);";
-  html += "display:flex;align-items:center;gap:12px}";
-  html += ".led-title::before{content:'💡';font-size:18px;opacity:0.7}";
-  html += ".led-status{display:flex;align-items:center;gap:10px;";
-  html += "padding:8px 16px;border-radius:12px;";
-  html += "background:rgba(255,255,255,0.5);backdrop-filter:blur(10px)}";
-  html += ".status-dot{width:12px;height:12px;border-radius:50%;";
-  html += "background:var(--neutral-300);position:relative;";
-  html += "transition:all 0.3s ease}";
-  html += ".status-dot::after{content:'';position:absolute;inset:-2px;";
-  html += "border-radius:50%;background:inherit;opacity:0.3;";
-  html += "transform:scale(0);transition:transform 0.3s ease}";
-  html += ".status-dot.on{background:var(--success)}";
-  html += ".status-dot.on::after{transform:scale(1.5);animation:ripple 1.5s infinite}";
-  html += ".status-label{font-size:13px;font-weight:600;color:var(--neutral-600);";
-  html += "text-transform:uppercase;letter-spacing:0.05em}";
-  html += "@keyframes ripple{0%{transform:scale(1.5);opacity:0.3}100%{transform:scale(2.5);opacity:0}}";
-  
-  // Premium control buttons with better separation
-  html += ".led-controls{display:grid;grid-template-columns:1fr 1fr;gap:16px;position:relative;z-index:1}";
-  html += ".control-btn{padding:16px 24px;border:2px solid;border-radius:12px;";
-  html += "font-size:15px;font-weight:700;cursor:pointer;";
-  html += "transition:all 0.2s cubic-bezier(0.4,0,0.2,1);";
-  html += "text-align:center;text-transform:uppercase;letter-spacing:0.05em;";
-  html += "position:relative;overflow:hidden;background:white}";
-  html += ".control-btn::before{content:'';position:absolute;inset:0;";
-  html += "background:linear-gradient(45deg,transparent 30%,rgba(255,255,255,0.3) 50%,transparent 70%);";
-  html += "transform:translateX(-100%);transition:transform 0.6s ease;z-index:0}";
-  html += ".control-btn:hover{transform:translateY(-2px);box-shadow:var(--shadow-lg)}";
-  html += ".control-btn:hover::before{transform:translateX(100%)}";
-  html += ".control-btn:active{transform:translateY(0);transition-duration:0.1s}";
-  html += ".control-btn:disabled{opacity:0.5;cursor:not-allowed;transform:none}";
-  html += ".control-btn span{position:relative;z-index:1}";
-  
-  html += ".btn-on{background:var(--gradient-success);border-color:var(--success);color:white}";
-  html += ".btn-on:hover{border-color:var(--success-dark);";
-  html += "box-shadow:0 8px 25px -8px rgba(16,185,129,0.4)}";
-  html += ".btn-off{background:var(--gradient-danger);border-color:var(--danger);color:white}";
-  html += ".btn-off:hover{border-color:var(--danger-dark);";
-  html += "box-shadow:0 8px 25px -8px rgba(239,68,68,0.4)}";
-    
-  // Premium master control buttons with better spacing
-  html += ".master-controls{display:grid;grid-template-columns:repeat(auto-fit,minmax(200px,1fr));";
-  html += "gap:24px;max-width:600px;margin:0 auto;position:relative;z-index:1}";
-  html += ".master-btn{padding:20px 40px;border:3px solid;border-radius:16px;";
-  html += "font-size:18px;font-weight:800;cursor:pointer;";
-  html += "transition:all 0.25s cubic-bezier(0.4,0,0.2,1);";
-  html += "text-transform:uppercase;letter-spacing:0.1em;position:relative;overflow:hidden;";
-  html += "background:white;box-shadow:var(--shadow-md)}";
-  html += ".master-btn::before{content:'';position:absolute;inset:0;";
-  html += "background:linear-gradient(45deg,transparent 30%,rgba(255,255,255,0.4) 50%,transparent 70%);";
-  html += "transform:translateX(-100%);transition:transform 0.6s ease;z-index:0}";
-  html += ".master-btn:hover{transform:translateY(-3px);box-shadow:var(--shadow-2xl)}";
-  html += ".master-btn:hover::before{transform:translateX(100%)}";
-  html += ".master-btn:active{transform:translateY(-1px);transition-duration:0.1s}";
-  html += ".master-btn:disabled{opacity:0.6;cursor:not-allowed;transform:none}";
-  html += ".master-btn span{position:relative;z-index:1;display:flex;align-items:center;justify-content:center;gap:8px}";
-  
-  html += ".master-on{background:var(--gradient-success);border-color:var(--success);color:white}";
-  html += ".master-on:hover{border-color:var(--success-dark);";
-  html += "box-shadow:0 16px 40px -12px rgba(16,185,129,0.4)}";
-  html += ".master-on span::before{content:'⚡'}";
-  html += ".master-off{background:var(--gradient-danger);border-color:var(--danger);color:white}";
-  html += ".master-off:hover{border-color:var(--danger-dark);";
-  html += "box-shadow:0 16px 40px -12px rgba(239,68,68,0.4)}";
-  html += ".master-off span::before{content:'⏹️'}";
-  
-  // Premium footer
-  html += ".footer{text-align:center;padding:32px;";
-  html += "color:var(--neutral-500);font-size:15px;font-weight:500;";
-  
-  // Enhanced responsive design
-  html += "@media (max-width:1024px){";
-  html += ".container{padding:24px 16px;gap:24px}";
-  html += ".control-grid{grid-template-columns:repeat(auto-fill,minmax(320px,1fr));gap:20px}";
-  html += "}";
-  
-  html += "@media (max-width:768px){";
-  html += ".container{padding:16px;gap:20px}";
-  html += ".header{padding:32px 24px}";
-  html += ".company-name{font-size:32px}";
-  html += ".company-logo{width:64px;height:64px}";
-  html += ".company-logo::before{font-size:32px}";
-  html += ".control-grid{grid-template-columns:1fr;gap:16px}";
-  html += ".led-card{padding:24px}";
-  html += ".master-section{padding:28px}";
-  html += ".master-controls{grid-template-columns:1fr;gap:16px}";
-  html += ".master-btn{padding:16px 32px;font-size:16px}";
-  html += "}";
-  
-  html += "@media (max-width:480px){";
-  html += ".header{padding:24px 16px}";
-  html += ".company-name{font-size:28px}";
-  html += ".status-card{padding:24px}";
-  html += ".led-controls{gap:12px}";
-  html += ".control-btn{padding:14px 20px;font-size:14px}";
-  html += ".master-section{padding:20px}";
-  html += ".master-btn{padding:14px 24px;font-size:15px}";
-  html += "}";
-  
-  html += "</style></head><body>";
-  
-  html += "<div class=\"container\">";
-  
-  // Enhanced professional header
-  html += "<header class=\"header\">";
-  html += "<div class=\"company-logo\"></div>";
-  html += "<h1 class=\"company-name\">LightSync</h1>";
-  html += "</header>";
-  
-  // Enhanced system status
-  html += "<div class=\"status-card\" id=\"systemStatus\">";
-  html += "<div class=\"status-content\">";
-  html += "<div class=\"status-icon\" id=\"statusIcon\"></div>";
-  html += "<div class=\"status-text\" id=\"statusText\">Initializing system...</div>";
-  html += "</div></div>";
-  
-  // LED controls grid
-  html += "<div class=\"control-grid\" id=\"ledGrid\"></div>";
-  
-  // Enhanced master controls
-  html += "<div class=\"master-section\">";
-  html += "<div class=\"master-controls\">";
-  html += "<button class=\"master-btn master-on\" onclick=\"controlAllLEDs(true)\"><span>Power All ON</span></button>";
-  html += "<button class=\"master-btn master-off\" onclick=\"controlAllLEDs(false)\"><span>Power All OFF</span></button>";
-  html += "</div></div>";
-  
-  // Enhanced footer
-  html += "<footer class=\"footer\">";
-  html += "© 2025 LightSync • IoT Solutions by Angelo";
-  html += "</footer>";
-  
-  html += "</div>";
-  
-  // Enhanced JavaScript with better error handling
-  html += "<script>";
-  html += "let ledStates=[];";
-  html += "let isConnected=false;";
-  html += "let retryCount=0;";
-  html += "const maxRetries=3;";
-  
-  html += "async function fetchStatus(){";
-  html += "try{";
-  html += "const response=await fetch('/api/status',{";
-  html += "method:'GET',";
-  html += "headers:{'Accept':'application/json'},";
-  html += "timeout:5000";
-  html += "});";
-  html += "if(!response.ok)throw new Error(`HTTP ${response.status}: ${response.statusText}`);";
-  html += "const data=await response.json();";
-  html += "ledStates=data.leds||[];";
-  html += "retryCount=0;";
-  html += "updateUI();";
-  html += "updateStatus(true,'System Online');";
-  html += "}catch(error){";
-  html += "console.error('Connection error:',error);";
-  html += "retryCount++;";
-  html += "const message=retryCount>=maxRetries?'Connection Failed - Check Network':'Reconnecting...';";
-  html += "updateStatus(false,message);";
-  html += "if(retryCount<maxRetries)setTimeout(fetchStatus,2000);";
-  html += "}}";
-  
-  html += "function updateStatus(online,message){";
-  html += "const icon=document.getElementById('statusIcon');";
-  html += "const text=document.getElementById('statusText');";
-  html += "icon.className='status-icon '+(online?'online':retryCount<maxRetries?'warning':'');";
-  html += "text.textContent=message;";
-  html += "isConnected=online;";
-  html += "}";
-  
-  html += "function updateUI(){";
-  html += "const grid=document.getElementById('ledGrid');";
-  html += "if(!ledStates.length){grid.innerHTML='<div style=\"grid-column:1/-1;text-align:center;color:var(--neutral-500);font-style:italic;\">No LED channels detected</div>';return;}";
-  html += "grid.innerHTML='';";
-  html += "ledStates.forEach((led,index)=>{";
-  html += "const card=document.createElement('div');";
-  html += "card.className='led-card'+(led.isOn?' active':'');";
-  html += "card.innerHTML=`";
-  html += "<div class=\"led-header\">";
-  html += "<div class=\"led-title\">Channel ${index+1}</div>";
-  html += "<div class=\"led-status\">";
-  html += "<div class=\"status-dot${led.isOn?' on':''}\"></div>";
-  html += "<div class=\"status-label\">${led.isOn?'ACTIVE':'INACTIVE'}</div>";
-  html += "</div></div>";
-  html += "<div class=\"led-controls\">";
-  html += "<button class=\"control-btn btn-on\" onclick=\"controlLED(${index},true)\"><span>ON</span></button>";
-  html += "<button class=\"control-btn btn-off\" onclick=\"controlLED(${index},false)\"><span>OFF</span></button>";
-  html += "</div>`;";
-  html += "grid.appendChild(card);";
-  html += "});}";
-  
-  html += "async function controlLED(index,state){";
-  html += "if(!isConnected){updateStatus(false,'Not Connected - Cannot Control LEDs');return;}";
-  html += "const buttons=document.querySelectorAll(`[onclick*=\"controlLED(${index},\"]:not([disabled])`);";
-  html += "buttons.forEach(btn=>btn.disabled=true);";
-  html += "try{";
-  html += "const response=await fetch('/api/led',{";
-  html += "method:'POST',";
-  html += "headers:{'Content-Type':'application/json','Accept':'application/json'},";
-  html += "body:JSON.stringify({led:index,action:state?'on':'off'}),";
-  html += "timeout:3000";
-  html += "});";
-  html += "if(!response.ok)throw new Error(`Control failed: HTTP ${response.status}`);";
-  html += "setTimeout(fetchStatus,200);";
-  html += "}catch(error){";
-  html += "console.error('LED control error:',error);";
-  html += "updateStatus(false,'Control Error - Please Try Again');";
-  html += "}finally{";
-  html += "buttons.forEach(btn=>btn.disabled=false);";
-  html += "}}";
-  
-  html += "async function controlAllLEDs(state){";
-  html += "if(!isConnected){updateStatus(false,'Not Connected - Cannot Control LEDs');return;}";
-  html += "const buttons=document.querySelectorAll('.master-btn');";
-  html += "const allButtons=document.querySelectorAll('.control-btn');";
-  html += "buttons.forEach(btn=>btn.disabled=true);";
-  html += "allButtons.forEach(btn=>btn.disabled=true);";
-  html += "try{";
-  html += "const response=await fetch('/api/all',{";
-  html += "method:'POST',";
-  html += "headers:{'Content-Type':'application/json','Accept':'application/json'},";
-  html += "body:JSON.stringify({action:state?'on':'off'}),";
-  html += "timeout:5000";
-  html += "});";
-  html += "if(!response.ok)throw new Error(`Master control failed: HTTP ${response.status}`);";
-  html += "updateStatus(true,`All LEDs ${state?'Activated':'Deactivated'} Successfully`);";
-  html += "setTimeout(fetchStatus,300);";
-  html += "}catch(error){";
-  html += "console.error('Master control error:',error);";
-  html += "updateStatus(false,'Master Control Error - Please Try Again');";
-  html += "}finally{";
-  html += "setTimeout(()=>{";
-  html += "buttons.forEach(btn=>btn.disabled=false);";
-  html += "allButtons.forEach(btn=>btn.disabled=false);";
-  html += "},500);";
-  html += "}}";
-  
-  html += "function initializeSystem(){";
-  html += "updateStatus(false,'Connecting to LED Control System...');";
-  html += "fetchStatus();";
-  html += "setInterval(()=>{if(isConnected||retryCount<maxRetries)fetchStatus();},3000);";
-  html += "}";
-  
-  html += "document.addEventListener('DOMContentLoaded',initializeSystem);";
-  html += "document.addEventListener('visibilitychange',()=>{";
-  html += "if(!document.hidden&&!isConnected)fetchStatus();";
-  html += "});";
-  html += "</script></body></html>";
-  
-  server.send(200, "text/html", html);
+
+// True if a stream above the web priority currently owns the channel
+// (ALL_LEDS: any channel)
+bool streamHolds(int ledNum) {
+  if (!streamActive || streamPriority <= STREAM_WEB_PRIORITY ||
+      millis() - streamLastFrameTime >= STREAM_TIMEOUT_MS) {
+    return false;
+  }
+  return ledNum == ALL_LEDS || (ledNum >= streamFirst && ledNum < streamFirst + streamCount);
 }
 
-void handleGetStatus() {
-  DynamicJsonDocument doc(1024);
-  JsonArray ledsArray = doc.createNestedArray("leds");
+// LED engine task: owns the channel store, the effects heap and the outputs.
+// Everything below runs on the engine task only.
+void ledEngineTask(void* param) {
+  esp_pm_lock_acquire(engineCpuLock);
+  for (;;) {
+    runEngine();
+    waitForEngineEvent();
+  }
+}
+
+// One pass of the engine: queued commands, then whatever has fallen due
+void runEngine() {
+  uint32_t start = ESP.getCycleCount();
+  LEDCommand cmd;
+  while (popCommand(cmd)) {
+    executeCommand(cmd);
+  }
   
-  for (int i = 0; i < NUM_LEDS; i++) {
-    JsonObject led = ledsArray.createNestedObject();
-    led["isOn"] = ledStates[i].isOn;
-    led["blinkInterval"] = ledStates[i].blinkInterval;
+  // Nothing is run or published while a batch is only partly received
+  if (pendingOps == 0) {
+    runEffects();
+    runShow();
+    runFades();
+    flushOutputs();
+    if (snapshotDirty) {
+      publishSnapshot();
+      wakeLoop();
+    }
   }
   
-  String response;
-  serializeJson(doc, response);
-  server.send(200, "application/json", response);
+  recordLatency(engineLatency, start);
 }
 
-void handleLEDControl() {
-  if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No body\"}");
+void executeCommand(const LEDCommand& cmd) {
+  LEDAction action = (LEDAction)cmd.action;
+  if (action == ACTION_FRAME) {
+    applyFrame(streamFrames);
+    return;
+  }
+  if (action == ACTION_SCENE) {
+    applyFrame(sceneFrames);
+    return;
+  }
+  if (action == ACTION_SHOW) {
+    executeShowCommand(cmd);
     return;
   }
   
-  DynamicJsonDocument doc(512);
-  deserializeJson(doc, server.arg("plain"));
-  
-  int ledIndex = doc["led"];
-  String action = doc["action"];
-  int value = doc["value"];
+  if (cmd.ledNum == ALL_LEDS) {
+    for (int i = 0; i < NUM_LEDS; i++) {
+      applyLEDState(i, action, cmd.value);
+      pendingFadeMs[i] = cmd.fadeMs;
+    }
+    pendingOutputs.setAll();
+  } else {
+    applyLEDState(cmd.ledNum, action, cmd.value);
+    pendingFadeMs[cmd.ledNum] = cmd.fadeMs;
+    pendingOutputs.set(cmd.ledNum);
+  }
+  pendingOps++;
   
-  if (ledIndex < 0 || ledIndex >= NUM_LEDS) {
-    server.send(400, "application/json", "{\"error\":\"Invalid LED index\"}");
+  if (cmd.flags & CMD_DEFER) {
     return;
   }
   
-  if (action == "on") {
-    turnOnLED(ledIndex);
-  } else if (action == "off") {
-    turnOffLED(ledIndex);
-  } 
+  // Commit: all outputs touched by the command (or batch) are written, or
+  // start fading, together
+  for (int i = pendingOutputs.next(); i >= 0; i = pendingOutputs.next(i + 1)) {
+    startFade(i, pendingFadeMs[i]);
+  }
+  logCommand(cmd, pendingOps);
+  pendingOutputs.clear();
+  pendingOps = 0;
+}
+
+void logCommand(const LEDCommand& cmd, int ops) {
+  if (ops > 1) {
+    LOG_INFO(LOG_BATCH_APPLIED, ops);
+  } else if (cmd.ledNum == ALL_LEDS) {
+    LOG_INFO(LOG_ALL_LEDS, cmd.action);
+  } else if (cmd.action == ACTION_ON || cmd.action == ACTION_OFF) {
+    LOG_INFO(LOG_LED_SWITCHED, cmd.ledNum + 1, cmd.action);
+  } else {
+    LOG_INFO(LOG_LED_SET, cmd.ledNum + 1, cmd.action, cmd.value);
+  }
+}
+
+// Copies the channel state into the seqlock-protected snapshot. The
+// sequence number is odd while the copy is in progress.
+void publishSnapshot() {
+  uint32_t seq = snapshotSeq.load(std::memory_order_relaxed);
+  snapshotSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  
+  publishedSnapshot.version++;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    LEDStatus& status = publishedSnapshot.leds[i];
+    status.isOn = channels.isOn[i];
+    status.brightness = channels.brightness[i];
+    status.effect = channels.effect[i];
+    status.blinkInterval = channels.blinkInterval[i];
+  }
   
-  server.send(200, "application/json", "{\"success\":true}");
+  snapshotSeq.store(seq + 2, std::memory_order_release);
+  snapshotDirty = false;
 }
 
-void handleAllLEDs() {
-  if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No body\"}");
+// Updates the channel state only; writeLEDOutput() pushes it to the pin.
+// on/off cancel any running effect, blink/pulse/timer replace it.
+void applyLEDState(int ledNum, LEDAction action, long value) {
+  int64_t now = esp_timer_get_time();
+  switch (action) {
+    case ACTION_ON:
+    case ACTION_OFF:
+      channels.isOn[ledNum] = action == ACTION_ON;
+      channels.blinkInterval[ledNum] = 0;
+      channels.effect[ledNum] = EFFECT_NONE;
+      cancelEffect(ledNum);
+      break;
+    case ACTION_BLINK:
+      channels.isOn[ledNum] = true;
+      channels.blinkInterval[ledNum] = value;
+      channels.blinkState[ledNum] = true;
+      channels.effect[ledNum] = EFFECT_BLINK;
+      scheduleEffect(ledNum, now + value * 1000LL);
+      break;
+    case ACTION_PULSE:
+    case ACTION_TIMER:
+      if (action == ACTION_PULSE) {
+        channels.isOn[ledNum] = true;
+      }
+      channels.blinkInterval[ledNum] = 0;
+      channels.effect[ledNum] = action == ACTION_PULSE ? EFFECT_PULSE : EFFECT_TIMER;
+      scheduleEffect(ledNum, now + value * 1000LL);
+      break;
+    case ACTION_BRIGHTNESS:
+      channels.brightness[ledNum] = constrain(value, 0L, 255L);
+      break;
+    default:
+      return;
+  }
+  notifyLEDChange(ledNum);
+}
+
+// Takes the latest frame, if there is a new one, and writes its levels
+// straight into the channel store. Channels in the frame lose any effect
+// and fade together to their new levels.
+void applyFrame(FrameExchange& exchange) {
+  if (!(exchange.latest.load(std::memory_order_acquire) & FRAME_FRESH)) {
     return;
   }
+  exchange.readSlot = exchange.latest.exchange(exchange.readSlot, std::memory_order_acq_rel) & 3;
+  const LEDFrame& frame = exchange.frames[exchange.readSlot];
   
-  DynamicJsonDocument doc(256);
-  deserializeJson(doc, server.arg("plain"));
+  for (int i = 0; i < frame.count; i++) {
+    setChannelLevel(frame.first + i, frame.levels[i], frame.fadeMs);
+  }
+}
+
+// Sets a channel from a frame or keyframe level (0 = off, brightness kept)
+// and starts it fading there
+void setChannelLevel(int ledNum, uint8_t level, uint32_t fadeMs) {
+  if (channels.effect[ledNum] != EFFECT_NONE) {
+    applyLEDState(ledNum, ACTION_OFF, 0);
+  }
+  if (channels.isOn[ledNum] != (level > 0) || (level > 0 && channels.brightness[ledNum] != level)) {
+    channels.isOn[ledNum] = level > 0;
+    if (level > 0) {
+      channels.brightness[ledNum] = level;
+    }
+    notifyLEDChange(ledNum);
+  }
+  startFade(ledNum, fadeMs);
+}
+
+// Starts, pauses or stops the show clock. A start hands blocks read for any
+// other play back to loop() to be refilled; a pause or stop only those of
+// the play it ends, as loop() may already have filled some for the next.
+void executeShowCommand(const LEDCommand& cmd) {
+  if (cmd.flags == SHOW_PAUSE) {
+    for (int i = 0; i < NUM_LEDS; i++) {
+      holdFade(i);
+    }
+  }
+  uint32_t ended = showGeneration;
+  showGeneration = cmd.flags == SHOW_START ? (uint32_t)cmd.value : 0;
+  showStartUs = esp_timer_get_time() - cmd.fadeMs * 1000LL;
+  showReadBlock = 0;
+  showReadNext = 0;
+  showNextDue = -1;
+  for (int b = 0; b < 2; b++) {
+    ShowBlock& block = showBlocks[b];
+    bool stale = cmd.flags == SHOW_START ? block.generation != showGeneration : block.generation == ended;
+    if (block.full.load(std::memory_order_acquire) && stale) {
+      block.full.store(false, std::memory_order_release);
+    }
+  }
+  wakeLoop();
+}
+
+// Stops a fade where it is. The output stays at the full-precision level
+// reached; on/off and brightness keep the fade's target, so a paused show's
+// in-between levels are neither published nor saved.
+void holdFade(int ledNum) {
+  stopFade(ledNum);
+}
+
+// Marks the state as changed; the engine publishes a new snapshot once the
+// current command (or batch) has been committed
+void notifyLEDChange(int ledNum) {
+  snapshotDirty = true;
+}
+
+// 16-bit level the channel should show right now
+uint16_t targetLevel(int ledNum) {
+  bool lit = channels.isOn[ledNum] && (channels.effect[ledNum] != EFFECT_BLINK || channels.blinkState[ledNum]);
+  return lit ? channels.brightness[ledNum] * 257 : 0;
+}
+
+// Gamma-corrected duty for a 16-bit level, interpolated between table points
+uint32_t gammaDuty(uint16_t level) {
+  uint32_t index = level >> 8;
+  uint32_t frac = level & 0xFF;
+  uint32_t low = GAMMA_TABLE.duty[index];
+  uint32_t high = GAMMA_TABLE.duty[index + 1];
+  return low + (((high - low) * frac) >> 8);
+}
+
+void stopFade(int ledNum) {
+  if (channels.fadeTicks[ledNum] > 0) {
+    channels.fadeTicks[ledNum] = 0;
+    activeFades--;
+  }
+}
+
+// Jumps straight to the target level, cancelling any fade in progress
+void writeLEDOutput(int ledNum) {
+  stopFade(ledNum);
+  channels.level[ledNum] = (uint32_t)targetLevel(ledNum) << 16;
+  setOutputDuty(ledNum, gammaDuty(channels.level[ledNum] >> 16));
+}
+
+// Records the channel's new duty; nothing reaches the hardware until the
+// engine calls flushOutputs()
+void setOutputDuty(int ledNum, uint32_t duty) {
+  if (outputDuty[ledNum] == duty) {
+    return;
+  }
+  outputDuty[ledNum] = duty;
+  if (ledNum < dirtyLow) dirtyLow = ledNum;
+  if (ledNum > dirtyHigh) dirtyHigh = ledNum;
+}
+
+// Moves from the current level to the target over fadeMs. Fades shorter
+// than two ticks are applied immediately.
+void startFade(int ledNum, uint32_t fadeMs) {
+  uint32_t ticks = (uint32_t)(fadeMs * 1000LL / FADE_TICK_US);
+  if (ticks < 2) {
+    writeLEDOutput(ledNum);
+    return;
+  }
   
-  String action = doc["action"];
+  int64_t delta = ((int64_t)targetLevel(ledNum) << 16) - (int64_t)channels.level[ledNum];
+  if (channels.fadeTicks[ledNum] == 0) {
+    if (activeFades == 0) {
+      nextFadeTick = esp_timer_get_time() + FADE_TICK_US;
+    }
+    activeFades++;
+  }
+  channels.fadeStep[ledNum] = (int32_t)(delta / ticks);
+  channels.fadeTicks[ledNum] = ticks;
+}
+
+// Advances every fading channel by one step; integer only, no allocation
+void runFades() {
+  if (activeFades == 0) {
+    return;
+  }
+  int64_t now = esp_timer_get_time();
+  if (now < nextFadeTick) {
+    return;
+  }
+  nextFadeTick += FADE_TICK_US;
+  if (nextFadeTick <= now) {
+    nextFadeTick = now + FADE_TICK_US;
+  }
   
-  if (action == "on") {
-    turnOnAllLEDs();
-  } else if (action == "off") {
-    turnOffAllLEDs();
+  for (int i = 0; i < NUM_LEDS; i++) {
+    if (channels.fadeTicks[i] == 0) {
+      continue;
+    }
+    if (--channels.fadeTicks[i] == 0) {
+      // Land exactly on the target whatever the rounding of the step
+      channels.level[i] = (uint32_t)targetLevel(i) << 16;
+      activeFades--;
+    } else {
+      channels.level[i] += channels.fadeStep[i];
+    }
+    setOutputDuty(i, gammaDuty(channels.level[i] >> 16));
+  }
+}
+
+#if LED_BACKEND == BACKEND_LEDC
+
+// The PWM runs off the APB clock, which stops in light sleep, so light
+// sleep is held off while any channel is lit. The other backends' chips
+// keep their outputs by themselves.
+esp_pm_lock_handle_t ledcSleepLock;
+bool ledcSleepLocked = false;
+
+// The timers are set up here rather than through the Arduino core, whose
+// ledcAttachChannel() gives channel n timer (n / 2) % 4: only LEDC_TIMER is
+// configured in each group, and every channel is bound to it from the start.
+void setupOutputs() {
+  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "ledc", &ledcSleepLock);
+  for (int g = 0; g < LEDC_GROUPS; g++) {
+    ledc_timer_config_t timer = {};
+    timer.speed_mode = (ledc_mode_t)g;
+    timer.duty_resolution = (ledc_timer_bit_t)PWM_RESOLUTION;
+    timer.timer_num = LEDC_TIMER;
+    timer.freq_hz = PWM_FREQ;
+    timer.clk_cfg = LEDC_USE_APB_CLK;
+    ledc_timer_config(&timer);
+  }
+  for (int i = 0; i < NUM_LEDS; i++) {
+    // Also leaves the channel's fade registers set for plain duty writes
+    ledc_channel_config_t channel = {};
+    channel.gpio_num = LED_PINS[i];
+    channel.speed_mode = ledcGroup(i);
+    channel.channel = ledcChannel(i);
+    channel.timer_sel = LEDC_TIMER;
+    channel.duty = 0;
+    ledc_channel_config(&channel);
+  }
+  // Restart the groups' timers back to back so they overflow together
+  for (int g = 0; g < LEDC_GROUPS; g++) {
+    ledc_timer_rst((ledc_mode_t)g, LEDC_TIMER);
+  }
+}
+
+#if CONFIG_IDF_TARGET_ESP32
+// A new duty takes effect at the channel's next timer overflow; a
+// low-speed channel also needs its update bit
+template <int I>
+inline void writeLedcDuty(ledc_dev_t* hw) {
+  if (I < dirtyLow || I > dirtyHigh) {
+    return;
+  }
+  ledc_ll_set_duty_int_part(hw, ledcGroup(I), ledcChannel(I), outputDuty[I]);
+  ledc_ll_set_duty_start(hw, ledcGroup(I), ledcChannel(I), true);
+  ledc_ll_ls_channel_update(hw, ledcGroup(I), ledcChannel(I));
+}
+
+template <int... I>
+inline void writeLedcDuties(std::integer_sequence<int, I...>) {
+  ledc_dev_t* hw = LEDC_LL_GET_HW();
+  (writeLedcDuty<I>(hw), ...);
+}
+
+// Past the guard window the counter must have overflowed, unless the timer
+// is stopped or being reconfigured; the wait gives up after it either way
+void waitClearOfLatch() {
+  const uint32_t latchWindow = PWM_MAX_DUTY - LEDC_LATCH_GUARD_TICKS;
+  if (LEDC.timer_group[0].timer[LEDC_TIMER].value.timer_cnt < latchWindow) {
+    return;
+  }
+  int64_t giveUp = esp_timer_get_time() + LEDC_LATCH_GUARD_US + 1;
+  while (LEDC.timer_group[0].timer[LEDC_TIMER].value.timer_cnt >= latchWindow && esp_timer_get_time() < giveUp) {
+  }
+}
+#endif
+
+template <int... I>
+inline bool anyLedcLit(std::integer_sequence<int, I...>) {
+  return ((outputDuty[I] != 0) || ...);
+}
+
+// On the classic ESP32 all channels written in one flush latch at the same
+// overflow, so a change across the fixture shows up in a single PWM period.
+// Other chips lay out the LEDC registers differently and go through the
+// driver, each channel latching at its own next overflow.
+void flushOutputs() {
+  if (dirtyHigh < dirtyLow) {
+    return;
+  }
+#if CONFIG_IDF_TARGET_ESP32
+  waitClearOfLatch();
+  writeLedcDuties(std::make_integer_sequence<int, NUM_LEDS>());
+#else
+  for (int i = dirtyLow; i <= dirtyHigh; i++) {
+    ledc_set_duty(ledcGroup(i), ledcChannel(i), outputDuty[i]);
+    ledc_update_duty(ledcGroup(i), ledcChannel(i));
   }
+#endif
+  dirtyLow = NUM_LEDS;
+  dirtyHigh = -1;
   
-  server.send(200, "application/json", "{\"success\":true}");
+  bool lit = anyLedcLit(std::make_integer_sequence<int, NUM_LEDS>());
+  if (lit != ledcSleepLocked) {
+    ledcSleepLocked = lit;
+    if (lit) {
+      esp_pm_lock_acquire(ledcSleepLock);
+    } else {
+      esp_pm_lock_release(ledcSleepLock);
+    }
+  }
+}
+
+#elif LED_BACKEND == BACKEND_PCA9685
+
+const uint8_t PCA9685_MODE1 = 0x00;
+const uint8_t PCA9685_MODE2 = 0x01;
+const uint8_t PCA9685_LED0_ON_L = 0x06;
+const uint8_t PCA9685_PRESCALE = 0xFE;
+const uint8_t PCA9685_MODE1_SLEEP = 0x10;
+const uint8_t PCA9685_MODE1_AUTOINC = 0x20;
+const uint8_t PCA9685_MODE2_TOTEMPOLE = 0x04;
+const uint16_t PCA9685_FULL = 0x1000;  // full on/off bit of LEDn_ON/LEDn_OFF
+
+void writePCA9685Register(int chip, uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(PCA9685_BASE_ADDRESS + chip);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
 }
 
-void turnOnLED(int ledNum) {
-  if (ledNum >= 0 && ledNum < NUM_LEDS) {
-    ledStates[ledNum].isOn = true;
-    ledStates[ledNum].blinkInterval = 0;
-    ledcWrite(LED_PINS[ledNum], ledStates[ledNum].brightness);
-    Serial.println("LED " + String(ledNum + 1) + " turned ON");
+void setupOutputs() {
+  Wire.begin(PCA9685_SDA_PIN, PCA9685_SCL_PIN, PCA9685_I2C_CLOCK);
+  uint8_t prescale = (25000000UL + 2048UL * PWM_FREQ) / (4096UL * PWM_FREQ) - 1;
+  for (int chip = 0; chip < PCA9685_CHIPS; chip++) {
+    // The prescaler can only be written while the oscillator sleeps
+    writePCA9685Register(chip, PCA9685_MODE1, PCA9685_MODE1_SLEEP);
+    writePCA9685Register(chip, PCA9685_PRESCALE, prescale);
+    writePCA9685Register(chip, PCA9685_MODE1, PCA9685_MODE1_AUTOINC);
+    writePCA9685Register(chip, PCA9685_MODE2, PCA9685_MODE2_TOTEMPOLE);
   }
+  delay(1);
 }
 
-void turnOffLED(int ledNum) {
-  if (ledNum >= 0 && ledNum < NUM_LEDS) {
-    ledStates[ledNum].isOn = false;
-    ledStates[ledNum].blinkInterval = 0;
-    ledcWrite(LED_PINS[ledNum], 0);
-    Serial.println("LED " + String(ledNum + 1) + " turned OFF");
+// One I2C transaction per chip in the dirty range, using register
+// auto-increment. A chip latches all its outputs together on STOP.
+void flushOutputs() {
+  if (dirtyHigh < 0) {
+    return;
+  }
+  for (int chip = dirtyLow / 16; chip <= dirtyHigh / 16; chip++) {
+    int first = max(dirtyLow, chip * 16);
+    int last = min(dirtyHigh, chip * 16 + 15);
+    Wire.beginTransmission(PCA9685_BASE_ADDRESS + chip);
+    Wire.write(PCA9685_LED0_ON_L + 4 * (first - chip * 16));
+    for (int i = first; i <= last; i++) {
+      uint16_t on = 0;
+      uint16_t off = outputDuty[i];
+      if (off == 0) {
+        off = PCA9685_FULL;
+      } else if (off == PWM_MAX_DUTY) {
+        on = PCA9685_FULL;
+        off = 0;
+      }
+      Wire.write(on & 0xFF);
+      Wire.write(on >> 8);
+      Wire.write(off & 0xFF);
+      Wire.write(off >> 8);
+    }
+    Wire.endTransmission();
   }
+  dirtyLow = NUM_LEDS;
+  dirtyHigh = -1;
 }
 
+#elif LED_BACKEND == BACKEND_74HC595
 
+void setupOutputs() {
+  pinMode(SHIFT_LATCH_PIN, OUTPUT);
+  digitalWrite(SHIFT_LATCH_PIN, LOW);
+  SPI.begin(SHIFT_CLOCK_PIN, -1, SHIFT_DATA_PIN, -1);
+}
 
-void turnOffAllLEDs() {
+// The chain can only be loaded whole: every register is shifted in one SPI
+// transfer and the latch moves all outputs at the same instant
+void flushOutputs() {
+  if (dirtyHigh < 0) {
+    return;
+  }
+  static uint8_t bits[SHIFT_BYTES];
+  memset(bits, 0, sizeof(bits));
   for (int i = 0; i < NUM_LEDS; i++) {
-    ledStates[i].isOn = false;
-    ledStates[i].blinkInterval = 0;
-    ledcWrite(LED_PINS[i], 0);
+    if (outputDuty[i] != 0) {
+      // The first byte out ends up in the last register of the chain
+      bits[SHIFT_BYTES - 1 - i / 8] |= 1 << (i % 8);
+    }
   }
-  Serial.println("All LEDs turned OFF");
+  SPI.beginTransaction(SPISettings(SHIFT_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+  SPI.writeBytes(bits, SHIFT_BYTES);
+  SPI.endTransaction();
+  digitalWrite(SHIFT_LATCH_PIN, HIGH);
+  digitalWrite(SHIFT_LATCH_PIN, LOW);
+  dirtyLow = NUM_LEDS;
+  dirtyHigh = -1;
+}
+
+#elif LED_BACKEND == BACKEND_WS2812
+
+// One RMT symbol per bit, MSB first, plus a trailing low symbol for the
+// latch gap. Timings are in 100 ns ticks.
+const int WS2812_SYMBOLS = NUM_LEDS * 8 + 1;
+rmt_data_t ws2812Frame[WS2812_SYMBOLS];
+rmt_data_t ws2812Zero;
+rmt_data_t ws2812One;
+
+void setRMTSymbol(rmt_data_t& symbol, uint32_t highTicks, uint32_t lowTicks) {
+  symbol.level0 = highTicks > 0;
+  symbol.duration0 = highTicks > 0 ? highTicks : lowTicks / 2;
+  symbol.level1 = 0;
+  symbol.duration1 = highTicks > 0 ? lowTicks : lowTicks / 2;
+}
+
+void setupOutputs() {
+  rmtInit(WS2812_PIN, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, WS2812_RMT_HZ);
+  setRMTSymbol(ws2812Zero, 4, 8);
+  setRMTSymbol(ws2812One, 8, 4);
+  setRMTSymbol(ws2812Frame[WS2812_SYMBOLS - 1], 0, 3000);  // 300 us reset
 }
 
-void turnOnAllLEDs() {
+// A strip is always sent whole. The frame goes out on the RMT in the
+// background; the next flush waits for it if it is still transmitting.
+void flushOutputs() {
+  if (dirtyHigh < 0) {
+    return;
+  }
+  while (!rmtTransmitCompleted(WS2812_PIN)) {
+    vTaskDelay(1);
+  }
   for (int i = 0; i < NUM_LEDS; i++) {
-    ledStates[i].isOn = true;
-    ledStates[i].blinkInterval = 0;
-    ledcWrite(LED_PINS[i], ledStates[i].brightness);
+    uint8_t value = outputDuty[i];
+    for (int bit = 0; bit < 8; bit++) {
+      ws2812Frame[i * 8 + bit] = (value & (0x80 >> bit)) ? ws2812One : ws2812Zero;
+    }
+  }
+  rmtWriteAsync(WS2812_PIN, ws2812Frame, WS2812_SYMBOLS);
+  dirtyLow = NUM_LEDS;
+  dirtyHigh = -1;
+}
+
+#endif
+
+void swapEffects(int a, int b) {
+  std::swap(effectDue[a], effectDue[b]);
+  std::swap(effectLed[a], effectLed[b]);
+  effectHeapIndex[effectLed[a]] = a;
+  effectHeapIndex[effectLed[b]] = b;
+}
+
+void siftEffect(int pos) {
+  while (pos > 0 && effectDue[pos] < effectDue[(pos - 1) / 2]) {
+    swapEffects(pos, (pos - 1) / 2);
+    pos = (pos - 1) / 2;
+  }
+  while (true) {
+    int smallest = pos;
+    int left = 2 * pos + 1;
+    int right = left + 1;
+    if (left < effectHeapSize && effectDue[left] < effectDue[smallest]) smallest = left;
+    if (right < effectHeapSize && effectDue[right] < effectDue[smallest]) smallest = right;
+    if (smallest == pos) break;
+    swapEffects(pos, smallest);
+    pos = smallest;
+  }
+}
+
+// Sets (or moves) the channel's next deadline
+void scheduleEffect(int ledNum, int64_t due) {
+  int pos = effectHeapIndex[ledNum];
+  if (pos < 0) {
+    pos = effectHeapSize++;
+    effectLed[pos] = ledNum;
+    effectHeapIndex[ledNum] = pos;
+  }
+  effectDue[pos] = due;
+  siftEffect(pos);
+}
+
+void cancelEffect(int ledNum) {
+  int pos = effectHeapIndex[ledNum];
+  if (pos < 0) {
+    return;
+  }
+  effectHeapSize--;
+  if (pos != effectHeapSize) {
+    swapEffects(pos, effectHeapSize);
+    siftEffect(pos);
+  }
+  effectHeapIndex[ledNum] = -1;
+}
+
+// Fires every effect whose deadline has passed
+void runEffects() {
+  int64_t now = esp_timer_get_time();
+  while (effectHeapSize > 0 && effectDue[0] <= now) {
+    int ledNum = effectLed[0];
+    
+    if (channels.effect[ledNum] == EFFECT_BLINK) {
+      channels.blinkState[ledNum] = !channels.blinkState[ledNum];
+      writeLEDOutput(ledNum);
+      // Step from the deadline, not from now, so the period doesn't drift;
+      // periods missed entirely are skipped rather than replayed
+      int64_t period = channels.blinkInterval[ledNum] * 1000LL;
+      int64_t next = effectDue[0] + period;
+      if (next <= now) {
+        next = now + period;
+      }
+      scheduleEffect(ledNum, next);
+    } else {
+      applyLEDState(ledNum, ACTION_OFF, 0);
+      writeLEDOutput(ledNum);
+      LOG_INFO(LOG_LED_TIMER_EXPIRED, ledNum + 1);
+    }
+  }
+}
+
+// Applies every show keyframe that has fallen due. A used-up block goes
+// back to loop() for refilling and the other one takes over.
+void runShow() {
+  showNextDue = -1;
+  if (showGeneration == 0) {
+    return;
+  }
+  int64_t now = esp_timer_get_time();
+  for (;;) {
+    ShowBlock& block = showBlocks[showReadBlock];
+    if (!block.full.load(std::memory_order_acquire) || block.generation != showGeneration) {
+      return;
+    }
+    if (showReadNext == block.count) {
+      bool last = block.last;
+      int64_t end = showStartUs + (block.baseMs + block.endMs) * 1000;
+      if (last && end > now) {
+        showNextDue = end;
+        return;
+      }
+      block.full.store(false, std::memory_order_release);
+      showReadBlock ^= 1;
+      showReadNext = 0;
+      wakeLoop();
+      if (last) {
+        showEndedGeneration.store(showGeneration, std::memory_order_release);
+        showGeneration = 0;
+        return;
+      }
+      if (!showBlocks[showReadBlock].full.load(std::memory_order_acquire)) {
+        showUnderruns++;
+      }
+      continue;
+    }
+    
+    const ShowKeyframe& keyframe = block.keyframes[showReadNext];
+    int64_t due = showStartUs + (block.baseMs + keyframe.timeMs) * 1000;
+    if (due > now) {
+      showNextDue = due;
+      return;
+    }
+    recordMicros(showLateness, now - due);
+    int end = min<int>(keyframe.first + keyframe.count, NUM_LEDS);
+    for (int i = keyframe.first; i < end; i++) {
+      setChannelLevel(i, keyframe.level, keyframe.fadeMs);
+    }
+    showReadNext++;
+  }
+}
+
+// Blocks the engine until a command arrives or the next effect, fade
+// tick or show keyframe is due. The deadline is armed on a one-shot esp_timer, so it fires
+// to the microsecond instead of on the next scheduler tick.
+void waitForEngineEvent() {
+  if (pendingOps == 0 && (effectHeapSize > 0 || activeFades > 0 || showNextDue >= 0)) {
+    int64_t due = showNextDue >= 0 ? showNextDue : INT64_MAX;
+    if (effectHeapSize > 0 && effectDue[0] < due) {
+      due = effectDue[0];
+    }
+    if (activeFades > 0 && nextFadeTick < due) {
+      due = nextFadeTick;
+    }
+    int64_t untilDue = due - esp_timer_get_time();
+    if (untilDue <= 0) {
+      return;
+    }
+    esp_timer_start_once(effectTimer, untilDue);
+  }
+  esp_pm_lock_release(engineCpuLock);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  esp_pm_lock_acquire(engineCpuLock);
+  engineWakeups++;
+  esp_timer_stop(effectTimer);
+}
+
+// loop() side of the engine handoff: the status snapshot and loop()'s own
+// wait. Nothing below runs on the engine task except wakeLoop().
+
+// Web side: picks up a newly published snapshot. Costs a single atomic
+// load when nothing has changed.
+void syncSnapshot() {
+  if (snapshotSeq.load(std::memory_order_acquire) == statusSnapshotSeq) {
+    return;
+  }
+  
+  // Copied straight over the old snapshot, noting what differs on the way.
+  // A torn copy is retried; the marks it left stay, so a channel that ends
+  // up different from before is always marked (and at worst one that
+  // doesn't is reported again).
+  static ChannelMask changed;
+  changed.clear();
+  uint32_t seq;
+  do {
+    seq = snapshotSeq.load(std::memory_order_acquire);
+    statusSnapshot.version = publishedSnapshot.version;
+    for (int i = 0; i < NUM_LEDS; i++) {
+      LEDStatus a = publishedSnapshot.leds[i];
+      LEDStatus& b = statusSnapshot.leds[i];
+      if (a.isOn != b.isOn || a.brightness != b.brightness || a.effect != b.effect ||
+          a.blinkInterval != b.blinkInterval) {
+        changed.set(i);
+        b = a;
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != snapshotSeq.load(std::memory_order_relaxed));
+  
+  statusSnapshotSeq = seq;
+  stateChangeTime = millis();
+  
+  for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+    if (eventClients[c].active) {
+      eventClients[c].pendingLEDs.merge(changed);
+    }
+  }
+}
+
+// The eventfd loop() waits on besides its sockets, and the power
+// management setup. Runs before the engine starts.
+void setupLoopWait() {
+  esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+  esp_vfs_eventfd_register(&config);
+  loopWakeFd = eventfd(0, 0);
+  
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "loop", &loopCpuLock);
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "engine", &engineCpuLock);
+  esp_pm_lock_acquire(loopCpuLock);
+  if (!LIGHT_SLEEP) {
+    return;
+  }
+  esp_pm_config_t pm = {};
+  pm.max_freq_mhz = getCpuFrequencyMhz();
+  pm.min_freq_mhz = MIN_CPU_MHZ;
+  pm.light_sleep_enable = true;
+  lightSleepEnabled = esp_pm_configure(&pm) == ESP_OK;
+  if (lightSleepEnabled) {
+    LOG_INFO(LOG_LIGHT_SLEEP_ENABLED, MIN_CPU_MHZ, pm.max_freq_mhz);
+  } else {
+    // Automatic light sleep needs tickless idle compiled in
+    pm.light_sleep_enable = false;
+    esp_pm_configure(&pm);
+    LOG_WARN(LOG_LIGHT_SLEEP_UNAVAILABLE);
+  }
+}
+
+// Sleeps until a socket is ready, the engine or a WiFi event signals, or
+// the earliest deadline of the pumps comes up. Passes with work left over
+// (a pipelined request, a command the full queue turned away) don't wait.
+void waitForNextEvent() {
+  static LoopWait wait;
+  FD_ZERO(&wait.readSet);
+  FD_ZERO(&wait.writeSet);
+  wait.maxFd = -1;
+  wait.now = millis();
+  wait.waitUs = -1;
+  
+  wait.watchRead(loopWakeFd);
+  addWiFiWait(wait);
+  if (httpReady) {
+    server.addWait(wait);
+  }
+  addLongPollWait(wait);
+  addEventWait(wait);
+  if (streamSocket >= 0) {
+    wait.watchRead(streamSocket);
   }
-  Serial.println("All LEDs turned ON");
+  addFleetWait(wait);
+  addPersistenceWait(wait);
+  if (coalescedCount > 0 || playbackState == PLAYBACK_SEEKING) {
+    wait.dueIn(0);
+  }
+  if (wait.waitUs == 0) {
+    return;
+  }
+  
+  timeval timeout;
+  timeout.tv_sec = wait.waitUs / 1000000;
+  timeout.tv_usec = wait.waitUs % 1000000;
+  esp_pm_lock_release(loopCpuLock);
+  int64_t start = esp_timer_get_time();
+  int ready = select(wait.maxFd + 1, &wait.readSet, &wait.writeSet, nullptr,
+                     wait.waitUs > 0 ? &timeout : nullptr);
+  esp_pm_lock_acquire(loopCpuLock);
+  int64_t end = esp_timer_get_time();
+  loopIdleUs += end - start;
+  
+  bool signalled = ready > 0 && FD_ISSET(loopWakeFd, &wait.readSet);
+  if (signalled) {
+    uint64_t count;
+    read(loopWakeFd, &count, sizeof(count));
+    ready--;
+  }
+  if (ready > 0) {
+    loopWakeups[WAKE_NETWORK]++;
+    wakeTime = end;
+    wakeAnswered = false;
+  } else {
+    loopWakeups[signalled ? WAKE_SIGNAL : WAKE_DEADLINE]++;
+  }
+}
 
+// Cuts loop()'s wait short. Safe from any task.
+void wakeLoop() {
+  uint64_t one = 1;
+  write(loopWakeFd, &one, sizeof(one));
 }
@@ -0,0 +1,354 @@
+// Generated by tools/build_dashboard.py from data/index.html - do not edit.
+#pragma once
+
+#include <Arduino.h>
+
+// Minified page: 18383 bytes, gzip: 5460 bytes
+#define DASHBOARD_ETAG "\"a7428a074a6700d2\""
+
+const size_t DASHBOARD_HTML_GZ_LEN = 5460;
+
+const uint8_t DASHBOARD_HTML_GZ[] PROGMEM = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0xc5,0x5c,0xef,0x72,0xdb,0x48,
+  0x72,0x7f,0x15,0x2c,0xf7,0x4e,0x00,0x56,0x20,0x05,0x82,0x7f,0x24,0x91,0x02,0xbd,
+  0x5e,0x59,0xde,0x75,0xca,0xb6,0x5c,0x96,0x76,0x93,0x2b,0x97,0xea,0x0c,0x12,0x43,
+  0x12,0x67,0x10,0x60,0x00,0x50,0x12,0x97,0x66,0x55,0xde,0xe0,0xaa,0xf2,0x31,0x5f,
+  0x52,0xc9,0xb7,0xbc,0x41,0xf2,0x35,0x8f,0x72,0x2f,0x90,0x3c,0x42,0xba,0x7b,0x06,
+  0xc0,0xe0,0x0f,0x29,0xda,0xb5,0x77,0x39,0x9e,0x64,0x62,0xd0,0xe8,0xe9,0xe9,0xee,
+  0xf9,0xf5,0x9f,0x81,0xf6,0xe2,0x9b,0x17,0xd7,0x97,0xb7,0x7f,0x78,0x77,0xa5,0xcc,
+  0x93,0x85,0x3f,0xba,0xc0,0xdf,0x8a,0xef,0x04,0x33,0xbb,0xc1,0x82,0x06,0x5c,0x33,
+  0xc7,0x1d,0x5d,0x2c,0x58,0xe2,0x28,0x93,0xb9,0x13,0xc5,0x2c,0xb1,0x1b,0x3f,0xdf,
+  0xbe,0x6c,0x9e,0x35,0xc4,0x68,0xe0,0x2c,0x98,0xdd,0xb8,0xf7,0xd8,0xc3,0x32,0x8c,
+  0x92,0x86,0x32,0x09,0x83,0x84,0x05,0x40,0xf5,0xe0,0xb9,0xc9,0xdc,0x76,0xd9,0xbd,
+  0x37,0x61,0x4d,0xba,0x30,0x14,0x2f,0xf0,0x12,0xcf,0xf1,0x9b,0xf1,0xc4,0xf1,0x99,
+  0xdd,0x6e,0x99,0xc0,0x25,0xf1,0x12,0x9f,0x8d,0x5e,0x5f,0xbd,0x50,0x2e,0xe1,0xd1,
+  0x28,0xf4,0x95,0x9b,0x75,0x9c,0xb0,0x85,0x32,0x5e,0x2b,0xcf,0x83,0x19,0xf3,0xc3,
+  0x8b,0x13,0x4e,0x73,0xe1,0x7b,0xc1,0x27,0x25,0x62,0xbe,0xdd,0x58,0x46,0x0c,0x26,
+  0x0a,0xd8,0x04,0x66,0x9c,0x47,0x6c,0x6a,0x37,0xe6,0x49,0xb2,0x8c,0x07,0x27,0x27,
+  0x53,0x60,0x12,0xb7,0x66,0x61,0x38,0xf3,0x99,0xb3,0xf4,0xe2,0xd6,0x24,0x5c,0x34,
+  0xbe,0xe8,0xd1,0x38,0x71,0x12,0x6f,0x42,0xcf,0x29,0x93,0x28,0x8c,0xe3,0x30,0xf2,
+  0x66,0x5e,0x20,0x78,0x3c,0x3d,0xdb,0xc9,0x24,0x8e,0xad,0x67,0x53,0x67,0xe1,0xf9,
+  0x6b,0xfb,0x15,0x68,0x23,0x1a,0x3c,0xcc,0xe6,0xc9,0xf7,0x1d,0xd3,0x1c,0x76,0xe1,
+  0xa7,0x07,0x3f,0x7d,0xf8,0x39,0x85,0x9f,0x33,0xf8,0x39,0x37,0xcd,0x23,0xd7,0x8b,
+  0x97,0xbe,0xb3,0xb6,0xe3,0x07,0x67,0xd9,0xe0,0x72,0xc6,0xc9,0xda,0x67,0xf1,0x9c,
+  0xb1,0x04,0xc4,0xa7,0x8b,0xd1,0x20,0x0a,0xc3,0x64,0xd3,0x6c,0x2e,0x23,0x6f,0xe1,
+  0x44,0xeb,0xc1,0xb7,0x9d,0xf1,0x99,0x35,0xed,0x0f,0xb3,0x91,0xa6,0xeb,0x44,0x9f,
+  0x06,0xdf,0xb6,0x59,0xd7,0x74,0xa6,0xd2,0xb0,0xef,0x81,0x00,0x83,0x6f,0xfb,0xa6,
+  0xd3,0x9b,0x3a,0x30,0x1e,0xaf,0x26,0x13,0x16,0xc7,0x40,0x69,0x8e,0xcf,0xcf,0xda,
+  0xf9,0x88,0x60,0x60,0xf6,0xce,0xfb,0xfd,0x73,0x69,0x58,0x30,0xe8,0x74,0xdd,0xce,
+  0x39,0x8e,0xbb,0xe0,0x21,0xb0,0xae,0x6f,0xd9,0xb4,0x0b,0xff,0xcb,0x06,0xc4,0xe3,
+  0xee,0xc4,0xea,0x5b,0xfd,0x7c,0x54,0x3c,0x3d,0x3d,0x3b,0x6d,0x9f,0xe2,0x64,0x0f,
+  0x4e,0x14,0x78,0xc1,0x0c,0x46,0x7a,0xe7,0xcc,0x1c,0xe7,0x23,0xe9,0xf3,0xe7,0xa7,
+  0xa7,0x66,0x5f,0x1a,0x4e,0x19,0x8c,0xc7,0x53,0x0b,0x67,0x0b,0xd8,0x2a,0x89,0xc0,
+  0x8f,0x7a,0x26,0x0c,0x3a,0xf8,0x91,0x06,0xdb,0x26,0x8e,0xf6,0xf0,0x23,0x8d,0x5a,
+  0x38,0xca,0x7a,0xf8,0x91,0x46,0x3b,0x38,0xea,0x76,0xf1,0x23,0x8d,0x76,0x71,0xd4,
+  0xe9,0xe0,0xa7,0x30,0x19,0x8c,0x9e,0x76,0xf0,0x23,0x8d,0xf6,0x71,0xb4,0x67,0xe1,
+  0x47,0x1a,0x3d,0xc5,0xd1,0xae,0x89,0x1f,0x69,0xf4,0x0c,0x47,0x51,0x35,0xa4,0x9c,
+  0x74,0xf4,0x1c,0x47,0xdb,0xa8,0x9a,0x53,0x18,0x9d,0x45,0x8e,0xeb,0xc1,0x06,0xca,
+  0x8c,0x0c,0x5e,0xc7,0x9c,0x28,0x1b,0xd7,0xda,0x9d,0x9e,0xcb,0x66,0xc6,0xbd,0x13,
+  0x69,0x99,0x81,0x75,0xc5,0xfc,0x7d,0x71,0x84,0xab,0x4c,0x57,0x40,0x19,0xbf,0xd7,
+  0x65,0xb6,0xa9,0xe9,0xf7,0xb2,0x15,0x44,0x12,0xdb,0x82,0x23,0xd4,0xb0,0x15,0x0e,
+  0xb1,0x97,0x2b,0xa7,0x91,0x98,0xca,0xee,0x21,0xf1,0xf4,0x1d,0x98,0x68,0x3c,0x1b,
+  0x44,0xb3,0xb1,0xa3,0x59,0xbd,0x9e,0x91,0xfe,0x98,0xad,0xb3,0x9e,0x44,0x11,0x46,
+  0x2e,0x4c,0x59,0x43,0x65,0x21,0x51,0x3c,0x77,0xdc,0xf0,0xa1,0xf9,0x18,0x0f,0x4c,
+  0xa5,0xbd,0x7c,0x54,0x2c,0xf8,0x31,0x15,0xa0,0xd6,0x4c,0x05,0x3f,0x27,0x8a,0xd9,
+  0x32,0x7b,0x12,0x65,0xbc,0x10,0x94,0x9d,0x1a,0xca,0xb6,0x6e,0x28,0x39,0x9f,0x26,
+  0x7e,0x29,0x13,0xe4,0x9c,0x16,0x2e,0x70,0xea,0x02,0x49,0x7f,0x17,0x2d,0x32,0x43,
+  0x46,0x48,0xd4,0xb4,0xf6,0x32,0xf3,0x67,0x28,0x96,0x09,0x34,0xed,0x1e,0x52,0x77,
+  0x76,0xb0,0xcb,0xe6,0xeb,0xee,0x65,0xf7,0xe8,0x03,0x3b,0x0b,0xd9,0x59,0xc4,0xae,
+  0xb7,0x83,0xdd,0x19,0x4e,0x88,0x64,0xcd,0xfe,0x5e,0x7e,0x16,0x67,0x88,0x6c,0x7a,
+  0x44,0xde,0xae,0x2e,0xc7,0x02,0x35,0x6f,0xbf,0xdb,0x8c,0xc3,0xc7,0x66,0xec,0xfd,
+  0x8a,0x3b,0x9f,0xdb,0x0e,0x4c,0xf8,0x38,0x04,0x6f,0x05,0x74,0x1d,0x98,0xc3,0xa5,
+  0xe3,0xba,0x78,0xcf,0xdc,0x8e,0x43,0x77,0xbd,0x41,0x68,0x6d,0x72,0x14,0x1d,0xa8,
+  0x04,0xa3,0xaa,0x11,0x53,0x64,0x68,0xae,0x3c,0xa3,0xe9,0x2c,0x97,0x3e,0x6b,0xf2,
+  0x01,0xe3,0x07,0x84,0xe6,0x37,0xce,0x84,0x47,0x8e,0x97,0xf0,0xa4,0x11,0x3b,0x41,
+  0xdc,0x8c,0x59,0xe4,0x4d,0x87,0x63,0x67,0xf2,0x69,0x16,0x85,0xab,0xc0,0xdd,0xe5,
+  0x9f,0x00,0x4d,0x00,0x22,0x13,0xf4,0xcc,0x6f,0x99,0xc5,0xce,0xa6,0x26,0x2c,0x06,
+  0xbe,0x4f,0xc6,0x6e,0x8f,0xb5,0x85,0x67,0x2e,0xbc,0xa0,0x39,0x67,0x84,0x44,0x30,
+  0x70,0x3f,0x1f,0x4e,0x42,0x3f,0x8c,0x06,0xdc,0x95,0xa5,0x2d,0xae,0x0f,0x71,0x96,
+  0x8c,0xb4,0xd5,0x1f,0xd2,0x52,0x1e,0xf8,0x35,0x46,0x80,0x5c,0xa0,0xa6,0x93,0x24,
+  0xce,0x64,0xbe,0x00,0x59,0x06,0x53,0xef,0x91,0xb9,0x43,0xa0,0x1b,0x7f,0xf2,0x60,
+  0xe5,0xf8,0x4c,0xbc,0x00,0xc0,0x9f,0xa3,0x52,0x9c,0x00,0x03,0xa7,0xe7,0xc4,0x48,
+  0xb2,0x08,0x7f,0x6d,0x86,0xf1,0x63,0x99,0x06,0x56,0xb5,0xa6,0xc8,0xba,0x6d,0x61,
+  0x14,0x76,0x40,0x8a,0x68,0xb3,0x70,0x1e,0x79,0xf4,0x1d,0xb4,0x61,0xea,0x65,0xae,
+  0x6f,0xc5,0x59,0x25,0x61,0xa6,0xf4,0x0e,0x5a,0xcd,0xea,0xe2,0xfd,0xf2,0x32,0x45,
+  0x6c,0x1a,0x4c,0x7d,0xf6,0x38,0xc4,0x5f,0x4d,0xd7,0x83,0x18,0x9a,0x78,0x61,0x30,
+  0x00,0x15,0xac,0x16,0xc1,0x70,0xe6,0x2c,0x89,0xc3,0xb6,0x85,0xf9,0x02,0xcc,0x9a,
+  0x3e,0xa3,0xd0,0x43,0x20,0xf8,0x2c,0x68,0x7a,0x60,0x9a,0x78,0x30,0x61,0x68,0xca,
+  0x6c,0x5e,0xee,0x63,0xe8,0x8f,0x43,0x94,0x7a,0xb1,0x74,0x02,0xc0,0xae,0x70,0x16,
+  0x6e,0xb8,0xd0,0x67,0x78,0x47,0x88,0x73,0x96,0x8b,0xdf,0x8c,0xb8,0x80,0xe0,0x76,
+  0xb2,0x79,0xb9,0x2d,0xca,0x10,0xaa,0x0f,0x85,0xbb,0xe1,0xf8,0x2a,0x1e,0xd0,0x6c,
+  0x85,0x55,0xd5,0x08,0xf8,0xa7,0x55,0x9c,0x78,0xd3,0x75,0x53,0xe4,0x33,0xe9,0x30,
+  0xf9,0x30,0x79,0xbe,0x98,0x2c,0xdb,0xa5,0xfa,0x70,0x19,0xc6,0x1e,0x69,0x05,0xe2,
+  0x37,0xa4,0x10,0xf7,0xac,0xb8,0xa2,0xc1,0x60,0xcc,0xa6,0x61,0xc4,0x36,0x29,0x4b,
+  0xf5,0x2f,0xff,0xf2,0x6f,0x2a,0x77,0x0e,0xd8,0x16,0x0c,0x5c,0x03,0xe4,0xe2,0x4e,
+  0xf5,0x30,0x07,0x61,0x86,0x53,0xcf,0xc7,0xec,0xc1,0x8d,0xc2,0xa5,0x98,0x47,0xcb,
+  0x61,0x83,0x70,0xcf,0x34,0xe8,0x03,0x3b,0x52,0xcf,0x27,0xc3,0x94,0x6c,0x23,0xb1,
+  0x85,0x27,0x0a,0x2e,0x08,0x01,0xa7,0xd6,0x77,0xcf,0xd1,0x77,0x85,0x7e,0xc7,0x61,
+  0x92,0x84,0x8b,0x01,0x6e,0xe6,0xa1,0xcf,0x12,0x10,0xa3,0x19,0x2f,0x9d,0x09,0x9a,
+  0xac,0x09,0xb8,0x69,0xb1,0xc5,0x01,0xdb,0xaa,0xca,0xbe,0x34,0x04,0xc1,0x53,0xd7,
+  0x33,0x97,0x97,0xb6,0xc5,0xc4,0xf7,0x96,0x83,0x84,0x3d,0x26,0xd9,0x4d,0xbc,0x68,
+  0x82,0x42,0xfc,0x26,0x17,0x1d,0x9e,0x0f,0x40,0xa2,0x08,0xa6,0x1b,0xd6,0x3d,0xb8,
+  0x6d,0x25,0xce,0x0c,0xe5,0x92,0x34,0xd1,0xee,0x66,0x0a,0x2e,0xca,0xd1,0xc3,0x95,
+  0xcb,0x2a,0xc2,0x1c,0x8d,0x66,0xa4,0x69,0xc0,0x6a,0x8b,0xc1,0x6a,0xb9,0x64,0xd1,
+  0x04,0x36,0x60,0x59,0x1f,0xa0,0x7d,0xd0,0x46,0x88,0x57,0xc9,0x1a,0xae,0xce,0xb6,
+  0x2d,0x4c,0x21,0x57,0x71,0x73,0xe2,0x44,0xee,0xe6,0x2b,0x1d,0x8d,0x26,0xe6,0xee,
+  0xe4,0xf8,0x3e,0x80,0x68,0x27,0x56,0x26,0xab,0xb1,0x37,0x69,0x8e,0xd9,0xaf,0x1e,
+  0x8b,0x34,0xb3,0xd5,0x25,0xd3,0x5b,0x46,0xbb,0xc6,0xf5,0x86,0xe1,0x3d,0x8b,0xa6,
+  0x3e,0xb8,0xe9,0xdc,0x73,0x5d,0x16,0x14,0x64,0xaa,0x7a,0xa2,0x9a,0x73,0x70,0xc6,
+  0x31,0x6c,0x6a,0xf0,0x3e,0x2f,0x80,0x6c,0x7f,0x60,0xee,0xb3,0x73,0x97,0xcc,0x2c,
+  0x99,0x42,0xe9,0x00,0x6c,0xd6,0x44,0xe4,0xb6,0x4e,0x80,0x2a,0x53,0x9e,0x22,0xa6,
+  0xe6,0xea,0xa5,0x6f,0x20,0x3b,0xfb,0x07,0xad,0xc9,0xf1,0x56,0xd2,0x40,0x46,0x06,
+  0x7a,0xe8,0xc7,0x0a,0x43,0x2b,0xfc,0xda,0xf4,0x02,0x97,0x3d,0x42,0xb8,0x28,0x2c,
+  0x6d,0x8e,0x0b,0xcf,0x16,0x58,0xcb,0x9f,0xd8,0xe7,0x4f,0x71,0x1d,0x3c,0x69,0x27,
+  0xc4,0xb8,0x36,0xc4,0xc2,0x1a,0x5d,0xa7,0xa2,0xb4,0x33,0xa6,0x1e,0x70,0x15,0x08,
+  0x46,0xcf,0xa4,0x80,0x8a,0xdf,0x8b,0x60,0x04,0x6a,0xa9,0x22,0x98,0xc8,0x94,0x38,
+  0xda,0xc6,0xf3,0x08,0xa2,0x1b,0x06,0xc8,0xca,0xc4,0x75,0x4e,0x82,0xca,0x29,0xc8,
+  0x31,0x18,0x38,0x53,0x58,0xc0,0x21,0xc6,0xc6,0xdc,0x61,0xbf,0x7c,0x5e,0x30,0x87,
+  0x98,0x9a,0x48,0xee,0x6e,0x0d,0x9d,0x00,0x60,0x96,0xd8,0x2d,0x57,0x7e,0xcc,0x14,
+  0x2b,0x86,0x42,0x6f,0x8a,0xb5,0x5e,0x51,0x90,0x56,0x18,0xd0,0x86,0xac,0x2c,0x37,
+  0x4d,0x37,0x8b,0xd4,0x22,0xf9,0xaf,0x92,0x8b,0x1b,0x39,0x39,0xee,0x54,0x79,0x9b,
+  0x9f,0x95,0x00,0xaf,0xbf,0x03,0xf0,0x4e,0x71,0xdb,0x4b,0x3a,0x24,0x1a,0x49,0x8b,
+  0xdf,0x7f,0x62,0xeb,0x69,0x04,0x68,0x1a,0x2b,0xb4,0xb2,0x0d,0xb8,0x30,0x3a,0x8f,
+  0xe4,0x56,0x14,0x6f,0x35,0xd8,0x81,0x92,0x42,0xb6,0xbd,0x3a,0x12,0xcc,0x4a,0x73,
+  0xa2,0xf6,0x96,0x07,0x69,0xa8,0x77,0x61,0x3b,0x79,0x39,0x4c,0xe0,0xc5,0x10,0x7f,
+  0xc1,0xaa,0x16,0x4b,0x74,0xd8,0x26,0x0f,0xb2,0x31,0x98,0x7d,0xc9,0x9c,0x44,0xc3,
+  0xb8,0x4d,0x48,0x68,0x40,0xa8,0x86,0xf0,0xae,0x75,0x30,0x30,0x1a,0xed,0x69,0x04,
+  0x58,0x8a,0x5e,0x4a,0x61,0x5c,0xf6,0x60,0x50,0x53,0x04,0x80,0xe8,0x33,0x97,0x43,
+  0x52,0x35,0x62,0x8a,0x94,0x5b,0x27,0x53,0x53,0xbc,0x11,0xb1,0x67,0xec,0xaf,0x22,
+  0x0d,0x03,0x66,0x1a,0x44,0x07,0x98,0xce,0x82,0xd3,0x78,0xae,0x52,0x78,0x96,0x6e,
+  0xd6,0x46,0xda,0x34,0xd4,0x5b,0x67,0xe4,0x5c,0xf5,0xf1,0x73,0xe1,0xea,0x07,0xfa,
+  0xf7,0x6e,0x10,0xac,0x40,0x5e,0xba,0xe0,0xdf,0x0c,0xef,0x44,0x5c,0xab,0x05,0x38,
+  0x19,0xdc,0x24,0x4b,0xcb,0x6b,0x10,0x83,0xb9,0x87,0xc9,0x20,0x96,0x09,0x4b,0x08,
+  0x56,0x87,0x5c,0x7f,0xd0,0x70,0x7f,0xea,0x3b,0x75,0xf8,0xe8,0x67,0xfa,0xe7,0xde,
+  0x4e,0x72,0xf6,0xce,0x8d,0x76,0xc7,0x34,0xac,0x6e,0x1f,0xc4,0xec,0xe8,0xe5,0x89,
+  0x32,0xdd,0xa4,0x12,0xb7,0x73,0x8a,0x96,0x33,0x41,0x33,0x6c,0x0a,0x4c,0x8b,0x5b,
+  0x56,0x16,0x86,0x17,0x0d,0x94,0x49,0x36,0xcf,0xd2,0x0c,0xa5,0xdd,0x37,0xda,0x67,
+  0x3d,0xa3,0x6d,0x9d,0x97,0xa6,0x17,0xcc,0xbf,0x00,0x9d,0x0e,0x36,0x4d,0x61,0x4e,
+  0xa8,0xf1,0x8a,0xa6,0x29,0xe9,0xbc,0x94,0xb1,0x12,0xfc,0x97,0x63,0x32,0x86,0x7a,
+  0x06,0x3e,0x97,0x3c,0x30,0x16,0xd4,0x05,0x87,0x62,0xd6,0x44,0x1b,0x70,0x6f,0x98,
+  0xc0,0x89,0xa9,0xa9,0x25,0xc1,0x16,0x6d,0x16,0x19,0xb6,0x4e,0xf7,0xe5,0x69,0x07,
+  0x85,0x2b,0x4a,0xc9,0xb3,0xb9,0xaa,0xdb,0xe0,0x7f,0xff,0xf5,0x9f,0x0b,0x19,0x28,
+  0x21,0x67,0x0e,0x52,0xa7,0xfc,0x61,0x8e,0xb2,0x87,0x05,0x48,0x79,0xc3,0x53,0x09,
+  0x59,0x8d,0x78,0x94,0x53,0x4a,0x96,0xac,0xd9,0x4d,0xbd,0x1d,0x40,0x84,0xec,0x73,
+  0xd8,0x77,0xc3,0x24,0x8d,0xb1,0x96,0x14,0x63,0xad,0xc3,0x62,0xac,0xd4,0x02,0xd2,
+  0xbf,0x26,0xb4,0xc2,0xec,0x5f,0x12,0x59,0xad,0x2f,0x8f,0xac,0x9d,0x61,0x39,0x88,
+  0x98,0x3b,0xb3,0xa2,0x1a,0xe9,0x20,0xdc,0x1e,0x10,0x6a,0x39,0x61,0xba,0x92,0x6a,
+  0xd4,0x02,0x53,0xe4,0xf1,0x3d,0xf2,0xb0,0xea,0x56,0x60,0xb4,0x26,0xc4,0xfb,0xce,
+  0x98,0xf9,0x72,0x18,0xee,0x1c,0x18,0x86,0xfb,0x14,0x86,0x0f,0xce,0xb6,0xcd,0x1e,
+  0x5b,0xc8,0xa1,0x99,0x0b,0xb5,0xa9,0x8d,0xb9,0x3d,0x39,0xe6,0x76,0xb6,0xb5,0xc1,
+  0xdb,0x2a,0x50,0x6d,0x05,0x42,0xf1,0xd8,0x1c,0x1f,0x12,0x97,0x21,0xf2,0x2a,0xf0,
+  0x73,0x60,0x86,0x98,0x46,0xfd,0x71,0x12,0x6c,0xd2,0x9d,0x82,0x4f,0xf1,0xea,0x5b,
+  0x04,0x59,0x2b,0x0d,0xb2,0x75,0x7b,0x47,0x52,0x71,0xaf,0x0e,0x32,0x56,0x51,0x0c,
+  0x3a,0x5e,0x86,0x5e,0x7d,0x21,0x61,0xed,0x8b,0xa1,0x64,0x06,0xda,0xdc,0x59,0x21,
+  0xf2,0x45,0x86,0x79,0xba,0x12,0x91,0x7d,0x9e,0xca,0xdc,0x82,0x4a,0xfe,0xf6,0xa5,
+  0x49,0xe7,0xaf,0x5a,0x9a,0xc8,0x4b,0xdb,0x17,0xd8,0xad,0x7d,0x81,0xdd,0x9f,0xe9,
+  0x35,0x9c,0x0e,0x2a,0x72,0xe4,0xa7,0x44,0x34,0xaf,0x15,0xa0,0x80,0x2c,0x4d,0x77,
+  0x15,0xf1,0x0d,0x0f,0x89,0x4d,0x5c,0x64,0x02,0xfb,0xc1,0x19,0xc3,0x0e,0xd9,0xe4,
+  0xfb,0xaa,0x97,0xba,0x5c,0x10,0xa2,0xef,0x80,0xa9,0x99,0x2b,0xa9,0x2f,0x08,0x83,
+  0xa2,0x8d,0x15,0xd0,0x33,0xf8,0xfe,0xbe,0x4d,0x02,0x54,0xcd,0x3a,0xf8,0x2a,0xb7,
+  0xb1,0x4b,0x09,0x4f,0x29,0x37,0x91,0x7a,0x29,0x29,0x4b,0x61,0x84,0xdd,0x4f,0xd1,
+  0x11,0x44,0x4d,0x5a,0xc3,0xbb,0xa5,0xf5,0x69,0x4d,0x57,0x17,0xec,0xa7,0xd3,0x3d,
+  0x22,0xa7,0x45,0x5d,0xcd,0xdc,0xe9,0xad,0xaa,0xc0,0xd3,0xe9,0x6e,0x89,0xa5,0x33,
+  0x97,0xa7,0x05,0xb6,0x3a,0xe7,0x46,0xff,0x0c,0xff,0xcf,0xe5,0x5d,0x38,0x71,0x42,
+  0xfc,0x0e,0xc7,0xb9,0x62,0xfd,0x91,0xa4,0xe5,0x87,0x65,0xd6,0x94,0x1f,0x79,0xdb,
+  0xb1,0x5f,0xd7,0x75,0xdc,0x67,0x7b,0x21,0x99,0x8c,0x8f,0xd4,0xaf,0xa6,0xf6,0x98,
+  0xc0,0xc7,0xce,0x2e,0x7c,0xec,0x17,0xf1,0xb1,0x5c,0x09,0x9e,0x1d,0x82,0x8f,0xbd,
+  0x27,0x01,0xf2,0xe0,0xae,0xd0,0x97,0xa3,0xe1,0xbe,0x0a,0x49,0xd6,0xcd,0xdf,0x1e,
+  0x28,0xbb,0x7f,0x55,0xa0,0x94,0x56,0xb6,0x0f,0x27,0x3b,0xfb,0x70,0xd2,0x82,0x0a,
+  0xa8,0xca,0xe9,0x20,0x9c,0x94,0x1e,0xda,0x07,0x93,0x78,0x98,0xb3,0x0f,0x29,0x25,
+  0x36,0x35,0x40,0xd9,0x3f,0x04,0x28,0x73,0x16,0x4f,0xe2,0xe4,0xd7,0x36,0xb1,0x71,
+  0x97,0x9e,0x61,0x69,0x20,0xe6,0xfa,0x8d,0x91,0x36,0xe3,0xfa,0x55,0x60,0x4b,0xb9,
+  0x50,0xb7,0x70,0x94,0x54,0x03,0xb7,0xd9,0x1c,0xa4,0xa4,0xfa,0xd6,0x7a,0x4e,0xf5,
+  0x9b,0xe2,0x72,0xce,0xf4,0x6b,0xa0,0xb9,0x76,0x79,0x3b,0xc0,0x19,0xa6,0xd8,0xb5,
+  0xbc,0x3f,0xff,0xd7,0xff,0xfc,0xe7,0x9f,0x61,0x85,0xd3,0x30,0xa4,0xbc,0xbd,0x92,
+  0xb6,0xc9,0x07,0x3b,0x4f,0xf4,0xbc,0xeb,0x53,0x49,0x6c,0x81,0x7f,0xbf,0x60,0xae,
+  0xe7,0x28,0x9a,0x74,0x88,0x64,0x22,0xbc,0xeb,0x1b,0xe9,0x84,0x29,0x03,0xe9,0x6e,
+  0x5a,0xef,0xa5,0x51,0xa0,0xd4,0xe2,0xfa,0xc2,0xae,0x96,0x55,0x0a,0x2b,0x70,0xb9,
+  0xdd,0x56,0x25,0x3a,0xed,0x9f,0xed,0x10,0x28,0x97,0xc5,0x94,0x8e,0xa6,0x2a,0x27,
+  0x5e,0x3b,0x0f,0x4e,0xf8,0x89,0x56,0xcd,0xa1,0x54,0xbf,0x9b,0x97,0x9b,0xfd,0x6e,
+  0x99,0x28,0xb3,0x56,0x95,0xd3,0x93,0xca,0x90,0xcb,0x08,0xa9,0x61,0x27,0xab,0x38,
+  0xf3,0x8e,0x98,0x9f,0xc1,0x6d,0xe4,0xfe,0x5a,0x35,0xae,0x1f,0x32,0x4f,0x4d,0xc4,
+  0x25,0x37,0xed,0x94,0xaa,0x8d,0x7e,0xbd,0x05,0xba,0xd8,0x7f,0x04,0x0b,0x94,0x14,
+  0x9c,0xf9,0xc3,0x4e,0x05,0x73,0x89,0xe5,0xc3,0x92,0xe2,0x42,0x0b,0x85,0x58,0xde,
+  0xd0,0xa8,0xad,0xa0,0xba,0xe9,0x31,0x62,0xf1,0xb8,0x67,0xb7,0xb6,0xcc,0x5d,0x2b,
+  0xef,0xa6,0xb5,0x58,0x71,0x73,0x6c,0xb7,0x17,0x27,0xfc,0x35,0x9c,0x8b,0x13,0xfe,
+  0x56,0x14,0x1e,0x53,0x8f,0x2e,0x5c,0xef,0x5e,0x99,0x60,0x0f,0xd4,0x6e,0x64,0x2e,
+  0x28,0x5e,0x9c,0x62,0x51,0x7a,0x87,0x5f,0x35,0x4a,0xd4,0xb9,0xcf,0xc0,0x9d,0x13,
+  0xb8,0x05,0x8f,0xb5,0xcb,0xb7,0x51,0x67,0x8d,0xd1,0x6b,0x74,0xb6,0x9b,0x75,0x30,
+  0x81,0xc9,0xdb,0x42,0x02,0x16,0x15,0xf8,0x49,0x7a,0x6c,0x28,0x9e,0x0b,0x03,0x74,
+  0x1a,0x7e,0x43,0xc3,0x8d,0x5a,0x52,0x0e,0x27,0xb5,0xf7,0xb0,0x05,0x2f,0xd8,0xd0,
+  0xc0,0x2b,0xbc,0x4e,0xa5,0xac,0x92,0x23,0x00,0xc9,0xe4,0xb7,0x78,0x3d,0x7a,0xc5,
+  0xdf,0xf7,0xa2,0x33,0x7f,0x85,0x8b,0xd3,0x6a,0xb5,0x04,0x13,0xf9,0x77,0x49,0x89,
+  0xe9,0x2e,0xe1,0x1c,0xc1,0x0d,0x7e,0xc4,0x8b,0x1a,0xe2,0xa2,0x71,0x1b,0x75,0xf7,
+  0x52,0x07,0x82,0x9b,0xe3,0x55,0x92,0x40,0xc4,0x28,0xde,0xc7,0x40,0x9b,0x45,0x93,
+  0x86,0x12,0x06,0x13,0xdf,0x9b,0x7c,0xca,0xe4,0x78,0xee,0xfb,0xaf,0xaf,0x5e,0xc4,
+  0x5a,0x12,0xad,0x98,0x8e,0x6f,0x62,0x81,0x51,0x46,0xef,0x20,0x72,0x47,0x0a,0xdc,
+  0x52,0xae,0xdf,0x82,0x57,0xe0,0xd0,0xc5,0x09,0xe7,0x7e,0xc0,0x2c,0xd3,0xe9,0xee,
+  0x69,0xa6,0x8e,0x1f,0xd7,0xce,0xf3,0xf2,0x65,0x65,0x22,0x59,0x81,0x3c,0x0e,0xa4,
+  0x93,0xf2,0xab,0xc6,0xe8,0xbf,0xff,0x03,0xf6,0x84,0xd5,0x53,0x32,0xef,0x51,0xfe,
+  0xf2,0x4f,0xff,0xae,0xbc,0x0a,0x6f,0x95,0x1b,0xcc,0x0f,0x41,0x65,0xb1,0xfc,0x9a,
+  0x1d,0x7f,0x2c,0x65,0x19,0x4f,0x22,0x6f,0x99,0x8c,0x20,0xaf,0x55,0xc0,0x02,0xe8,
+  0x46,0x2c,0xb6,0x3f,0xdc,0x61,0xa2,0xab,0x78,0xf1,0x25,0x7f,0x87,0x8e,0xb9,0x36,
+  0x89,0x4c,0xa3,0x11,0x4b,0xa2,0xf5,0x25,0xc4,0xd8,0xc4,0xc6,0x4e,0x4f,0x10,0x27,
+  0xb0,0xe6,0xc7,0xf7,0x30,0xea,0xc1,0xa3,0x1d,0xa2,0x61,0xf7,0xe0,0x71,0x37,0xe1,
+  0x2a,0x9a,0x30,0x3b,0x58,0xf9,0x3e,0x0d,0x72,0x9f,0xf9,0x85,0x45,0x31,0x88,0x94,
+  0x3d,0xfb,0xcb,0xab,0xf7,0xb7,0x3f,0x3f,0x7f,0xfd,0xc7,0xdb,0x9f,0xde,0x5f,0xdd,
+  0xfc,0x74,0xfd,0xfa,0x85,0xdd,0xef,0x8a,0x5b,0xd7,0xbf,0x5c,0xbd,0xbf,0xb9,0x7c,
+  0xfe,0xf6,0x8f,0xef,0xaf,0xff,0xfe,0xc6,0xb6,0x88,0x09,0x3a,0x7e,0x6c,0x07,0xec,
+  0x41,0x79,0xe3,0x2c,0x35,0x5d,0x48,0x04,0x99,0x52,0xc4,0xdc,0x94,0x75,0xb3,0x4d,
+  0xc3,0x2b,0x0f,0x96,0xe3,0x33,0x49,0x74,0x58,0x6c,0xe8,0xfb,0xef,0x80,0x1c,0x5c,
+  0x55,0x8c,0xf3,0xa9,0x20,0xbf,0x0a,0x57,0x89,0xbd,0xc9,0xa0,0xd3,0x88,0xc2,0x87,
+  0x9f,0x38,0xf8,0x9b,0xdb,0xe1,0x74,0x15,0x90,0xef,0x29,0x2e,0x9b,0x84,0x2e,0xbb,
+  0xc4,0x5d,0x3b,0x49,0x34,0xd7,0x49,0x1c,0x7d,0xc3,0x39,0xb0,0xe9,0x14,0x34,0x05,
+  0xba,0x53,0x31,0xc3,0x53,0x0d,0x75,0x8c,0xaf,0xab,0xc0,0xbf,0x74,0xa8,0x04,0xff,
+  0x26,0xde,0x82,0x45,0xea,0x5d,0x3a,0x21,0x73,0x49,0xcf,0x10,0x43,0x34,0xd2,0x35,
+  0x28,0xc4,0xbb,0x40,0x86,0x80,0x7c,0xa0,0xdb,0xa1,0x77,0x7c,0xac,0x6f,0x90,0xaa,
+  0xb5,0x5c,0xc5,0x73,0x0d,0xbf,0x0e,0x3c,0xc3,0x8b,0xaf,0x83,0x81,0xa6,0x2d,0xf1,
+  0x25,0xcd,0x57,0x01,0x97,0xa0,0x15,0x06,0x1f,0xbc,0xd1,0xc8,0xba,0x33,0xda,0x7d,
+  0x7d,0x34,0xd2,0xbc,0xa3,0x8e,0xae,0x1f,0xb5,0x75,0xdb,0xb6,0xdb,0xc6,0x98,0xde,
+  0xa1,0x08,0xf0,0x65,0xb0,0xe2,0x43,0xf9,0x8d,0x56,0xbc,0x1a,0xc7,0x49,0xa4,0x79,
+  0xdf,0x59,0x86,0xa5,0x23,0x13,0x83,0x2f,0x66,0x20,0xd6,0xf4,0xe1,0x98,0x9e,0xe0,
+  0x57,0x1f,0xbc,0xbb,0xbb,0xad,0x3e,0xdc,0x82,0x1b,0xac,0xa2,0x80,0xd6,0x31,0xdc,
+  0x3a,0x31,0xba,0x5d,0xa6,0xa5,0x29,0x4b,0x26,0x73,0x0e,0x49,0x9a,0x0e,0x39,0xf6,
+  0x5a,0xe8,0x28,0x62,0xf1,0x12,0xbe,0x30,0xdb,0x79,0x70,0xbc,0x84,0x93,0x69,0xea,
+  0x89,0xb3,0xf4,0x4e,0xb8,0x73,0x3c,0xc3,0x14,0xd9,0x49,0xec,0x09,0x57,0xb0,0x7a,
+  0xac,0x15,0x9c,0xe6,0x99,0x7a,0x14,0x7b,0x01,0xf8,0x94,0x7a,0x5c,0x18,0x87,0xb2,
+  0x48,0x37,0x36,0x0b,0x96,0xcc,0x43,0x77,0xa0,0xfe,0x78,0x75,0xab,0x1a,0x1c,0x3a,
+  0xe3,0xc1,0x46,0x7d,0x0e,0x49,0xe8,0x32,0x51,0x07,0x2a,0xbe,0x4c,0xe4,0x4d,0x28,
+  0x91,0x3f,0xf9,0x53,0x1c,0x06,0xea,0xd6,0x40,0x9b,0x80,0xdd,0x31,0x0d,0x32,0x61,
+  0x51,0xde,0x54,0x4b,0x45,0x14,0x01,0x0b,0x74,0xd8,0x31,0xbb,0xfa,0xa6,0xe0,0xf4,
+  0xab,0x25,0xe8,0x83,0x89,0xf5,0x21,0x64,0x18,0xaa,0x78,0x9b,0xf5,0x9a,0xce,0x3e,
+  0x55,0x7d,0xc8,0xb5,0x33,0xdc,0x02,0xc7,0x6f,0x32,0x96,0xe1,0x27,0x3d,0x99,0x83,
+  0x5f,0x29,0xe8,0xbe,0x57,0x51,0x04,0xa6,0xff,0xf8,0xd3,0xed,0xed,0x3b,0xe5,0x77,
+  0x9b,0xd2,0xb4,0xdb,0x41,0x75,0x0c,0xc1,0x76,0xfb,0x51,0x1f,0xe2,0x32,0xd6,0x37,
+  0x81,0xb3,0x8c,0xe7,0x21,0x64,0x54,0xa4,0xc9,0x8c,0x14,0xd7,0xa5,0xe9,0x34,0xff,
+  0x17,0xc9,0xbb,0x05,0xbd,0x80,0x2d,0x18,0x0a,0xc5,0x3d,0x3a,0xf4,0x59,0x8b,0x2e,
+  0x35,0x55,0xa0,0x00,0x5a,0x96,0x46,0x06,0xaa,0xc1,0x09,0xa5,0x69,0x8e,0x8f,0x53,
+  0x2c,0x00,0x8f,0x72,0x66,0xcc,0xce,0x6f,0x8d,0xec,0x1c,0x1f,0x9e,0xc9,0xcc,0x5e,
+  0x3a,0x1e,0xb8,0x8f,0xd2,0x54,0x2e,0xe7,0x6c,0xf2,0x49,0x79,0xcb,0x92,0x87,0x30,
+  0xfa,0x04,0x96,0x7a,0x9f,0xbe,0xbc,0x0b,0xdb,0x14,0x42,0x89,0x5a,0x5c,0x01,0xed,
+  0x5b,0x43,0xcc,0x23,0x8c,0x96,0xce,0x75,0x91,0x4f,0xa5,0x43,0x51,0x7c,0xcb,0xed,
+  0xab,0x49,0x0e,0x69,0x58,0x26,0xe6,0xc4,0xdb,0x6d,0xe6,0xad,0x3e,0x94,0x5b,0x3f,
+  0xd3,0x04,0xe8,0xad,0xc2,0xaf,0x25,0x04,0xfb,0xc6,0x26,0x0c,0x3b,0x3a,0x92,0xc6,
+  0x5a,0x11,0xf8,0xd7,0x9a,0xe0,0x12,0x5c,0xe4,0x4a,0xba,0x71,0xfd,0xee,0xea,0xed,
+  0x30,0x67,0x5e,0xb4,0x16,0x07,0x8c,0x22,0x10,0xd2,0xde,0xba,0xe7,0x17,0x9f,0x3f,
+  0x9b,0xb8,0x9e,0x02,0xc1,0xd1,0x51,0x91,0xde,0xb6,0x4b,0x78,0xa7,0x0b,0x67,0xcb,
+  0xf1,0xbb,0x06,0xa5,0x86,0x65,0x90,0x2c,0x30,0x15,0x0a,0xfe,0xf9,0x15,0x20,0x6a,
+  0x2e,0xbb,0x30,0x02,0xad,0x0e,0x55,0x83,0xce,0xfc,0x00,0x55,0x69,0xf8,0xd0,0x92,
+  0x56,0x9c,0x4e,0x5f,0xc0,0x7c,0x74,0xf0,0xfc,0x5a,0xec,0x71,0xa2,0x88,0xc1,0xdb,
+  0x64,0x45,0x42,0x42,0x46,0x94,0xaf,0x3d,0xf0,0x48,0xc8,0xaa,0x34,0x35,0x16,0xda,
+  0x02,0x2f,0xb3,0x47,0x9b,0xa2,0x02,0xff,0xee,0xe6,0xfa,0x6d,0x8b,0x80,0x4c,0x63,
+  0x2d,0x5a,0xd8,0x57,0xf8,0xfa,0x53,0x02,0x80,0x22,0xf9,0xdc,0x19,0x54,0xdb,0xd5,
+  0x79,0x73,0x75,0x7f,0x80,0x6f,0x98,0xc5,0xde,0xd9,0xf0,0x6b,0x58,0x8e,0x72,0x35,
+  0xc1,0x69,0x89,0x7b,0xed,0x72,0xee,0x80,0x76,0x7d,0x4d,0x3c,0x5c,0x11,0x0b,0x82,
+  0x08,0xee,0x31,0x5b,0xd3,0x41,0x10,0xd0,0xfc,0x41,0xce,0x77,0xf9,0xfa,0xfa,0xe6,
+  0xea,0x85,0xbe,0xa9,0xc4,0x5f,0x69,0x2f,0x14,0xac,0x6a,0x74,0x4c,0xb1,0x1d,0x24,
+  0xbb,0x17,0x74,0xc8,0x5f,0xe7,0xc8,0xb6,0x9b,0xd0,0x09,0x26,0x8e,0xb6,0x1b,0x4e,
+  0x56,0xf8,0x52,0x63,0x6b,0xc6,0x92,0x2b,0x9f,0xe1,0xd7,0x1f,0xd6,0xaf,0x5c,0xb0,
+  0x60,0x96,0x4c,0xaa,0xba,0x80,0x05,0x4c,0x1d,0x9f,0x7a,0x00,0x11,0x0e,0x1e,0xa0,
+  0xf7,0x42,0x28,0xc7,0x79,0x8b,0x7f,0x76,0xa0,0x4a,0xb9,0xaa,0x02,0x11,0x81,0x0b,
+  0xf4,0x4c,0xe5,0xff,0xaa,0x83,0xda,0xcd,0xff,0x4c,0x15,0xef,0x8f,0xa8,0x18,0x1b,
+  0xa8,0x9f,0xd7,0xc2,0x5f,0x97,0xe2,0x0f,0x17,0xc4,0x72,0x86,0x72,0x8a,0xc3,0x19,
+  0x56,0xf4,0x80,0x9b,0x42,0xac,0x1a,0xb3,0xd5,0xdd,0x8b,0x10,0x19,0xac,0x4a,0x90,
+  0x94,0x51,0xf1,0x0e,0xa0,0xbe,0x49,0xb3,0x11,0xf4,0xc9,0x42,0x78,0xc8,0xfc,0x08,
+  0xdc,0x20,0x98,0x25,0x73,0x98,0x0c,0x73,0x1c,0xd0,0x00,0x83,0x52,0x5e,0xa7,0x36,
+  0x6d,0xcb,0x03,0x21,0xa3,0x9f,0x6e,0xdf,0xbc,0xb6,0x55,0xca,0x7e,0xa9,0x46,0xb1,
+  0x1b,0x54,0xf7,0xf1,0x9c,0x65,0xd0,0x3e,0x01,0xd7,0xaa,0xb6,0x08,0x9e,0xe8,0x0a,
+  0x20,0x9f,0x81,0x07,0x92,0x79,0x93,0x61,0x63,0xf4,0x36,0x54,0xf0,0x6f,0x34,0x26,
+  0xdc,0x37,0x63,0x48,0x77,0x12,0xd2,0x0d,0x4f,0x16,0xd5,0x82,0xdc,0x5c,0x4a,0xac,
+  0x9c,0x74,0x12,0x51,0x56,0xaf,0xaa,0x0a,0xbf,0x7f,0x8f,0x2d,0x92,0x22,0xa8,0x80,
+  0xf3,0x26,0xec,0x12,0x1e,0xce,0xd4,0xca,0xfc,0x5c,0xa9,0xfc,0xb6,0xd0,0xab,0xa6,
+  0xc2,0xb4,0x88,0x17,0xbe,0xec,0x0f,0x69,0xc1,0xac,0xe2,0x78,0xae,0x98,0x8f,0x72,
+  0x59,0x90,0x9f,0xf9,0x17,0xcb,0x85,0xec,0x98,0xbc,0xae,0xce,0xc8,0x8f,0xc1,0x6b,
+  0x8b,0x25,0x37,0x4c,0xf6,0xd4,0x46,0x74,0x30,0x0a,0xc5,0xd0,0xdb,0xe7,0x97,0xb7,
+  0xaf,0x7e,0xb9,0xda,0x5f,0xfe,0xc8,0x35,0x6f,0xa5,0x64,0x91,0x0f,0x51,0xf8,0x79,
+  0x46,0x43,0x41,0xc8,0x21,0xd9,0xc0,0xe8,0x54,0x02,0x51,0x95,0xf0,0x64,0x5d,0x52,
+  0x61,0x85,0x55,0x49,0x81,0x17,0x0c,0xa4,0xcc,0x76,0x15,0x1f,0x1f,0x85,0xd9,0x95,
+  0x0d,0xf3,0x0d,0xfe,0x8e,0x01,0x28,0xfe,0x1f,0x57,0x2c,0x5a,0xdf,0x30,0x1f,0xfc,
+  0x03,0x73,0x84,0xfc,0x05,0x04,0x48,0xc5,0xf0,0xd4,0xbc,0x86,0x24,0xd7,0x23,0xd0,
+  0x90,0xbe,0xf6,0x50,0xd1,0x7d,0xa0,0xe3,0x5d,0xd0,0x66,0x9b,0xa7,0xbe,0x14,0xfb,
+  0x65,0xac,0xe2,0x58,0x8a,0xde,0x84,0x2e,0xc1,0xa9,0x75,0x09,0xb8,0x73,0x94,0xa6,
+  0x5b,0x77,0xb8,0x37,0xe9,0xc5,0x14,0xba,0x84,0xd0,0x9e,0x3e,0x91,0x8d,0xf1,0x91,
+  0x21,0x0d,0x80,0x78,0xa8,0x2d,0x40,0x4f,0x5c,0x5f,0xe9,0x0e,0xed,0x9d,0x16,0xb5,
+  0x05,0xe5,0x3b,0xa4,0x84,0xe2,0x6e,0x10,0x58,0x8f,0xe8,0x45,0x84,0xc7,0x6d,0x9d,
+  0xf6,0x10,0x9f,0x14,0xd6,0x05,0x72,0x60,0x1c,0xc0,0xaf,0xa9,0x28,0xf0,0x35,0x1b,
+  0xcb,0xa6,0x24,0xb3,0x62,0xa0,0x6a,0x25,0xe1,0x6c,0xe6,0x43,0x60,0xe5,0x7d,0x6c,
+  0xd5,0xc8,0x1e,0xe7,0xb4,0x78,0xe0,0x5f,0x25,0x06,0x3c,0x2e,0x13,0x92,0x9a,0x0b,
+  0xd2,0xa6,0x04,0xcf,0x54,0xee,0xc9,0x80,0xa0,0xa9,0x53,0xab,0x72,0xda,0x54,0x88,
+  0x62,0x42,0x8b,0x07,0x03,0x1f,0x37,0x10,0x4a,0x60,0x73,0x1c,0x01,0x30,0x15,0x4c,
+  0x52,0x0b,0xe9,0xb5,0xa6,0x95,0x4c,0xbf,0x60,0x4e,0xbc,0x8a,0xd8,0x6b,0x2a,0xdd,
+  0x32,0x30,0xe1,0xc8,0x08,0xec,0x30,0xfd,0x59,0x25,0x68,0x7e,0x18,0xd0,0x9e,0x46,
+  0x6d,0x88,0xe8,0xc4,0xa9,0x25,0x6a,0x40,0xfb,0x8d,0x93,0xcc,0x5b,0xd8,0xa4,0x6c,
+  0x1b,0xdc,0xd4,0x08,0x73,0xb7,0xa2,0xc9,0x76,0xc9,0x89,0x5a,0x31,0xd4,0x14,0x80,
+  0x53,0x8a,0xaa,0xa7,0xf0,0x9d,0xb2,0xc9,0x0a,0x48,0xb1,0xc2,0x7b,0xc7,0x5f,0x61,
+  0x86,0xd9,0x0a,0x40,0xd9,0xf0,0x0f,0x5d,0xa3,0x51,0x61,0x0f,0x82,0x83,0x71,0xda,
+  0x63,0x5e,0xda,0xbd,0xf4,0x43,0x27,0xd1,0xf8,0xac,0xc0,0xe7,0x47,0x67,0xa9,0x43,
+  0x6a,0x98,0x96,0x15,0x4a,0x79,0x86,0x91,0x29,0xa9,0xe5,0xde,0x8b,0xbd,0xb1,0xcf,
+  0x04,0xf2,0x0a,0xad,0x50,0x4d,0x69,0x97,0x43,0x0d,0xa9,0x9a,0x22,0xa7,0x5d,0x29,
+  0xc3,0x45,0x5a,0xa7,0x7c,0x30,0x0d,0x22,0xa1,0x9d,0xf3,0x4d,0x79,0x66,0x89,0xaa,
+  0xc2,0x21,0x2d,0x75,0x93,0x70,0x79,0x40,0xd0,0xc4,0x3b,0x3f,0x60,0xe7,0x1e,0x82,
+  0xf6,0xa5,0x8f,0x3d,0x7b,0xa8,0x02,0x50,0x4f,0xf0,0xb8,0x60,0x34,0xf5,0xa2,0x38,
+  0x79,0x1f,0x3e,0xe4,0x96,0x31,0x0d,0xfa,0x3a,0xf5,0x43,0x80,0x8e,0x26,0x50,0x9e,
+  0x54,0x04,0x6c,0x16,0xba,0x08,0x69,0x3a,0x02,0xf7,0x85,0x81,0x27,0xcc,0xf3,0x35,
+  0x91,0xd5,0xf2,0x60,0x42,0xcf,0x55,0x19,0x1d,0x5b,0xdf,0x15,0x58,0xa5,0xc6,0xf8,
+  0xc0,0xa5,0xf1,0x02,0xae,0x4a,0x23,0x95,0xf2,0xbb,0xa2,0x3b,0xe9,0x46,0x89,0x4e,
+  0x4b,0x09,0x8f,0x51,0x18,0xbd,0x4c,0x7e,0x27,0x99,0xb4,0x10,0x4b,0xbf,0x30,0x17,
+  0xe1,0xd4,0x1f,0x68,0x32,0x00,0xdd,0x38,0xb9,0xb3,0x8b,0x1e,0x22,0x28,0xe8,0xb4,
+  0x0f,0x3b,0x12,0xdc,0x5b,0xa1,0x10,0xbf,0x72,0xa0,0x22,0x94,0xf7,0x1e,0x4f,0x44,
+  0xe9,0xfb,0x05,0xf1,0xfb,0xfc,0x99,0x2e,0x46,0x36,0xf2,0x4d,0xf3,0x16,0x17,0xa0,
+  0x3c,0x61,0xe9,0x66,0x26,0xb6,0xbc,0x85,0x41,0x9b,0x1a,0x10,0x44,0x97,0x9a,0x1e,
+  0xc4,0x66,0xe8,0x5d,0x20,0x83,0xb4,0xe5,0x51,0xc5,0x05,0xc2,0x04,0x4a,0x38,0xf8,
+  0x24,0xb6,0xe0,0x1a,0x62,0x07,0xa8,0x74,0x4b,0xce,0x2f,0x78,0xee,0x04,0x15,0x04,
+  0xe8,0xef,0x72,0xee,0xf9,0x1c,0x49,0x60,0xcf,0x51,0xc1,0x4b,0xe9,0x0b,0xb2,0x37,
+  0x84,0x64,0x65,0xc0,0x81,0x21,0x3e,0x51,0xaa,0x0c,0x9a,0x60,0x44,0x4c,0x23,0xb6,
+  0x08,0xef,0x59,0x91,0x29,0xef,0x46,0x2d,0x1d,0xf7,0x16,0x3c,0x5e,0x55,0x0d,0xf8,
+  0xf6,0x03,0xbd,0x2b,0x88,0xf9,0x10,0x88,0x59,0xde,0x7e,0xa3,0xea,0xa6,0xdb,0xd4,
+  0x6e,0xb2,0x8d,0x80,0x44,0x9e,0x6e,0x1d,0x1d,0x95,0x90,0x4f,0x2f,0xe6,0x5a,0x45,
+  0x8c,0x2d,0x79,0x7a,0x59,0x86,0x93,0x92,0xdb,0x0d,0x85,0xf8,0x64,0x98,0xd2,0xcd,
+  0xef,0xca,0x82,0x1d,0xab,0xcb,0x47,0x75,0x98,0x2f,0x53,0xc3,0xc9,0x9a,0xd2,0x64,
+  0x4e,0x85,0x87,0xae,0xef,0xe0,0x82,0xf1,0x90,0x34,0xcb,0x51,0x4f,0x34,0xea,0x41,
+  0x14,0x88,0x8d,0x5c,0x26,0xbd,0xf6,0xb6,0xb8,0x39,0xac,0x7d,0x9c,0xcb,0xc5,0x39,
+  0xf0,0xef,0xfa,0x2e,0xa2,0x9c,0x44,0xda,0x78,0x61,0x70,0x43,0x2d,0x43,0x5e,0xfc,
+  0x96,0x75,0x57,0x83,0x9a,0x9f,0x3f,0x17,0x7a,0x8c,0x69,0x6d,0x5c,0x6c,0x3c,0x8a,
+  0x48,0x08,0x89,0x4f,0x9c,0x3c,0x4f,0x5f,0xbb,0x7b,0x89,0xef,0xb9,0x69,0x54,0xed,
+  0xd5,0xb5,0x29,0x4b,0xe9,0xb4,0x5e,0x10,0x12,0xb7,0xfa,0x25,0x76,0x9a,0xb5,0xac,
+  0x40,0xe3,0x19,0x9c,0x0d,0x89,0x88,0x13,0xc1,0x1e,0x82,0x64,0x20,0x8c,0x61,0x3a,
+  0xc8,0xaf,0xa4,0x9c,0x90,0x97,0x2a,0x9c,0x54,0x17,0xe3,0x90,0xff,0x6b,0xc7,0x7c,
+  0x48,0x7a,0x28,0xcb,0xb9,0x75,0x39,0x21,0x32,0x04,0x5d,0x3a,0x14,0x8b,0x92,0x54,
+  0xa5,0xc2,0xaf,0xdc,0x15,0x94,0x26,0x20,0x70,0x30,0x88,0x9c,0xbb,0xbc,0x54,0x87,
+  0x41,0xc6,0x50,0xed,0xf6,0xa8,0x6f,0xc3,0x44,0xc9,0x48,0xb0,0x65,0x04,0x79,0x07,
+  0x1f,0xa2,0xbf,0x26,0xc7,0xb6,0xba,0x5a,0x76,0x7d,0x2e,0x5d,0x9c,0xa3,0x64,0x21,
+  0xd5,0x7c,0x0e,0x66,0xfd,0x98,0x2d,0xec,0x03,0x65,0xc5,0x98,0xe4,0x35,0x7e,0xb7,
+  0x21,0xf1,0xb6,0x8d,0x3b,0xa5,0xf0,0x52,0x14,0xcc,0xa7,0x7d,0x48,0x0f,0xfc,0xef,
+  0xf4,0x8f,0xfa,0x50,0x4c,0x90,0xe1,0x03,0x50,0xd9,0x23,0xf8,0xd5,0x4a,0xa9,0xc8,
+  0xd4,0xf8,0x2a,0xc1,0x01,0x1d,0x50,0xea,0x3a,0x64,0x4d,0xcc,0x77,0xd7,0x37,0x85,
+  0x2e,0xa6,0xc8,0xce,0x9a,0xb7,0xeb,0x25,0xab,0xeb,0x65,0x1a,0x7b,0xfb,0x9c,0x78,
+  0x88,0x35,0xa0,0x1e,0x46,0x0c,0xe5,0x71,0x30,0xf3,0xa6,0x6b,0xd1,0x51,0x26,0x43,
+  0x38,0xfc,0xef,0xfc,0xc8,0x1e,0x58,0x58,0x03,0x13,0x48,0x4a,0xd4,0xad,0x9e,0x35,
+  0x48,0x3b,0x59,0x83,0x74,0x7f,0x3b,0x33,0xb5,0xc7,0x94,0x5a,0x7b,0x03,0x65,0x47,
+  0x7b,0xf3,0x23,0x67,0x55,0xe8,0xbc,0xed,0xe9,0xd7,0x3d,0xd1,0x9f,0xa4,0x92,0x55,
+  0x4c,0x5c,0x6a,0x50,0xd6,0xb9,0x52,0x2a,0x23,0x89,0x0c,0xae,0xf4,0xce,0xc7,0xd7,
+  0x54,0x94,0xdb,0x68,0xad,0x3c,0x9f,0x39,0x1e,0xb9,0xee,0xd4,0x0b,0x1c,0xdf,0x5f,
+  0x6f,0x9e,0xb6,0x30,0x3f,0xcb,0x81,0xb0,0x56,0xef,0xed,0xe9,0x91,0xcf,0xff,0xbf,
+  0xaf,0xab,0xd2,0x39,0x68,0x96,0x17,0xc0,0x22,0x7f,0x38,0xe0,0xc9,0x22,0x66,0x1c,
+  0xea,0xf6,0x39,0xf3,0xdf,0x66,0x87,0x00,0xbf,0xbf,0xed,0x0e,0x79,0x7a,0x5f,0xf4,
+  0x0e,0xdc,0x17,0x6f,0x48,0xf5,0x99,0x97,0x3e,0xbd,0x3d,0xaa,0x7d,0xcc,0x8f,0x78,
+  0x42,0x88,0xb6,0x87,0x07,0x84,0x44,0xcf,0xb1,0xf8,0x83,0x6f,0x2e,0x08,0xf6,0x82,
+  0x39,0xd9,0xd5,0x56,0xb9,0xe1,0xaf,0xde,0x4c,0x57,0xe0,0xc4,0x5f,0xb2,0xd9,0x3a,
+  0x4f,0x6e,0xb6,0xd2,0x4a,0x0e,0xd8,0x6f,0xe2,0x89,0x2f,0xd9,0x76,0x92,0x74,0x14,
+  0x11,0x0f,0xde,0x86,0x07,0xb9,0x5c,0xba,0x65,0x8d,0x5e,0xe9,0x24,0xc0,0x4b,0x4f,
+  0xb2,0x19,0xef,0x19,0x6b,0xf5,0xfb,0xf3,0x32,0x3b,0x9c,0x80,0xda,0x46,0xa9,0xfe,
+  0x47,0x4d,0xf0,0xc8,0x02,0x92,0x5c,0xf9,0x10,0x6c,0x58,0xea,0xa5,0x0f,0x0f,0x28,
+  0x88,0xaa,0x8d,0x69,0x3a,0x4d,0x56,0x0d,0x29,0xe0,0xeb,0x43,0x51,0xba,0xd4,0xb4,
+  0xd1,0x29,0x8b,0x40,0x6a,0x9e,0xc3,0x18,0x9b,0xa5,0x13,0xc7,0xf8,0xc7,0x38,0xe8,
+  0x4e,0xdb,0x3d,0x4f,0x82,0x3b,0x82,0x0a,0x54,0x83,0x54,0x5f,0xa9,0x66,0xcd,0x03,
+  0x53,0xd9,0x4a,0xc6,0x02,0x46,0xa5,0xbf,0xf0,0x87,0xc2,0x57,0x4b,0xbb,0xda,0x45,
+  0xaf,0x3c,0x3a,0xd2,0x24,0x70,0xfc,0xfc,0xb9,0xfe,0x5c,0x47,0x2f,0x6a,0x76,0x4b,
+  0x3d,0x6c,0xf8,0x37,0x53,0x69,0x75,0x45,0x2f,0xae,0xdf,0x08,0x78,0x78,0x1d,0x02,
+  0x5e,0x40,0xa0,0x2d,0x9b,0x5a,0xb2,0x48,0xf5,0x71,0x2a,0x98,0x3c,0x28,0xf4,0xd7,
+  0xd8,0x19,0x9d,0xa5,0xaa,0xa9,0xe9,0x76,0x08,0x50,0x2e,0xc3,0x7c,0x51,0x62,0xb8,
+  0x2b,0x9a,0x22,0x79,0x77,0x84,0x67,0x79,0xf2,0x31,0x0c,0x68,0xec,0xe2,0x44,0x1c,
+  0xcf,0x5f,0x9c,0xf0,0xd7,0x50,0x4e,0xe8,0xbf,0xdf,0xf3,0x7f,0x66,0xcc,0x2a,0x45,
+  0xcf,0x47,0x00,0x00,
+};
@@ -0,0 +1,336 @@
+// Benchmarks for the host build. Runs scripted traffic over a loopback
+// connection and reports, per endpoint, client-side latency percentiles
+// and heap allocations per request (by any thread of the sketch while the
+// request is in flight), and the time loop() spends per pass with its
+// waits taken out. The dashboard page also gets its time to first byte
+// and the most heap in use while it is served. Then times the engine's
+// fade tick with 1, 2, 4... up to every channel fading, flushOutputs()
+// alone with every channel changed, and the metrics bookkeeping each
+// request pays for. bench_512 is the same program built for the
+// 512-channel PCA9685 chain, bench_ledc16 for all 16 LEDC channels.
+//
+//   bench [--rounds N] [--fade-ticks N] [--metric-events N]
+//
+// Exits non-zero if a request fails, or a request, a fade tick, a flush or
+// a metrics update allocates. Requests go through the whole server: head
+// parsing, the JSON body parse into the fixed arena, the handler and the
+// response.
+
+#include "sim.h"
+
+struct EndpointStats {
+  const char* name;
+  std::vector<double> latencyUs;
+  std::vector<double> firstByteUs;
+  int64_t peakHeap = 0;  // most heap in use during a request, above the level before it
+  uint64_t allocations = 0;
+  uint32_t failures = 0;
+};
+
+// loop() passes, timed on the loop thread into a fixed buffer so timing
+// them doesn't allocate
+const int MAX_LOOP_SAMPLES = 1 << 20;
+static float loopBusyUs[MAX_LOOP_SAMPLES];
+static std::atomic<int> loopSamples(0);
+
+// One pass of loop() for the driver: its time, less what it spent in
+// select()
+static void timedLoop() {
+  // The driver is the only client and sends as fast as it can; leave the
+  // per-client rate limit out of it so the handlers are what's measured
+  memset(rateBuckets, 0, sizeof(rateBuckets));
+
+  uint64_t idleBefore = loopIdleUs;
+  int64_t start = hostNanos();
+  loop();
+  double busy = (hostNanos() - start) / 1000.0 - (loopIdleUs - idleBefore);
+  int n = loopSamples.load(std::memory_order_relaxed);
+  if (n < MAX_LOOP_SAMPLES) {
+    loopBusyUs[n] = std::max(busy, 0.0);
+    loopSamples.store(n + 1, std::memory_order_release);
+  }
+}
+
+static bool timeRequest(SimClient& client, EndpointStats& stats, const char* method, const char* path,
+                        const char* body, int expectStatus, const char* headers = "") {
+  SimResponse response;
+  uint64_t allocationsBefore = host::totalAllocations();
+  int64_t heapBefore = host::resetHeapPeak();
+  int64_t start = hostNanos();
+  bool ok = client.request(method, path, body, response, headers);
+  int64_t end = hostNanos();
+  stats.allocations += host::totalAllocations() - allocationsBefore;
+  stats.peakHeap = std::max(stats.peakHeap, host::heapPeak() - heapBefore);
+  stats.latencyUs.push_back((end - start) / 1000.0);
+  stats.firstByteUs.push_back(response.firstByteUs);
+  if (!ok || response.status != expectStatus) {
+    stats.failures++;
+    return false;
+  }
+  return true;
+}
+
+static void printStats(const EndpointStats& stats) {
+  size_t n = stats.latencyUs.size();
+  printf("  %-26s %6zu %8.1f %8.1f %8.1f %8.1f %10.2f %6u\n", stats.name, n,
+         percentile(stats.latencyUs, 0.5), percentile(stats.latencyUs, 0.9), percentile(stats.latencyUs, 0.99),
+         *std::max_element(stats.latencyUs.begin(), stats.latencyUs.end()),
+         n > 0 ? (double)stats.allocations / n : 0.0, stats.failures);
+}
+
+static bool benchHttp(int rounds) {
+  SimClient client;
+  if (!client.connect()) {
+    fprintf(stderr, "cannot connect to the web server\n");
+    return false;
+  }
+
+  EndpointStats root = {"GET /"};
+  EndpointStats revalidate = {"GET / (If-None-Match)"};
+  EndpointStats status = {"GET /api/status"};
+  EndpointStats compact = {"GET /api/status (compact)"};
+  EndpointStats led = {"POST /api/led"};
+  EndpointStats all = {"POST /api/all"};
+  EndpointStats batch = {"POST /api/batch"};
+  const std::initializer_list<EndpointStats*> endpoints = {&root, &revalidate, &status, &compact, &led, &all,
+                                                             &batch};
+  for (EndpointStats* stats : endpoints) {
+    stats->latencyUs.reserve(rounds);
+    stats->firstByteUs.reserve(rounds);
+  }
+  static const char* const ledActions[] = {"on", "off", "brightness"};
+  char body[512];
+  char etagHeader[64];
+  snprintf(etagHeader, sizeof(etagHeader), "If-None-Match: %s\r\n", DASHBOARD_ETAG);
+  // What a browser sends, so the head parser has some work to do
+  static const char browserHeaders[] =
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+      "Accept: application/json, text/plain, */*\r\n"
+      "Accept-Language: en-GB,en;q=0.9\r\n"
+      "Accept-Encoding: gzip, deflate\r\n"
+      "Referer: http://led.local/\r\n"
+      "Cache-Control: no-cache\r\n";
+
+  int firstPass = loopSamples.load(std::memory_order_acquire);
+  for (int round = 0; round < rounds; round++) {
+    int ledNum = round % NUM_LEDS;
+    const char* action = ledActions[round % 3];
+    snprintf(body, sizeof(body), "{\"led\":%d,\"action\":\"%s\",\"value\":%d}", ledNum, action, (round * 37) % 256);
+    timeRequest(client, led, "POST", "/api/led", body, 200);
+    timeRequest(client, status, "GET", "/api/status", nullptr, 200);
+    snprintf(body, sizeof(body), "{\"action\":\"%s\"}", round % 2 == 0 ? "on" : "off");
+    timeRequest(client, all, "POST", "/api/all", body, 200);
+    timeRequest(client, revalidate, "GET", "/", nullptr, 304, etagHeader);
+    timeRequest(client, compact, "GET", "/api/status?format=compact&offset=0", nullptr, 200, browserHeaders);
+    int n = snprintf(body, sizeof(body), "{\"ops\":[");
+    for (int op = 0; op < NUM_LEDS && op < 8; op++) {
+      n += snprintf(body + n, sizeof(body) - n, "%s{\"led\":%d,\"action\":\"brightness\",\"value\":%d}",
+                    op > 0 ? "," : "", op, (round + op * 31) % 256);
+    }
+    snprintf(body + n, sizeof(body) - n, "]}");
+    timeRequest(client, batch, "POST", "/api/batch", body, 200);
+    if (round % 10 == 0) {
+      timeRequest(client, root, "GET", "/", nullptr, 200);
+    }
+  }
+  client.close();
+  std::vector<double> passUs(loopBusyUs + firstPass, loopBusyUs + loopSamples.load(std::memory_order_acquire));
+
+  printf("HTTP: %d rounds over one keep-alive connection, %d channels\n", rounds, NUM_LEDS);
+  printf("  %-26s %6s %8s %8s %8s %8s %10s %6s\n", "endpoint (latency in us)", "n", "p50", "p90", "p99", "max",
+         "allocs/req", "failed");
+  for (const EndpointStats* stats : endpoints) {
+    printStats(*stats);
+  }
+  printf("  loop() pass, waits excluded: n %zu, p50 %.1f us, p99 %.1f us, max %.1f us\n", passUs.size(),
+         percentile(passUs, 0.5), percentile(passUs, 0.99), *std::max_element(passUs.begin(), passUs.end()));
+  printf("  GET / (%u byte gzip page): first byte p50 %.1f us, p99 %.1f us; peak heap %lld bytes above idle\n",
+         (unsigned)DASHBOARD_HTML_GZ_LEN, percentile(root.firstByteUs, 0.5), percentile(root.firstByteUs, 0.99),
+         (long long)root.peakHeap);
+
+  bool ok = true;
+  for (const EndpointStats* stats : endpoints) {
+    if (stats->failures > 0) {
+      fprintf(stderr, "%s: %u requests failed\n", stats->name, stats->failures);
+      ok = false;
+    }
+    if (stats->allocations > 0) {
+      fprintf(stderr, "%s: requests allocated %llu times\n", stats->name, (unsigned long long)stats->allocations);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// One fade tick as the engine runs it: every fading channel stepped, then
+// the dirty range flushed to the backend. Timed at doubling channel counts.
+// Runs on the driver thread after the HTTP section, when the engine task
+// is parked waiting for a command that nothing will send it.
+static bool benchFades(int ticks) {
+  printf("Fade tick (runFades + flushOutputs), %d ticks each\n", ticks);
+  printf("  %-26s %8s %8s %8s %12s %10s\n", "fading channels", "p50 ns", "p99 ns", "max ns", "ns/channel",
+         "allocs");
+  std::vector<int> counts;
+  for (int fading = 1; fading < NUM_LEDS; fading *= 2) {
+    counts.push_back(fading);
+  }
+  counts.push_back(NUM_LEDS);
+
+  std::vector<double> tickNs(ticks);
+  std::vector<double> medians;
+  bool ok = true;
+  for (int fading : counts) {
+    for (int i = 0; i < fading; i++) {
+      channels.isOn[i] = true;
+      channels.effect[i] = EFFECT_NONE;
+      channels.brightness[i] = 255;
+      channels.level[i] = 0;
+      startFade(i, MAX_FADE_MS);
+    }
+    flushOutputs();
+
+    uint64_t allocationsBefore = host::allocations();
+    for (int t = 0; t < ticks; t++) {
+      nextFadeTick = 0;
+      int64_t start = hostNanos();
+      runFades();
+      flushOutputs();
+      tickNs[t] = hostNanos() - start;
+    }
+    uint64_t allocations = host::allocations() - allocationsBefore;
+    double p50 = percentile(tickNs, 0.5);
+    medians.push_back(p50);
+    char label[32];
+    snprintf(label, sizeof(label), "%d of %d", fading, NUM_LEDS);
+    printf("  %-26s %8.0f %8.0f %8.0f %12.1f %10llu\n", label, p50, percentile(tickNs, 0.99),
+           *std::max_element(tickNs.begin(), tickNs.end()), p50 / fading, (unsigned long long)allocations);
+    if (allocations > 0) {
+      fprintf(stderr, "fade tick with %d channels fading allocated %llu times\n", fading,
+              (unsigned long long)allocations);
+      ok = false;
+    }
+
+    for (int i = 0; i < fading; i++) {
+      channels.isOn[i] = false;
+      writeLEDOutput(i);
+    }
+    flushOutputs();
+  }
+
+  // Least-squares line through the medians: a fixed cost per tick plus a
+  // cost per fading channel. Linear scaling keeps every row near the line.
+  if (counts.size() > 1) {
+    double n = counts.size(), sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+      sumX += counts[i];
+      sumY += medians[i];
+      sumXX += (double)counts[i] * counts[i];
+      sumXY += counts[i] * medians[i];
+    }
+    double perChannel = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+    double fixed = (sumY - perChannel * sumX) / n;
+    double worst = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+      worst = std::max(worst, fabs(medians[i] - (fixed + perChannel * counts[i])) / medians[i]);
+    }
+    printf("  fit: %.0f ns per tick + %.2f ns per fading channel; rows within %.0f%% of it\n", fixed, perChannel,
+           worst * 100);
+  }
+  return ok;
+}
+
+// flushOutputs() on its own with every channel's duty changed since the
+// last flush, the most a tick can hand it
+static bool benchFlush(int flushes) {
+  std::vector<double> flushNs(flushes);
+  uint64_t allocationsBefore = host::allocations();
+  for (int f = 0; f < flushes; f++) {
+    for (int i = 0; i < NUM_LEDS; i++) {
+      setOutputDuty(i, f % 2 == 0 ? PWM_MAX_DUTY : 1);
+    }
+    int64_t start = hostNanos();
+    flushOutputs();
+    flushNs[f] = hostNanos() - start;
+  }
+  uint64_t allocations = host::allocations() - allocationsBefore;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    setOutputDuty(i, 0);
+  }
+  flushOutputs();
+
+  double p50 = percentile(flushNs, 0.5);
+  printf("Flush, all %d channels changed, %d flushes: p50 %.0f ns, p99 %.0f ns, %.1f ns/channel, %llu allocs\n",
+         NUM_LEDS, flushes, p50, percentile(flushNs, 0.99), p50 / NUM_LEDS, (unsigned long long)allocations);
+  if (allocations > 0) {
+    fprintf(stderr, "flush allocated %llu times\n", (unsigned long long)allocations);
+    return false;
+  }
+  return true;
+}
+
+static void metricsBenchHandler() {
+  server.lastStatus = 200;
+}
+
+// What /api/metrics costs a request: timeRoute() around a handler that
+// does nothing but set its status, so a histogram record and a status
+// count. Timed in blocks of METRIC_BLOCK events, as a single one is below
+// the clock's resolution. The host's cycle counter is a clock read, which
+// is included; the ESP32's is one instruction.
+static bool benchMetrics(int events) {
+  const int METRIC_BLOCK = 100;
+  int blocks = std::max(events / METRIC_BLOCK, 1);
+  printf("Metrics update (timeRoute: histogram record + status count), %d events\n", blocks * METRIC_BLOCK);
+  printf("  %-26s %8s %8s %8s %10s\n", "", "p50 ns", "p99 ns", "max ns", "allocs");
+
+  std::vector<double> eventNs(blocks);
+  LatencyHistogram savedLatency = routeLatency[ROUTE_NOT_FOUND];
+  uint32_t savedCounts[METRIC_STATUS_COUNT + 1];
+  memcpy(savedCounts, routeStatusCounts[ROUTE_NOT_FOUND], sizeof(savedCounts));
+  uint64_t allocationsBefore = host::allocations();
+  for (int b = 0; b < blocks; b++) {
+    int64_t start = hostNanos();
+    for (int e = 0; e < METRIC_BLOCK; e++) {
+      timeRoute(ROUTE_NOT_FOUND, metricsBenchHandler);
+    }
+    eventNs[b] = (double)(hostNanos() - start) / METRIC_BLOCK;
+  }
+  uint64_t allocations = host::allocations() - allocationsBefore;
+  // Keep the bench's events out of what /api/metrics reports afterwards
+  routeLatency[ROUTE_NOT_FOUND] = savedLatency;
+  memcpy(routeStatusCounts[ROUTE_NOT_FOUND], savedCounts, sizeof(savedCounts));
+
+  printf("  %-26s %8.1f %8.1f %8.1f %10llu\n", "per event", percentile(eventNs, 0.5), percentile(eventNs, 0.99),
+         *std::max_element(eventNs.begin(), eventNs.end()), (unsigned long long)allocations);
+  printf("  target: under 1000 ns per event\n");
+  if (allocations > 0) {
+    fprintf(stderr, "metrics update allocated %llu times\n", (unsigned long long)allocations);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int rounds = 2000;
+  int fadeTicks = 20000;
+  int metricEvents = 1000000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+      rounds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--fade-ticks") == 0 && i + 1 < argc) {
+      fadeTicks = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--metric-events") == 0 && i + 1 < argc) {
+      metricEvents = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--rounds N] [--fade-ticks N] [--metric-events N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  startSketch(timedLoop);
+  bool ok = benchHttp(rounds);
+  ok = benchFades(fadeTicks) && ok;
+  ok = benchFlush(fadeTicks) && ok;
+  ok = benchMetrics(metricEvents) && ok;
+  return ok ? 0 : 1;
+}
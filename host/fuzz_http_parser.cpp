@@ -0,0 +1,294 @@
+// Fuzzes request parsing through the real server: each input is sent raw
+// on a fresh loopback connection, the way a client would, so it goes
+// through parseHead(), urlDecode(), parseRequestBody() and whichever
+// handler it reaches. The connection is then half-closed, and the server
+// must answer with a well-formed status line or simply close; it must
+// never crash or hang. Every so often a plain GET /api/status checks that
+// it is still serving.
+//
+// Built with clang and LED_LIBFUZZER defined, this is a libFuzzer target.
+// Otherwise it has a main of its own that mutates a built-in seed corpus:
+//
+//   fuzz_http_parser [--runs N] [--seed S] [--check-every N]
+//   fuzz_http_parser FILE...   replays saved inputs, checking after each
+//
+// On a failure the input is left in fuzz-failure.bin. The liveness check
+// runs every --check-every inputs (256), so with a larger interval the
+// input that broke the server may be an earlier one.
+
+#include "sim.h"
+
+#include <signal.h>
+#include <random>
+#include <string>
+
+static const char* const FAILURE_FILE = "fuzz-failure.bin";
+
+// Rate limits would turn most control requests into 429s
+static void fuzzLoop() {
+  memset(rateBuckets, 0, sizeof(rateBuckets));
+  loop();
+}
+
+static uint32_t checkInterval = 256;
+static const uint8_t* currentInput = nullptr;
+static size_t currentSize = 0;
+
+static void saveInput() {
+  int fd = open(FAILURE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0) {
+    ssize_t ignored = write(fd, currentInput, currentSize);
+    (void)ignored;
+    ::close(fd);
+  }
+}
+
+static void fail(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fprintf(stderr, "\ninput (%zu bytes) saved in %s\n", currentSize, FAILURE_FILE);
+  saveInput();
+  abort();
+}
+
+static int connectToSketch() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(host::boundPort(HTTP_PORT));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    fail("cannot connect to the web server");
+  }
+  timeval timeout = {5, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+static void checkStillServing() {
+  SimClient client;
+  SimResponse response;
+  if (!client.connect()) {
+    fail("the server stopped accepting connections");
+  }
+  if (!client.request("GET", "/api/status", nullptr, response)) {
+    fail("no answer to GET /api/status: %s", strerror(errno));
+  }
+  if (response.status != 200) {
+    fail("GET /api/status answered %d: %.*s", response.status, (int)std::min(response.bodyLength, (size_t)200),
+         response.body);
+  }
+  client.close();
+}
+
+static void runInput(const uint8_t* data, size_t size) {
+  static bool started = false;
+  if (!started) {
+    startSketch(fuzzLoop);
+    started = true;
+  }
+  currentInput = data;
+  currentSize = size;
+
+  int fd = connectToSketch();
+  size_t sent = 0;
+  while (sent < size) {
+    ssize_t n = ::send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      break;  // the server gave up on the request part way, which is fine
+    }
+    sent += n;
+  }
+  shutdown(fd, SHUT_WR);
+
+  // Only the start of the reply is checked; the rest is drained
+  char head[16];
+  size_t headLength = 0;
+  static char buffer[16384];
+  for (;;) {
+    ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (n == 0 || (n < 0 && errno == ECONNRESET)) {
+      break;
+    }
+    if (n < 0) {
+      fail("no response and no close within 5 s");
+    }
+    size_t take = std::min((size_t)n, sizeof(head) - headLength);
+    memcpy(head + headLength, buffer, take);
+    headLength += take;
+  }
+  ::close(fd);
+
+  if (headLength > 0) {
+    if (headLength < 13 || strncmp(head, "HTTP/1.1 ", 9) != 0 || head[9] < '1' || head[9] > '5' ||
+        !isdigit((unsigned char)head[10]) || !isdigit((unsigned char)head[11]) || head[12] != ' ') {
+      fail("malformed status line: %.*s", (int)headLength, head);
+    }
+  }
+
+  static uint32_t runs = 0;
+  if (++runs % checkInterval == 0) {
+    checkStillServing();
+  }
+}
+
+#ifdef LED_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  runInput(data, size);
+  return 0;
+}
+
+#else
+
+static const char* const SEEDS[] = {
+  "GET / HTTP/1.1\r\nHost: led\r\n\r\n",
+  "GET /api/status?offset=0&count=8 HTTP/1.1\r\nHost: led\r\nConnection: close\r\n\r\n",
+  "GET /api/status?format=compact&since=3 HTTP/1.0\r\n\r\n",
+  "GET /api/metrics?format=json HTTP/1.1\r\n\r\n",
+  "OPTIONS /api/led HTTP/1.1\r\nOrigin: x\r\n\r\n",
+  "POST /api/led HTTP/1.1\r\nContent-Length: 42\r\n\r\n{\"led\":3,\"action\":\"brightness\",\"value\":99}",
+  "POST /api/led HTTP/1.1\r\nContent-Length: 46\r\n\r\n{\"led\":1,\"action\":\"on\",\"fade\":400,\"value\":[1]}",
+  "POST /api/all HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: 15\r\n\r\n{\"action\":\"on\"}",
+  "POST /api/batch HTTP/1.1\r\nContent-Length: 69\r\n\r\n"
+  "{\"ops\":[{\"led\":0,\"action\":\"on\"},{\"led\":1,\"action\":\"off\",\"fade\":100}]}",
+  "POST /api/scenes HTTP/1.1\r\nContent-Length: 32\r\n\r\n{\"action\":\"save\",\"name\":\"a%20b\"}",
+  "POST /api/shows HTTP/1.1\r\nContent-Length: 32\r\n\r\n{\"action\":\"create\",\"name\":\"s_1\"}",
+  "POST /api/led HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 20\r\n\r\n{\"led\":0,\"action\":",
+  "POST /api/led HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\n{\"a\":\r\n0\r\n\r\n",
+  "GET /%41%70i/status?a=%zz&b=+c&&=&d HTTP/1.1\r\nX: \t y\r\n\r\nGET / HTTP/1.1\r\n\r\n",
+};
+
+const size_t SEED_COUNT = sizeof(SEEDS) / sizeof(SEEDS[0]);
+
+// Fragments that tend to matter to the parsers
+static const char* const TOKENS[] = {
+  "\r\n", "\r\n\r\n", " ", ":", "?", "&", "=", "%", "%00", "+", "{", "}", "[", "]", "\"", ",", "\\u0000",
+  "\\\"", "-1", "0", "4294967296", "1e309", "null", "true", "Content-Length: ", "Connection: keep-alive",
+  "HTTP/1.0", "\"action\":", "\"led\":", "\"value\":", "\"fade\":", "\"ops\":[",
+};
+
+static std::string mutate(std::string input, std::mt19937& random) {
+  int edits = 1 + random() % 4;
+  for (int e = 0; e < edits; e++) {
+    size_t at = input.empty() ? 0 : random() % (input.size() + 1);
+    switch (random() % 6) {
+      case 0:  // flip a bit
+        if (at < input.size()) {
+          input[at] ^= 1 << (random() % 8);
+        }
+        break;
+      case 1:  // random byte
+        if (at < input.size()) {
+          input[at] = (char)random();
+        }
+        break;
+      case 2:  // delete a run
+        if (at < input.size()) {
+          input.erase(at, 1 + random() % std::min<size_t>(input.size() - at, 16));
+        }
+        break;
+      case 3:  // insert a token
+        input.insert(at, TOKENS[random() % (sizeof(TOKENS) / sizeof(TOKENS[0]))]);
+        break;
+      case 4:  // repeat a run
+        if (at < input.size()) {
+          std::string run = input.substr(at, 1 + random() % 64);
+          input.insert(at, run);
+        }
+        break;
+      case 5: {  // splice in part of another seed
+        std::string other = SEEDS[random() % SEED_COUNT];
+        size_t from = random() % other.size();
+        input.insert(at, other.substr(from, 1 + random() % 80));
+        break;
+      }
+    }
+  }
+  // Keep it to what the server will read before it answers 431 or 413
+  if (input.size() > HTTP_REQUEST_BUFFER_SIZE + 512) {
+    input.resize(HTTP_REQUEST_BUFFER_SIZE + 512);
+  }
+  return input;
+}
+
+static void onCrash(int signal) {
+  static const char message[] = "crashed; input saved in fuzz-failure.bin\n";
+  ssize_t ignored = write(2, message, sizeof(message) - 1);
+  (void)ignored;
+  saveInput();
+  ::signal(signal, SIG_DFL);
+  raise(signal);
+}
+
+int main(int argc, char** argv) {
+  long runs = 20000;
+  unsigned seed = 1;
+  std::vector<const char*> replay;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--check-every") == 0 && i + 1 < argc) {
+      checkInterval = std::max(atoi(argv[++i]), 1);
+    } else if (argv[i][0] != '-') {
+      replay.push_back(argv[i]);
+    } else {
+      fprintf(stderr, "usage: %s [--runs N] [--seed S] [--check-every N] | FILE...\n", argv[0]);
+      return 2;
+    }
+  }
+  for (int s : {SIGSEGV, SIGBUS, SIGFPE, SIGILL}) {
+    signal(s, onCrash);
+  }
+
+  if (!replay.empty()) {
+    checkInterval = 1;
+    for (const char* path : replay) {
+      FILE* file = fopen(path, "rb");
+      if (file == nullptr) {
+        perror(path);
+        return 2;
+      }
+      std::string input;
+      char buffer[4096];
+      size_t n;
+      while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        input.append(buffer, n);
+      }
+      fclose(file);
+      runInput((const uint8_t*)input.data(), input.size());
+      printf("%s: ok\n", path);
+    }
+    return 0;
+  }
+
+  std::mt19937 random(seed);
+  std::vector<std::string> corpus(std::begin(SEEDS), std::end(SEEDS));
+  int64_t start = hostNanos();
+  for (const std::string& input : corpus) {
+    runInput((const uint8_t*)input.data(), input.size());
+  }
+  for (long run = 0; run < runs; run++) {
+    std::string input = mutate(corpus[random() % corpus.size()], random);
+    runInput((const uint8_t*)input.data(), input.size());
+    // Keep a few mutants around so edits compound
+    if (random() % 16 == 0) {
+      if (corpus.size() < SEED_COUNT + 16) {
+        corpus.push_back(input);
+      } else {
+        corpus[SEED_COUNT + random() % 16] = input;
+      }
+    }
+  }
+  checkStillServing();
+  double seconds = (hostNanos() - start) / 1e9;
+  long inputs = runs + (long)SEED_COUNT;
+  printf("%ld inputs (seed %u) in %.1f s, %.0f/s, no crash or hang\n", inputs, seed, seconds, inputs / seconds);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,37 @@
+// Runs the sketch on the desktop. The web server, the UDP stream and the
+// fleet port come up on localhost, so the tools in tools/ can be pointed
+// at it:
+//
+//   led_sim [--port-offset N] [--shared-port PORT] [--fs DIR]
+//
+// --port-offset moves every device port up by N (port 80 needs root),
+// except those given with --shared-port, which several simulations can
+// listen on at once (5571 for a fleet on one host); --fs is the directory
+// standing in for the LittleFS partition.
+
+#include <Arduino.h>
+#include "host.h"
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--port-offset") == 0 && i + 1 < argc) {
+      host::setPortOffset(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--shared-port") == 0 && i + 1 < argc) {
+      host::sharePort(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc) {
+      host::setFsRoot(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--port-offset N] [--shared-port PORT] [--fs DIR]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host::echoSerial(true);
+  setup();
+  for (;;) {
+    loop();
+  }
+}
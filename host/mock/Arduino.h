@@ -0,0 +1,178 @@
+// Host stand-in for the Arduino-ESP32 core: just the parts LED_IOT.cpp
+// uses. Time, Serial and the pins are provided by runtime.cpp, see host.h.
+#pragma once
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include <sdkconfig.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define PROGMEM
+#define IRAM_ATTR
+typedef const char* PGM_P;
+
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+using std::max;
+using std::min;
+
+template <typename T, typename L, typename H>
+T constrain(T x, L low, H high) {
+  return x < low ? low : (x > high ? high : x);
+}
+
+// Arduino's String: a heap buffer that grows on every append, which is the
+// point of having it here, as its allocations show up in the counts
+class String {
+ public:
+  String(const char* text = "") { assign(text, strlen(text)); }
+  String(const char* text, size_t length) { assign(text, length); }
+  String(const String& other) { assign(other.buffer, other.size); }
+  String(String&& other) noexcept : buffer(other.buffer), size(other.size) {
+    other.buffer = nullptr;
+    other.size = 0;
+  }
+  explicit String(char c) { assign(&c, 1); }
+  explicit String(int value) { assignNumber("%d", value); }
+  explicit String(unsigned value) { assignNumber("%u", value); }
+  explicit String(long value) { assignNumber("%ld", value); }
+  explicit String(unsigned long value) { assignNumber("%lu", value); }
+  ~String() { free(buffer); }
+
+  String& operator=(const String& other) {
+    if (this != &other) {
+      assign(other.buffer, other.size);
+    }
+    return *this;
+  }
+  String& operator=(String&& other) noexcept {
+    std::swap(buffer, other.buffer);
+    std::swap(size, other.size);
+    return *this;
+  }
+  String& operator=(const char* text) {
+    assign(text, strlen(text));
+    return *this;
+  }
+
+  String& concat(const char* text, size_t length) {
+    char* grown = (char*)realloc(buffer, size + length + 1);
+    if (grown != nullptr) {
+      buffer = grown;
+      memcpy(buffer + size, text, length);
+      size += length;
+      buffer[size] = '\0';
+    }
+    return *this;
+  }
+  String& operator+=(const String& other) { return concat(other.buffer, other.size); }
+  String& operator+=(const char* text) { return concat(text, strlen(text)); }
+  String& operator+=(char c) { return concat(&c, 1); }
+
+  const char* c_str() const { return buffer != nullptr ? buffer : ""; }
+  size_t length() const { return size; }
+  char operator[](size_t index) const { return index < size ? buffer[index] : '\0'; }
+  bool operator==(const char* text) const { return strcmp(c_str(), text) == 0; }
+  bool operator!=(const char* text) const { return !(*this == text); }
+  bool operator==(const String& other) const { return *this == other.c_str(); }
+  int indexOf(const char* text) const {
+    const char* found = strstr(c_str(), text);
+    return found != nullptr ? found - c_str() : -1;
+  }
+  long toInt() const { return atol(c_str()); }
+
+ private:
+  void assign(const char* text, size_t length) {
+    size = 0;
+    concat(text, length);
+  }
+  template <typename T>
+  void assignNumber(const char* format, T value) {
+    char text[24];
+    snprintf(text, sizeof(text), format, value);
+    assign(text, strlen(text));
+  }
+
+  char* buffer = nullptr;
+  size_t size = 0;
+};
+
+inline String operator+(String left, const String& right) {
+  return left += right;
+}
+inline String operator+(String left, const char* right) {
+  return left += right;
+}
+inline String operator+(const char* left, const String& right) {
+  return String(left) += right;
+}
+
+class Print;
+
+class Printable {
+ public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& out) const = 0;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(const uint8_t* data, size_t length) { return length; }
+  size_t write(const char* text, size_t length) { return write((const uint8_t*)text, length); }
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t print(const char* text) { return write(text, strlen(text)); }
+  size_t print(const String& text) { return write(text.c_str(), text.length()); }
+  size_t print(const Printable& value) { return value.printTo(*this); }
+  size_t print(long value) { return printf("%ld", value); }
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(const T& value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  virtual void flush() {}
+};
+
+// Serial output is dropped unless host::echoSerial() turned it on
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baud) {}
+  using Print::write;
+  size_t write(const uint8_t* data, size_t length) override;
+  void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+ public:
+  uint32_t getCycleCount();
+  uint32_t getFreeHeap() { return 0; }
+  uint32_t getMinFreeHeap() { return 0; }
+  uint32_t getMaxAllocHeap() { return 0; }
+  uint64_t getEfuseMac();
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+uint32_t getCpuFrequencyMhz();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
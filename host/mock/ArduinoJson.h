@@ -0,0 +1,423 @@
+// Host stand-in for the subset of ArduinoJson 6 the sketch uses. It keeps
+// the properties the sketch relies on: deserializeJson() parses a mutable
+// buffer in place (zero-copy, strings point into it), a StaticJsonDocument
+// holds its nodes inline, and running out of them is NoMemory. Nothing
+// here touches the heap.
+#pragma once
+
+#include <Arduino.h>
+#include <errno.h>
+#include <limits.h>
+
+namespace ArduinoJsonHost {
+
+struct Node {
+  enum Type : uint8_t { NUL, INTEGER, REAL, STRING, BOOLEAN, ARRAY, OBJECT };
+  Type type;
+  uint16_t size;     // elements or members
+  const char* key;   // set on object members
+  Node* next;        // next element or member of the parent
+  union {
+    long long integer;
+    double real;
+    const char* string;
+    bool boolean;
+    Node* child;     // first element or member
+  };
+};
+
+}  // namespace ArduinoJsonHost
+
+class JsonArray;
+class JsonObject;
+
+class JsonVariant {
+ public:
+  JsonVariant() : node(nullptr) {}
+  explicit JsonVariant(ArduinoJsonHost::Node* node) : node(node) {}
+
+  JsonVariant operator[](const char* key) const {
+    if (node != nullptr && node->type == ArduinoJsonHost::Node::OBJECT) {
+      for (ArduinoJsonHost::Node* member = node->child; member != nullptr; member = member->next) {
+        if (strcmp(member->key, key) == 0) {
+          return JsonVariant(member);
+        }
+      }
+    }
+    return JsonVariant();
+  }
+
+  JsonVariant operator[](int index) const {
+    if (node != nullptr && node->type == ArduinoJsonHost::Node::ARRAY && index >= 0) {
+      ArduinoJsonHost::Node* element = node->child;
+      while (element != nullptr && index-- > 0) {
+        element = element->next;
+      }
+      return JsonVariant(element);
+    }
+    return JsonVariant();
+  }
+
+  bool isNull() const { return node == nullptr || node->type == ArduinoJsonHost::Node::NUL; }
+
+  size_t size() const {
+    return node != nullptr && (node->type == ArduinoJsonHost::Node::ARRAY || node->type == ArduinoJsonHost::Node::OBJECT)
+               ? node->size : 0;
+  }
+
+  // The default is returned when the value is missing or of another type,
+  // including integers out of the requested type's range
+  int operator|(int fallback) const { return integerOr(INT_MIN, INT_MAX, fallback); }
+  long operator|(long fallback) const { return integerOr(LONG_MIN, LONG_MAX, fallback); }
+  bool operator|(bool fallback) const {
+    return node != nullptr && node->type == ArduinoJsonHost::Node::BOOLEAN ? node->boolean : fallback;
+  }
+  const char* operator|(const char* fallback) const {
+    return node != nullptr && node->type == ArduinoJsonHost::Node::STRING ? node->string : fallback;
+  }
+
+  template <typename T> bool is() const;
+  template <typename T> T as() const;
+
+ protected:
+  long long integerOr(long long low, long long high, long long fallback) const {
+    if (node == nullptr || node->type != ArduinoJsonHost::Node::INTEGER || node->integer < low || node->integer > high) {
+      return fallback;
+    }
+    return node->integer;
+  }
+
+  ArduinoJsonHost::Node* node;
+};
+
+template <> inline bool JsonVariant::is<JsonArray>() const {
+  return node != nullptr && node->type == ArduinoJsonHost::Node::ARRAY;
+}
+template <> inline bool JsonVariant::is<JsonObject>() const {
+  return node != nullptr && node->type == ArduinoJsonHost::Node::OBJECT;
+}
+template <> inline bool JsonVariant::is<int>() const {
+  return node != nullptr && node->type == ArduinoJsonHost::Node::INTEGER && node->integer >= INT_MIN &&
+         node->integer <= INT_MAX;
+}
+template <> inline bool JsonVariant::is<long>() const {
+  return node != nullptr && node->type == ArduinoJsonHost::Node::INTEGER && node->integer >= LONG_MIN &&
+         node->integer <= LONG_MAX;
+}
+template <> inline bool JsonVariant::is<bool>() const {
+  return node != nullptr && node->type == ArduinoJsonHost::Node::BOOLEAN;
+}
+template <> inline bool JsonVariant::is<const char*>() const {
+  return node != nullptr && node->type == ArduinoJsonHost::Node::STRING;
+}
+
+class JsonArray : public JsonVariant {
+ public:
+  JsonArray() {}
+  JsonArray(const JsonVariant& variant) : JsonVariant(variant.is<JsonArray>() ? variant : JsonVariant()) {}
+};
+
+class JsonObject : public JsonVariant {
+ public:
+  JsonObject() {}
+  JsonObject(const JsonVariant& variant) : JsonVariant(variant.is<JsonObject>() ? variant : JsonVariant()) {}
+};
+
+template <> inline int JsonVariant::as<int>() const { return *this | 0; }
+template <> inline long JsonVariant::as<long>() const { return *this | 0L; }
+template <> inline bool JsonVariant::as<bool>() const { return *this | false; }
+template <> inline const char* JsonVariant::as<const char*>() const { return *this | (const char*)nullptr; }
+template <> inline JsonArray JsonVariant::as<JsonArray>() const { return JsonArray(*this); }
+template <> inline JsonObject JsonVariant::as<JsonObject>() const { return JsonObject(*this); }
+
+class DeserializationError {
+ public:
+  enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+  DeserializationError(Code code = Ok) : error(code) {}
+  Code code() const { return error; }
+  explicit operator bool() const { return error != Ok; }
+  const char* c_str() const {
+    static const char* const names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep"};
+    return names[error];
+  }
+
+ private:
+  Code error;
+};
+
+class JsonDocument : public JsonVariant {
+ public:
+  JsonDocument(const JsonDocument&) = delete;
+  JsonDocument& operator=(const JsonDocument&) = delete;
+
+  void clear() {
+    used = 0;
+    node = nullptr;
+  }
+  size_t capacity() const { return poolSize * SLOT_SIZE; }
+  size_t memoryUsage() const { return used * SLOT_SIZE; }
+
+  // ArduinoJson's slot on a 32-bit target, which is what capacities are
+  // sized against
+  static const size_t SLOT_SIZE = 16;
+
+ protected:
+  JsonDocument(ArduinoJsonHost::Node* pool, size_t poolSize) : pool(pool), poolSize(poolSize), used(0) {}
+
+ private:
+  ArduinoJsonHost::Node* pool;
+  size_t poolSize;
+  size_t used;
+
+  friend DeserializationError deserializeJson(JsonDocument& doc, char* input, size_t length);
+  friend class JsonParser;
+};
+
+template <size_t CAPACITY>
+class StaticJsonDocument : public JsonDocument {
+ public:
+  StaticJsonDocument() : JsonDocument(nodes, sizeof(nodes) / sizeof(nodes[0])) {}
+
+ private:
+  ArduinoJsonHost::Node nodes[CAPACITY / SLOT_SIZE > 0 ? CAPACITY / SLOT_SIZE : 1];
+};
+
+// Recursive descent over [input, end). Strings are unescaped in place and
+// terminated where their closing quote was.
+class JsonParser {
+ public:
+  static const int NESTING_LIMIT = 10;
+
+  JsonParser(JsonDocument& doc, char* input, size_t length) : doc(doc), in(input), end(input + length) {}
+
+  DeserializationError parse() {
+    skipSpace();
+    if (in == end) {
+      return DeserializationError::EmptyInput;
+    }
+    ArduinoJsonHost::Node* root = nullptr;
+    DeserializationError::Code code = parseValue(root, 0);
+    if (code == DeserializationError::Ok) {
+      doc.node = root;
+    }
+    return code;
+  }
+
+ private:
+  typedef ArduinoJsonHost::Node Node;
+
+  DeserializationError::Code newNode(Node*& node) {
+    if (doc.used == doc.poolSize) {
+      return DeserializationError::NoMemory;
+    }
+    node = &doc.pool[doc.used++];
+    node->type = Node::NUL;
+    node->size = 0;
+    node->key = nullptr;
+    node->next = nullptr;
+    node->child = nullptr;
+    return DeserializationError::Ok;
+  }
+
+  void skipSpace() {
+    while (in < end && (*in == ' ' || *in == '\t' || *in == '\r' || *in == '\n')) {
+      in++;
+    }
+  }
+
+  bool consume(const char* word) {
+    size_t length = strlen(word);
+    if ((size_t)(end - in) < length || strncmp(in, word, length) != 0) {
+      return false;
+    }
+    in += length;
+    return true;
+  }
+
+  DeserializationError::Code parseValue(Node*& node, int depth) {
+    DeserializationError::Code code = newNode(node);
+    if (code != DeserializationError::Ok) {
+      return code;
+    }
+    skipSpace();
+    if (in == end) {
+      return DeserializationError::IncompleteInput;
+    }
+    switch (*in) {
+      case '{':
+      case '[':
+        if (depth >= NESTING_LIMIT) {
+          return DeserializationError::TooDeep;
+        }
+        return parseContainer(node, depth);
+      case '"':
+        node->type = Node::STRING;
+        return parseString(node->string);
+      case 't':
+      case 'f':
+        node->type = Node::BOOLEAN;
+        node->boolean = *in == 't';
+        return consume(node->boolean ? "true" : "false") ? DeserializationError::Ok : DeserializationError::InvalidInput;
+      case 'n':
+        return consume("null") ? DeserializationError::Ok : DeserializationError::InvalidInput;
+      default:
+        return parseNumber(node);
+    }
+  }
+
+  DeserializationError::Code parseContainer(Node* node, int depth) {
+    bool object = *in++ == '{';
+    char close = object ? '}' : ']';
+    node->type = object ? Node::OBJECT : Node::ARRAY;
+    Node** link = &node->child;
+    skipSpace();
+    if (in < end && *in == close) {
+      in++;
+      return DeserializationError::Ok;
+    }
+    for (;;) {
+      const char* key = nullptr;
+      if (object) {
+        skipSpace();
+        if (in == end) {
+          return DeserializationError::IncompleteInput;
+        }
+        if (*in != '"') {
+          return DeserializationError::InvalidInput;
+        }
+        DeserializationError::Code code = parseString(key);
+        if (code != DeserializationError::Ok) {
+          return code;
+        }
+        skipSpace();
+        if (in == end) {
+          return DeserializationError::IncompleteInput;
+        }
+        if (*in++ != ':') {
+          return DeserializationError::InvalidInput;
+        }
+      }
+      Node* child;
+      DeserializationError::Code code = parseValue(child, depth + 1);
+      if (code != DeserializationError::Ok) {
+        return code;
+      }
+      child->key = key;
+      *link = child;
+      link = &child->next;
+      node->size++;
+
+      skipSpace();
+      if (in == end) {
+        return DeserializationError::IncompleteInput;
+      }
+      char c = *in++;
+      if (c == close) {
+        return DeserializationError::Ok;
+      }
+      if (c != ',') {
+        return DeserializationError::InvalidInput;
+      }
+    }
+  }
+
+  static int hexValue(char c) {
+    return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+  }
+
+  DeserializationError::Code parseString(const char*& string) {
+    char* out = ++in;
+    string = out;
+    while (in < end) {
+      char c = *in++;
+      if (c == '"') {
+        *out = '\0';
+        return DeserializationError::Ok;
+      }
+      if (c != '\\') {
+        *out++ = c;
+        continue;
+      }
+      if (in == end) {
+        break;
+      }
+      c = *in++;
+      switch (c) {
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u': {
+          if (end - in < 4) {
+            return DeserializationError::IncompleteInput;
+          }
+          long code = 0;
+          for (int i = 0; i < 4; i++) {
+            int digit = hexValue(in[i]);
+            if (digit < 0) {
+              return DeserializationError::InvalidInput;
+            }
+            code = code << 4 | digit;
+          }
+          in += 4;
+          // UTF-8; an escape is never shorter than its encoding
+          if (code < 0x80) {
+            *out++ = code;
+          } else if (code < 0x800) {
+            *out++ = 0xC0 | code >> 6;
+            *out++ = 0x80 | (code & 0x3F);
+          } else {
+            *out++ = 0xE0 | code >> 12;
+            *out++ = 0x80 | ((code >> 6) & 0x3F);
+            *out++ = 0x80 | (code & 0x3F);
+          }
+          break;
+        }
+        default:
+          *out++ = c;  // \" \\ \/
+          break;
+      }
+    }
+    return DeserializationError::IncompleteInput;
+  }
+
+  DeserializationError::Code parseNumber(Node* node) {
+    // The body isn't terminated where the value ends, so copy it out first
+    char text[32];
+    size_t n = 0;
+    while (in + n < end && n < sizeof(text) - 1 && strchr("0123456789+-.eE", in[n]) != nullptr) {
+      text[n] = in[n];
+      n++;
+    }
+    text[n] = '\0';
+    if (n == 0) {
+      return DeserializationError::InvalidInput;
+    }
+    char* stop;
+    errno = 0;
+    long long integer = strtoll(text, &stop, 10);
+    if (*stop == '\0' && errno == 0) {
+      node->type = Node::INTEGER;
+      node->integer = integer;
+    } else {
+      node->real = strtod(text, &stop);
+      if (*stop != '\0') {
+        return DeserializationError::InvalidInput;
+      }
+      node->type = Node::REAL;
+    }
+    in += n;
+    return DeserializationError::Ok;
+  }
+
+  JsonDocument& doc;
+  char* in;
+  char* end;
+};
+
+inline DeserializationError deserializeJson(JsonDocument& doc, char* input, size_t length) {
+  doc.clear();
+  return JsonParser(doc, input, length).parse();
+}
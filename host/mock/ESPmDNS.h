@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+class MDNSResponder {
+ public:
+  bool begin(const char* hostname) { return true; }
+  bool addService(const char* service, const char* protocol, uint16_t port) { return true; }
+  bool addServiceTxt(const char* service, const char* protocol, const char* key, const char* value) { return true; }
+};
+
+extern MDNSResponder MDNS;
@@ -0,0 +1,49 @@
+// Arduino's File/FS over stdio. Paths are rooted at host::fsRoot(), a
+// directory on the host standing in for the flash partition.
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FileImpl;
+
+class File {
+ public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+  explicit operator bool() const;
+  size_t read(uint8_t* buffer, size_t size);
+  size_t write(const uint8_t* buffer, size_t size);
+  bool seek(uint32_t position, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void flush();
+  void close() { impl.reset(); }
+  bool isDirectory() const;
+  const char* name() const;
+  File openNextFile();
+
+ private:
+  std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+ public:
+  File open(const char* path, const char* mode = "r");
+  bool exists(const char* path);
+  bool remove(const char* path);
+  bool rename(const char* from, const char* to);
+  bool mkdir(const char* path);
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekSet;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+
+class IPAddress : public Printable {
+ public:
+  IPAddress() : address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+  IPAddress(uint32_t address) : address(address) {}
+  operator uint32_t() const { return address; }
+  uint8_t operator[](int index) const { return address >> (8 * index); }
+
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(text);
+  }
+  size_t printTo(Print& out) const override { return out.print(toString()); }
+
+ private:
+  uint32_t address;  // network order, as lwip keeps it
+};
@@ -0,0 +1,13 @@
+// NVS kept in fixed memory for the life of the process, so the coalesced
+// writes in loop() cost no heap here either
+#pragma once
+
+#include <Arduino.h>
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) { return true; }
+  size_t putBytes(const char* key, const void* value, size_t length);
+  size_t getBytes(const char* key, void* buffer, size_t length);
+  bool remove(const char* key);
+};
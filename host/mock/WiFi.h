@@ -0,0 +1,44 @@
+// The host is always associated: begin() succeeds at once and the station
+// address is the loopback one
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL,
+  WL_SCAN_COMPLETED,
+  WL_CONNECTED,
+  WL_CONNECT_FAILED,
+  WL_CONNECTION_LOST,
+  WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2 } wifi_mode_t;
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+typedef enum { ARDUINO_EVENT_WIFI_STA_CONNECTED = 4, ARDUINO_EVENT_MAX = 50 } arduino_event_id_t;
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+
+class WiFiClass {
+ public:
+  bool mode(wifi_mode_t mode) { return true; }
+  bool setAutoReconnect(bool enable) { return true; }
+  bool setSleep(wifi_ps_type_t type) { return true; }
+  bool config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns = IPAddress()) { return true; }
+  int onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX) { return 0; }
+  wl_status_t begin(const char* ssid, const char* password, int32_t channel = 0, const uint8_t* bssid = nullptr) {
+    return WL_CONNECTED;
+  }
+  bool disconnect() { return true; }
+  wl_status_t status() { return WL_CONNECTED; }
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+  uint8_t* BSSID() { return bssid; }
+  int32_t channel() { return 1; }
+  int8_t RSSI() { return -50; }
+
+ private:
+  uint8_t bssid[6] = {0x02, 0, 0, 0, 0, 1};
+};
+
+extern WiFiClass WiFi;
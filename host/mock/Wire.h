@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Arduino.h>
+
+class TwoWire {
+ public:
+  bool begin(int sda, int scl, uint32_t frequency) { return true; }
+  void beginTransmission(uint16_t address) {}
+  uint8_t endTransmission(bool sendStop = true) { return 0; }
+  size_t write(uint8_t data) { return 1; }
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/eventfd.h>
+#include <esp_timer.h>
+
+typedef struct {
+  size_t max_fds;
+} esp_vfs_eventfd_config_t;
+
+#define ESP_VFS_EVENTD_CONFIG_DEFAULT() {5}
+
+inline esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t* config) {
+  return ESP_OK;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <driver/ledc.h>
+#include <soc/ledc_struct.h>
+
+#define LEDC_LL_GET_HW() (&LEDC)
+
+// Duty is 4 fractional bits, as on the chip
+static inline void ledc_ll_set_duty_int_part(ledc_dev_t* hw, ledc_mode_t mode, ledc_channel_t channel, uint32_t duty) {
+  hw->channel_group[mode].channel[channel].duty = duty << 4;
+}
+
+static inline void ledc_ll_set_duty_start(ledc_dev_t* hw, ledc_mode_t mode, ledc_channel_t channel, bool start) {
+  uint32_t conf1 = hw->channel_group[mode].channel[channel].conf1;
+  hw->channel_group[mode].channel[channel].conf1 = (conf1 & ~(1u << 31)) | ((uint32_t)start << 31);
+}
+
+static inline void ledc_ll_ls_channel_update(ledc_dev_t* hw, ledc_mode_t mode, ledc_channel_t channel) {
+  if (mode == LEDC_LOW_SPEED_MODE) {
+    hw->channel_group[mode].channel[channel].conf0 |= 1u << 4;
+  }
+}
@@ -0,0 +1,59 @@
+// Controls for the host runtime that stands in for the ESP32 under the
+// sketch. Programs and tests call these before setup().
+#pragma once
+
+#include <stdint.h>
+#include <freertos/task.h>
+
+namespace host {
+
+// Time. The clock is the host's monotonic clock from program start until
+// useVirtualClock(); from then on it only moves when advanceClock() or a
+// wait moves it. A wait for a notification that hasn't come runs the clock
+// forward to the next armed esp_timer, plus whatever timerLateness
+// returns, and fires it.
+void useVirtualClock();
+void advanceClock(int64_t us);
+void setTimerLateness(int64_t (*lateness)());
+
+// Tasks created after holdTasks() get a handle but no thread. A test runs
+// their body itself after enterTask(), which makes the calling thread that
+// task for notifications.
+void holdTasks();
+void enterTask(TaskHandle_t task);
+
+// Network. Device ports (80, the UDP stream and fleet ports) are bound at
+// port + offset, or on any free port; boundPort() says where one ended up.
+// A shared port is bound as it is, so several simulated devices can listen
+// on it together (the fleet's multicast port).
+void setPortOffset(int offset);
+void sharePort(uint16_t devicePort);
+void useEphemeralPorts();
+uint16_t boundPort(uint16_t devicePort);
+
+// The directory standing in for the LittleFS partition, "littlefs" unless
+// set
+void setFsRoot(const char* path);
+const char* fsRoot();
+
+// Time the calling thread has spent in delay(), vTaskDelay() and
+// ulTaskNotifyTake(), and how many calls it made to them: waits that would
+// block a FreeRTOS task
+uint64_t waitedMicros();
+uint64_t blockingCalls();
+
+// Copies Serial output to stdout
+void echoSerial(bool enabled);
+
+// Heap allocations (malloc, calloc, realloc, new; calls from inside the C
+// library aren't seen) by the calling thread, and by every thread
+uint64_t allocations();
+uint64_t totalAllocations();
+
+// Bytes of heap in use by every thread, and the most in use since the
+// last resetHeapPeak(), which returns what is in use now
+int64_t heapInUse();
+int64_t resetHeapPeak();
+int64_t heapPeak();
+
+}  // namespace host
@@ -0,0 +1,17 @@
+// lwip's BSD API is close enough to the host's to use as is. bind() goes
+// through the runtime, as lwip maps it onto lwip_bind(), so simulations
+// can move the device ports (see host::portOffset()).
+#pragma once
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen);
+
+#define bind(s, name, namelen) lwip_bind(s, name, namelen)
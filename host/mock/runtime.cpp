@@ -0,0 +1,750 @@
+// Host runtime for LED_IOT.cpp: the clock, tasks and timers, Serial,
+// sockets, NVS, the flash filesystem and the peripherals the mock headers
+// declare.
+
+#include <Arduino.h>
+#include <ESPmDNS.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <driver/ledc.h>
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+#include <soc/ledc_struct.h>
+
+#include <dirent.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "host.h"
+
+#undef bind
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+MDNSResponder MDNS;
+ledc_dev_t LEDC;
+TwoWire Wire;
+fs::LittleFSFS LittleFS;
+
+// Allocation counting. Every object of the programs is linked with
+// --wrap=malloc,calloc,realloc,free, so their calls land here first. Heap
+// in use is counted in the allocator's usable sizes.
+
+static thread_local uint64_t threadAllocations = 0;
+static std::atomic<uint64_t> allAllocations(0);
+static std::atomic<int64_t> heapBytes(0);
+static std::atomic<int64_t> heapPeakBytes(0);
+
+static void countHeap(int64_t change) {
+  int64_t now = heapBytes.fetch_add(change, std::memory_order_relaxed) + change;
+  int64_t peak = heapPeakBytes.load(std::memory_order_relaxed);
+  while (now > peak && !heapPeakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+  }
+}
+
+static void* countAllocation(void* pointer) {
+  threadAllocations++;
+  allAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (pointer != nullptr) {
+    countHeap(malloc_usable_size(pointer));
+  }
+  return pointer;
+}
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+void* __wrap_malloc(size_t size) {
+  return countAllocation(__real_malloc(size));
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  return countAllocation(__real_calloc(count, size));
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+  size_t before = pointer != nullptr ? malloc_usable_size(pointer) : 0;
+  void* moved = __real_realloc(pointer, size);
+  if (moved != nullptr || size == 0) {
+    countHeap(-(int64_t)before);
+  }
+  return countAllocation(moved);
+}
+
+void __wrap_free(void* pointer) {
+  if (pointer != nullptr) {
+    countHeap(-(int64_t)malloc_usable_size(pointer));
+  }
+  __real_free(pointer);
+}
+}
+
+void* operator new(size_t size) {
+  void* pointer = __wrap_malloc(size != 0 ? size : 1);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+  free(pointer);
+}
+
+uint64_t host::allocations() {
+  return threadAllocations;
+}
+
+uint64_t host::totalAllocations() {
+  return allAllocations.load(std::memory_order_relaxed);
+}
+
+int64_t host::heapInUse() {
+  return heapBytes.load(std::memory_order_relaxed);
+}
+
+int64_t host::resetHeapPeak() {
+  int64_t now = heapBytes.load(std::memory_order_relaxed);
+  heapPeakBytes.store(now, std::memory_order_relaxed);
+  return now;
+}
+
+int64_t host::heapPeak() {
+  return heapPeakBytes.load(std::memory_order_relaxed);
+}
+
+// Clock
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::atomic<bool> virtualClock(false);
+static std::atomic<int64_t> virtualNowUs(0);
+static const uint32_t CPU_MHZ = 240;
+
+static int64_t hostNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void host::useVirtualClock() {
+  virtualNowUs = esp_timer_get_time();
+  virtualClock = true;
+}
+
+void host::advanceClock(int64_t us) {
+  virtualNowUs += us;
+}
+
+int64_t esp_timer_get_time() {
+  return virtualClock ? virtualNowUs.load() : hostNanoseconds() / 1000;
+}
+
+unsigned long millis() {
+  return esp_timer_get_time() / 1000;
+}
+
+unsigned long micros() {
+  return esp_timer_get_time();
+}
+
+uint32_t EspClass::getCycleCount() {
+  return virtualClock ? virtualNowUs.load() * CPU_MHZ : hostNanoseconds() * CPU_MHZ / 1000;
+}
+
+uint32_t getCpuFrequencyMhz() {
+  return CPU_MHZ;
+}
+
+uint64_t EspClass::getEfuseMac() {
+  // Distinct per process, so simulated fleet nodes get distinct ids
+  return (uint64_t)getpid() << 24 | 0x24;
+}
+
+static thread_local uint64_t threadWaitedUs = 0;
+static thread_local uint64_t threadBlockingCalls = 0;
+
+uint64_t host::waitedMicros() {
+  return threadWaitedUs;
+}
+
+uint64_t host::blockingCalls() {
+  return threadBlockingCalls;
+}
+
+void delay(unsigned long ms) {
+  vTaskDelay(ms);
+}
+
+// Tasks
+
+struct Task {
+  std::mutex mutex;
+  std::condition_variable wake;
+  uint32_t notifications = 0;
+};
+
+static bool tasksHeld = false;
+static Task loopTask;
+static thread_local Task* currentTask = nullptr;
+static int64_t (*timerLateness)() = nullptr;
+
+void host::holdTasks() {
+  tasksHeld = true;
+}
+
+void host::enterTask(TaskHandle_t task) {
+  currentTask = (Task*)task;
+}
+
+void host::setTimerLateness(int64_t (*lateness)()) {
+  timerLateness = lateness;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core) {
+  Task* task = new Task;
+  if (created != nullptr) {
+    *created = task;
+  }
+  if (!tasksHeld) {
+    std::thread([=] {
+      currentTask = task;
+      function(parameter);
+    }).detach();
+  }
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return currentTask != nullptr ? currentTask : &loopTask;
+}
+
+void xTaskNotifyGive(TaskHandle_t handle) {
+  Task* task = (Task*)handle;
+  if (task == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->notifications++;
+  task->wake.notify_one();
+}
+
+static bool fireNextTimer(int64_t limit);
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+  threadBlockingCalls++;
+  Task* task = (Task*)xTaskGetCurrentTaskHandle();
+  int64_t start = esp_timer_get_time();
+
+  if (virtualClock) {
+    int64_t limit = ticksToWait == portMAX_DELAY ? INT64_MAX : start + ticksToWait * 1000LL;
+    while (task->notifications == 0 && fireNextTimer(limit)) {
+    }
+    if (task->notifications == 0 && limit != INT64_MAX) {
+      virtualNowUs = max(virtualNowUs.load(), limit);
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(task->mutex);
+  if (!virtualClock) {
+    auto notified = [&] { return task->notifications > 0; };
+    if (ticksToWait == portMAX_DELAY) {
+      task->wake.wait(lock, notified);
+    } else {
+      task->wake.wait_for(lock, std::chrono::milliseconds(ticksToWait), notified);
+    }
+  }
+  uint32_t value = task->notifications;
+  if (clearOnExit) {
+    task->notifications = 0;
+  } else if (value > 0) {
+    task->notifications--;
+  }
+  threadWaitedUs += esp_timer_get_time() - start;
+  return value;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  threadBlockingCalls++;
+  if (virtualClock) {
+    virtualNowUs += ticks * 1000LL;
+    threadWaitedUs += ticks * 1000LL;
+    return;
+  }
+  int64_t start = hostNanoseconds();
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+  threadWaitedUs += (hostNanoseconds() - start) / 1000;
+}
+
+// esp_timer. Under the real clock each timer has a thread of its own;
+// under the virtual one they fire from fireNextTimer().
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void* arg;
+  std::mutex mutex;
+  std::condition_variable changed;
+  int64_t due = -1;
+  esp_timer* nextTimer;
+};
+
+static esp_timer* timers = nullptr;
+
+static void runTimer(esp_timer* timer) {
+  std::unique_lock<std::mutex> lock(timer->mutex);
+  for (;;) {
+    if (timer->due < 0) {
+      timer->changed.wait(lock);
+      continue;
+    }
+    int64_t untilDue = timer->due - esp_timer_get_time();
+    if (untilDue > 0) {
+      timer->changed.wait_for(lock, std::chrono::microseconds(untilDue));
+      continue;
+    }
+    timer->due = -1;
+    lock.unlock();
+    timer->callback(timer->arg);
+    lock.lock();
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* created) {
+  esp_timer* timer = new esp_timer;
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->nextTimer = timers;
+  timers = timer;
+  if (!virtualClock) {
+    std::thread(runTimer, timer).detach();
+  }
+  *created = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+  std::lock_guard<std::mutex> lock(timer->mutex);
+  timer->due = esp_timer_get_time() + timeoutUs;
+  timer->changed.notify_one();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  std::lock_guard<std::mutex> lock(timer->mutex);
+  timer->due = -1;
+  timer->changed.notify_one();
+  return ESP_OK;
+}
+
+// Moves the virtual clock to the earliest armed timer, if it is due by
+// limit, and fires it
+static bool fireNextTimer(int64_t limit) {
+  esp_timer* next = nullptr;
+  for (esp_timer* timer = timers; timer != nullptr; timer = timer->nextTimer) {
+    if (timer->due >= 0 && (next == nullptr || timer->due < next->due)) {
+      next = timer;
+    }
+  }
+  if (next == nullptr || next->due > limit) {
+    return false;
+  }
+  int64_t late = timerLateness != nullptr ? timerLateness() : 0;
+  virtualNowUs = max(virtualNowUs.load(), next->due + late);
+  next->due = -1;
+  next->callback(next->arg);
+  return true;
+}
+
+// Power management: nothing to configure, and light sleep isn't available
+
+struct esp_pm_lock {
+  int held;
+};
+
+esp_err_t esp_pm_configure(const void* config) {
+  return ((const esp_pm_config_t*)config)->light_sleep_enable ? ESP_ERR_NOT_SUPPORTED : ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char* name, esp_pm_lock_handle_t* handle) {
+  *handle = new esp_pm_lock{0};
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+  handle->held++;
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+  handle->held--;
+  return ESP_OK;
+}
+
+// Sockets
+
+static int portOffset = 0;
+static bool ephemeralPorts = false;
+static const int MAX_BOUND_PORTS = 8;
+static std::atomic<uint32_t> boundPorts[MAX_BOUND_PORTS];  // device port << 16 | host port
+static const int MAX_SHARED_PORTS = 4;
+static uint16_t sharedPorts[MAX_SHARED_PORTS];
+
+void host::setPortOffset(int offset) {
+  portOffset = offset;
+}
+
+void host::sharePort(uint16_t devicePort) {
+  for (int i = 0; i < MAX_SHARED_PORTS; i++) {
+    if (sharedPorts[i] == 0 || sharedPorts[i] == devicePort) {
+      sharedPorts[i] = devicePort;
+      return;
+    }
+  }
+}
+
+static bool portShared(uint16_t devicePort) {
+  for (int i = 0; i < MAX_SHARED_PORTS; i++) {
+    if (sharedPorts[i] == devicePort) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void host::useEphemeralPorts() {
+  ephemeralPorts = true;
+}
+
+uint16_t host::boundPort(uint16_t devicePort) {
+  for (int i = 0; i < MAX_BOUND_PORTS; i++) {
+    uint32_t entry = boundPorts[i].load();
+    if (entry >> 16 == devicePort) {
+      return entry & 0xFFFF;
+    }
+  }
+  return 0;
+}
+
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen) {
+  if (name->sa_family != AF_INET || namelen < sizeof(sockaddr_in)) {
+    return bind(s, name, namelen);
+  }
+  sockaddr_in address = *(const sockaddr_in*)name;
+  uint16_t devicePort = ntohs(address.sin_port);
+  if (ephemeralPorts) {
+    address.sin_port = 0;
+  } else if (!portShared(devicePort)) {
+    address.sin_port = htons(devicePort + portOffset);
+  }
+  if (bind(s, (sockaddr*)&address, sizeof(address)) < 0) {
+    return -1;
+  }
+
+  socklen_t length = sizeof(address);
+  getsockname(s, (sockaddr*)&address, &length);
+  for (int i = 0; i < MAX_BOUND_PORTS; i++) {
+    uint32_t entry = boundPorts[i].load();
+    if (entry == 0 || entry >> 16 == devicePort) {
+      boundPorts[i] = (uint32_t)devicePort << 16 | ntohs(address.sin_port);
+      break;
+    }
+  }
+  return 0;
+}
+
+// Serial
+
+static bool serialEcho = false;
+
+void host::echoSerial(bool enabled) {
+  serialEcho = enabled;
+  // A line at a time, as a serial monitor shows it
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+}
+
+size_t Print::printf(const char* format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (n < 0) {
+    return 0;
+  }
+  return write((const uint8_t*)text, min((size_t)n, sizeof(text) - 1));
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+  if (serialEcho) {
+    fwrite(data, 1, length, stdout);
+  }
+  return length;
+}
+
+void HardwareSerial::flush() {
+  if (serialEcho) {
+    fflush(stdout);
+  }
+}
+
+// Peripherals: pins and outputs are accepted and ignored. The LEDC duty
+// registers are the LEDC struct, which tests can read back.
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+// Timer conf: duty resolution in bits 0-4, the clock divider (8 fractional
+// bits) in 5-22. Channel conf0: timer in bits 0-1, output enable in bit 2.
+esp_err_t ledc_timer_config(const ledc_timer_config_t* config) {
+  uint32_t divider = (uint32_t)(80000000ULL * 256 / ((uint64_t)config->freq_hz << config->duty_resolution));
+  LEDC.timer_group[config->speed_mode].timer[config->timer_num].conf =
+      (uint32_t)config->duty_resolution | (divider << 5);
+  return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* config) {
+  LEDC.channel_group[config->speed_mode].channel[config->channel].conf0 = (uint32_t)config->timer_sel | 1u << 2;
+  LEDC.channel_group[config->speed_mode].channel[config->channel].hpoint = config->hpoint;
+  LEDC.channel_group[config->speed_mode].channel[config->channel].duty = config->duty << 4;
+  return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty) {
+  LEDC.channel_group[mode].channel[channel].duty = duty << 4;
+  return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel) {
+  LEDC.channel_group[mode].channel[channel].conf1 |= 1u << 31;
+  return ESP_OK;
+}
+
+esp_err_t ledc_timer_rst(ledc_mode_t mode, ledc_timer_t timer) {
+  LEDC.timer_group[mode].timer[timer].value.timer_cnt = 0;
+  return ESP_OK;
+}
+
+// NVS: a fixed table, kept for the life of the process
+
+static const int NVS_ENTRIES = 64;
+static const size_t NVS_KEY_SIZE = 16;    // 15 characters, as in NVS
+static const size_t NVS_VALUE_SIZE = 4096;
+
+struct NvsEntry {
+  char key[NVS_KEY_SIZE];
+  size_t length;
+  uint8_t value[NVS_VALUE_SIZE];
+};
+
+static NvsEntry nvs[NVS_ENTRIES];
+static std::mutex nvsMutex;
+
+static NvsEntry* findNvs(const char* key) {
+  for (int i = 0; i < NVS_ENTRIES; i++) {
+    if (nvs[i].key[0] != '\0' && strcmp(nvs[i].key, key) == 0) {
+      return &nvs[i];
+    }
+  }
+  return nullptr;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  if (strlen(key) >= NVS_KEY_SIZE || length > NVS_VALUE_SIZE) {
+    return 0;
+  }
+  NvsEntry* entry = findNvs(key);
+  for (int i = 0; i < NVS_ENTRIES && entry == nullptr; i++) {
+    if (nvs[i].key[0] == '\0') {
+      entry = &nvs[i];
+      strcpy(entry->key, key);
+    }
+  }
+  if (entry == nullptr) {
+    return 0;
+  }
+  memcpy(entry->value, value, length);
+  entry->length = length;
+  return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  NvsEntry* entry = findNvs(key);
+  if (entry == nullptr || entry->length > length) {
+    return 0;
+  }
+  memcpy(buffer, entry->value, entry->length);
+  return entry->length;
+}
+
+bool Preferences::remove(const char* key) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  NvsEntry* entry = findNvs(key);
+  if (entry == nullptr) {
+    return false;
+  }
+  entry->key[0] = '\0';
+  return true;
+}
+
+// LittleFS, as a directory on the host
+
+static std::string filesystemRoot = "littlefs";
+
+void host::setFsRoot(const char* path) {
+  filesystemRoot = path;
+}
+
+const char* host::fsRoot() {
+  return filesystemRoot.c_str();
+}
+
+static std::string hostPath(const char* path) {
+  return filesystemRoot + path;
+}
+
+namespace fs {
+
+struct FileImpl {
+  FILE* file = nullptr;
+  DIR* directory = nullptr;
+  std::string path;
+  std::string name;
+
+  ~FileImpl() {
+    if (file != nullptr) {
+      fclose(file);
+    }
+    if (directory != nullptr) {
+      closedir(directory);
+    }
+  }
+};
+
+File::operator bool() const {
+  return impl && (impl->file != nullptr || impl->directory != nullptr);
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+  return impl && impl->file != nullptr ? fread(buffer, 1, size, impl->file) : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  return impl && impl->file != nullptr ? fwrite(buffer, 1, size, impl->file) : 0;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+  return impl && impl->file != nullptr && fseek(impl->file, position, mode) == 0;
+}
+
+size_t File::position() const {
+  return impl && impl->file != nullptr ? ftell(impl->file) : 0;
+}
+
+size_t File::size() const {
+  struct stat info;
+  return impl && stat(impl->path.c_str(), &info) == 0 ? info.st_size : 0;
+}
+
+void File::flush() {
+  if (impl && impl->file != nullptr) {
+    fflush(impl->file);
+  }
+}
+
+bool File::isDirectory() const {
+  return impl && impl->directory != nullptr;
+}
+
+const char* File::name() const {
+  return impl ? impl->name.c_str() : "";
+}
+
+File File::openNextFile() {
+  if (!impl || impl->directory == nullptr) {
+    return File();
+  }
+  while (dirent* entry = readdir(impl->directory)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    auto next = std::make_shared<FileImpl>();
+    next->path = impl->path + "/" + entry->d_name;
+    next->name = entry->d_name;
+    next->file = fopen(next->path.c_str(), "rb");
+    return File(next);
+  }
+  return File();
+}
+
+File FS::open(const char* path, const char* mode) {
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = hostPath(path);
+  const char* slash = strrchr(path, '/');
+  impl->name = slash != nullptr ? slash + 1 : path;
+  struct stat info;
+  if (mode[0] == 'r' && stat(impl->path.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+    impl->directory = opendir(impl->path.c_str());
+  } else {
+    impl->file = fopen(impl->path.c_str(), mode[0] == 'w' ? "w+b" : mode[0] == 'a' ? "ab" : "rb");
+  }
+  return File(impl);
+}
+
+bool FS::exists(const char* path) {
+  struct stat info;
+  return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+  ::mkdir(filesystemRoot.c_str(), 0755);
+  struct stat info;
+  return stat(filesystemRoot.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+}  // namespace fs
@@ -0,0 +1,4 @@
+// The host build stands in for a classic ESP32
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32 1
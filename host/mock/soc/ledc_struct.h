@@ -0,0 +1,32 @@
+// The classic ESP32 LEDC register block, reduced to the fields the sketch
+// and hal/ledc_ll.h touch. The timer counters stay at 0 unless a test
+// moves them.
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+  struct {
+    struct {
+      volatile uint32_t conf0;
+      volatile uint32_t hpoint;
+      volatile uint32_t duty;
+      volatile uint32_t conf1;
+      volatile uint32_t duty_rd;
+    } channel[8];
+  } channel_group[2];
+  struct {
+    struct {
+      volatile uint32_t conf;
+      union {
+        struct {
+          volatile uint32_t timer_cnt : 20;
+          volatile uint32_t reserved : 12;
+        };
+        volatile uint32_t val;
+      } value;
+    } timer[4];
+  } timer_group[2];
+} ledc_dev_t;
+
+extern ledc_dev_t LEDC;
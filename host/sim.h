@@ -0,0 +1,188 @@
+// For host programs that drive the sketch from inside: the sketch itself,
+// so its internals are in scope, a way to boot it with loop() on a thread
+// of its own, as the Arduino core runs it, and a loopback HTTP client.
+#pragma once
+
+#include "LED_IOT.cpp"
+#include "host.h"
+
+#include <arpa/inet.h>
+#include <ftw.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+inline void removeFsRoot() {
+  nftw(host::fsRoot(), [](const char* path, const struct stat*, int, FTW*) { return ::remove(path); }, 8,
+       FTW_DEPTH | FTW_PHYS);
+}
+
+// Gives the sketch a fresh, empty flash, removed again at exit
+inline void useTempFsRoot() {
+  static char fsRoot[] = "/tmp/led-sim-XXXXXX";
+  if (mkdtemp(fsRoot) == nullptr) {
+    perror("mkdtemp");
+    exit(1);
+  }
+  host::setFsRoot(fsRoot);
+  atexit(removeFsRoot);
+}
+
+// After setup(): calls pass on a thread of its own for ever, and returns
+// once the web server is listening
+inline void runLoop(void (*pass)() = loop) {
+  std::thread([pass] {
+    for (;;) {
+      pass();
+    }
+  }).detach();
+  while (host::boundPort(HTTP_PORT) == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// Boots the sketch with a fresh flash and its ports wherever the host has
+// room, then runs loop() as above
+inline void startSketch(void (*pass)() = loop) {
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  setup();
+  runLoop(pass);
+}
+
+// Checks for the tests: a failure is reported and the test carries on;
+// main() returns failures() != 0
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+#define CHECK(condition, ...) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #condition); \
+      fprintf(stderr, __VA_ARGS__); \
+      fputc('\n', stderr); \
+      failures()++; \
+    } \
+  } while (0)
+
+inline int64_t hostNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Value at fraction p of the sorted samples
+template <typename T>
+T percentile(std::vector<T> samples, double p) {
+  if (samples.empty()) {
+    return T();
+  }
+  size_t index = std::min(samples.size() - 1, (size_t)(p * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+struct SimResponse {
+  int status = 0;
+  const char* body = "";
+  size_t bodyLength = 0;
+  double firstByteUs = 0;  // from the request sent to the first byte back
+};
+
+// A connection to the sketch's web server, made again whenever the server
+// closed the last one
+class SimClient {
+ public:
+  bool connect() {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(host::boundPort(HTTP_PORT));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+      return false;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return true;
+  }
+
+  void close() {
+    ::close(fd);
+    fd = -1;
+  }
+
+  // Sends a request and waits for the whole response. The body of a
+  // chunked response is left framed.
+  bool request(const char* method, const char* path, const char* body, SimResponse& response,
+               const char* headers = "") {
+    if (fd < 0 && !connect()) {
+      return false;
+    }
+    size_t bodyLength = body != nullptr ? strlen(body) : 0;
+    int n = snprintf(out, sizeof(out), "%s %s HTTP/1.1\r\nHost: led\r\n%sContent-Length: %zu\r\n\r\n%s",
+                     method, path, headers, bodyLength, body != nullptr ? body : "");
+    if (n < 0 || (size_t)n >= sizeof(out) || ::send(fd, out, n, MSG_NOSIGNAL) != n) {
+      return false;
+    }
+
+    int64_t sent = hostNanos();
+    received = 0;
+    do {
+      ssize_t got = ::recv(fd, in + received, sizeof(in) - 1 - received, 0);
+      if (got <= 0) {
+        return false;
+      }
+      if (received == 0) {
+        response.firstByteUs = (hostNanos() - sent) / 1000.0;
+      }
+      received += got;
+      in[received] = '\0';
+    } while (!complete(response));
+
+    const char* end = strstr(in, "\r\n\r\n");
+    const char* connection = strcasestr(in, "\r\nConnection: close");
+    if (connection != nullptr && connection < end) {
+      close();
+    }
+    return true;
+  }
+
+ private:
+  bool complete(SimResponse& response) {
+    char* end = strstr(in, "\r\n\r\n");
+    if (end == nullptr) {
+      return false;
+    }
+    response.status = atoi(in + 9);
+    response.body = end + 4;
+    size_t have = in + received - response.body;
+    const char* length = strcasestr(in, "\r\nContent-Length:");
+    if (length != nullptr && length < end) {
+      response.bodyLength = strtoul(length + 17, nullptr, 10);
+      return have >= response.bodyLength;
+    }
+    const char* chunked = strcasestr(in, "\r\nTransfer-Encoding: chunked");
+    if (chunked != nullptr && chunked < end) {
+      response.bodyLength = have;
+      return have >= 5 && memcmp(in + received - 5, "0\r\n\r\n", 5) == 0;
+    }
+    response.bodyLength = 0;
+    return response.status == 204 || response.status == 304;
+  }
+
+  int fd = -1;
+  char out[8192];
+  char in[64 * 1024];
+  size_t received = 0;
+};
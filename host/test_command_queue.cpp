@@ -0,0 +1,141 @@
+// The two lock-free paths between loop() and the LED engine, each run
+// flat out from two std::threads: the SPSC command ring and the seqlock
+// snapshot. Either side yields where the real task would block, which keeps
+// the test quick on a single core. The ring must hand over every command
+// intact and in order. The web side must only ever see whole snapshots,
+// never one torn by a publish in progress, and their versions must not go
+// backwards.
+
+#include "sim.h"
+
+const uint32_t RING_COMMANDS = 2000000;
+const uint32_t SNAPSHOT_PUBLISHES = 200000;
+
+static void testCommandRing() {
+  // Whatever setup() queued for the parked engine
+  LEDCommand leftover;
+  while (popCommand(leftover)) {
+  }
+
+  std::atomic<uint32_t> producerFull(0);
+  std::thread producer([&] {
+    uint32_t full = 0;
+    for (uint32_t i = 0; i < RING_COMMANDS; i++) {
+      LEDCommand cmd = {};
+      cmd.action = i & 0xff;
+      cmd.flags = (i >> 8) & 0xff;
+      cmd.ledNum = i % NUM_LEDS;
+      cmd.value = (int32_t)i;
+      cmd.fadeMs = ~i;
+      while (!pushCommand(cmd)) {
+        full++;
+        std::this_thread::yield();
+      }
+    }
+    producerFull = full;
+  });
+
+  uint32_t received = 0;
+  uint32_t corrupt = 0;
+  uint32_t outOfOrder = 0;
+  while (received < RING_COMMANDS) {
+    LEDCommand cmd;
+    if (!popCommand(cmd)) {
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t i = (uint32_t)cmd.value;
+    if (cmd.action != (i & 0xff) || cmd.flags != ((i >> 8) & 0xff) || cmd.ledNum != (int)(i % NUM_LEDS) ||
+        cmd.fadeMs != ~i) {
+      corrupt++;
+    }
+    if (i != received) {
+      outOfOrder++;
+    }
+    received++;
+  }
+  producer.join();
+
+  LEDCommand extra;
+  CHECK(!popCommand(extra), "the ring holds a command nobody pushed");
+  CHECK(corrupt == 0, "%u commands came out corrupted", corrupt);
+  CHECK(outOfOrder == 0, "%u commands came out of order", outOfOrder);
+  CHECK(commandQueueSpace() == COMMAND_QUEUE_SIZE, "%u slots free after draining", commandQueueSpace());
+  printf("command ring: %u commands through %u slots, producer found it full %u times\n", received,
+         COMMAND_QUEUE_SIZE, producerFull.load());
+}
+
+// Every field of every channel is derived from one generation number, so a
+// copy that mixes two publishes shows up as a disagreement
+static void setGeneration(uint32_t generation) {
+  for (int i = 0; i < NUM_LEDS; i++) {
+    channels.isOn[i] = generation & 1;
+    channels.brightness[i] = generation & 0xff;
+    channels.effect[i] = generation % 3;
+    channels.blinkInterval[i] = generation;
+  }
+}
+
+static bool snapshotWhole(const LEDSnapshot& snapshot) {
+  uint32_t generation = snapshot.leds[0].blinkInterval;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    const LEDStatus& status = snapshot.leds[i];
+    if (status.blinkInterval != generation || status.isOn != (bool)(generation & 1) ||
+        status.brightness != (generation & 0xff) || status.effect != generation % 3) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void testSnapshot() {
+  setGeneration(0);
+  publishSnapshot();
+  syncSnapshot();
+
+  std::atomic<bool> done(false);
+  std::thread engine([&] {
+    for (uint32_t generation = 1; generation <= SNAPSHOT_PUBLISHES; generation++) {
+      setGeneration(generation);
+      publishSnapshot();
+    }
+    done = true;
+  });
+
+  uint32_t syncs = 0;
+  uint32_t torn = 0;
+  uint32_t backwards = 0;
+  uint32_t lastVersion = statusSnapshot.version;
+  bool finished;
+  do {
+    finished = done.load();
+    syncSnapshot();
+    syncs++;
+    if (!snapshotWhole(statusSnapshot)) {
+      torn++;
+    }
+    if (statusSnapshot.version < lastVersion) {
+      backwards++;
+    }
+    lastVersion = statusSnapshot.version;
+  } while (!finished);
+  engine.join();
+
+  CHECK(torn == 0, "%u of %u syncs saw a torn snapshot", torn, syncs);
+  CHECK(backwards == 0, "the version went backwards %u times", backwards);
+  CHECK(statusSnapshot.leds[0].blinkInterval == SNAPSHOT_PUBLISHES,
+        "the last sync saw generation %u, not the last one published", statusSnapshot.leds[0].blinkInterval);
+  printf("snapshot: %u publishes, %u syncs, all whole\n", SNAPSHOT_PUBLISHES, syncs);
+}
+
+int main() {
+  // The sketch's own tasks stay parked; the threads below stand in for them
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::holdTasks();
+  setup();
+
+  testCommandRing();
+  testSnapshot();
+  return failures() != 0;
+}
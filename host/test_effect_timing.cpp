@@ -0,0 +1,92 @@
+// Blink timing on a virtual clock. The engine runs on the test thread and
+// sleeps until its esp_timer deadline, which fires up to 0.9 ms late, as it
+// can with the web server busy. Brightness commands arrive between the
+// deadlines, standing in for HTTP traffic. Every edge on the LEDC outputs
+// must land within 1 ms of its ideal time without drifting, and the engine
+// must only wake for deadlines and commands.
+
+#include "sim.h"
+
+static uint32_t randomState = 12345;
+
+static uint32_t nextRandom() {
+  randomState = randomState * 1664525 + 1013904223;
+  return randomState >> 8;
+}
+
+static int64_t timerLateness() {
+  return nextRandom() % 900;
+}
+
+static bool pinHigh(int ledNum) {
+  return LEDC.channel_group[ledcGroup(ledNum)].channel[ledcChannel(ledNum)].duty != 0;
+}
+
+int main() {
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::useVirtualClock();
+  host::holdTasks();
+  host::setTimerLateness(timerLateness);
+  setup();
+  host::enterTask(engineTaskHandle);
+
+  const long PERIODS_MS[NUM_LEDS] = {50, 73, 100, 125, 250, 333, 500, 1000};
+  const int64_t RUN_US = 20 * 1000000LL;
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < NUM_LEDS; i++) {
+    CHECK(queueLEDCommand(ACTION_BLINK, i, PERIODS_MS[i], 0, 0), "queue full");
+  }
+  runEngine();
+
+  bool high[NUM_LEDS];
+  int edges[NUM_LEDS] = {};
+  for (int i = 0; i < NUM_LEDS; i++) {
+    high[i] = pinHigh(i);
+    CHECK(high[i], "channel %d not on when its blink started", i);
+  }
+
+  int64_t worstLateUs = 0;
+  int commands = 0;
+  int wakeups = 0;
+  while (esp_timer_get_time() - start < RUN_US) {
+    // Now and then a command arrives while the engine sleeps
+    int64_t now = esp_timer_get_time();
+    if (nextRandom() % 3 == 0 && effectDue[0] - now > 2000) {
+      host::advanceClock(nextRandom() % (effectDue[0] - now - 1000));
+      CHECK(setLEDBrightness(nextRandom() % NUM_LEDS, 64 + nextRandom() % 192), "queue full");
+      commands++;
+    }
+
+    waitForEngineEvent();
+    runEngine();
+    wakeups++;
+
+    now = esp_timer_get_time();
+    for (int i = 0; i < NUM_LEDS; i++) {
+      if (pinHigh(i) == high[i]) {
+        continue;
+      }
+      high[i] = !high[i];
+      edges[i]++;
+      int64_t ideal = start + edges[i] * PERIODS_MS[i] * 1000LL;
+      int64_t late = now - ideal;
+      CHECK(late >= 0 && late <= 1000, "channel %d edge %d is %lld us off", i, edges[i], (long long)late);
+      worstLateUs = max(worstLateUs, late);
+    }
+  }
+
+  int totalEdges = 0;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    long expected = RUN_US / (PERIODS_MS[i] * 1000);
+    CHECK(labs(edges[i] - expected) <= 1, "channel %d: %d edges, expected %ld", i, edges[i], expected);
+    totalEdges += edges[i];
+  }
+  // Deadlines that coincide share a wakeup
+  CHECK(wakeups <= totalEdges + commands, "%d wakeups for %d edges and %d commands", wakeups, totalEdges, commands);
+
+  printf("%d edges on %d channels over %lld s, worst %lld us after the ideal time; %d engine wakeups for them "
+         "and %d commands\n", totalEdges, NUM_LEDS, (long long)(RUN_US / 1000000), (long long)worstLateUs, wakeups,
+         commands);
+  return failures() != 0;
+}
@@ -0,0 +1,107 @@
+// Fleet clock and group command admission, with packets handed straight to
+// handleFleetPacket() on a virtual clock. A node that started the fleet
+// clock itself then hears a lower-id synced node: it must follow it, and be
+// unsynced until a sample of the new leader's clock sets its offset. Then
+// a group command arrives while a stream holds the channels: it must be
+// counted as missed when it arrives, not scheduled. One admitted before a
+// stream starts runs when it falls due.
+
+#include "sim.h"
+
+const uint32_t THIS_NODE = 0x5001;
+const uint32_t LOWER_NODE = 0x1001;
+const int64_t LEADER_AHEAD_US = 5000000;  // the lower node's clock against ours
+
+static void receive(FleetPacketType type, uint32_t sender, const uint8_t* payload, size_t length) {
+  memcpy(fleetPacket, "LEDN", 4);
+  fleetPacket[4] = FLEET_VERSION;
+  fleetPacket[5] = type;
+  writeBigEndian(fleetPacket + 6, sender, 4);
+  writeBigEndian(fleetPacket + 10, 0, 4);
+  memcpy(fleetPacket + FLEET_HEADER_SIZE, payload, length);
+  handleFleetPacket(FLEET_HEADER_SIZE + length, htonl(INADDR_LOOPBACK), millis());
+  electFleetLeader();
+}
+
+static void receiveCommand(uint32_t sender, uint16_t id, int64_t due) {
+  uint8_t payload[15 + FLEET_GROUP_SIZE] = {};
+  writeBigEndian(payload, id, 2);
+  payload[2] = ACTION_ON;
+  writeBigEndian(payload + 3, 0, 4);
+  writeBigEndian(payload + 7, due, 8);
+  strcpy((char*)payload + 15, "*");
+  receive(FLEET_COMMAND, sender, payload, sizeof(payload));
+}
+
+static int scheduledCount() {
+  int count = 0;
+  for (int s = 0; s < MAX_FLEET_SCHEDULED; s++) {
+    count += fleetScheduled[s].active;
+  }
+  return count;
+}
+
+static void checkNewLeader() {
+  // As pumpFleet() leaves a node that heard no synced peer in time
+  fleetNode = THIS_NODE;
+  fleetSynced = true;
+  electFleetLeader();
+  CHECK(fleetLeader == THIS_NODE, "leader %08x, not this node", fleetLeader);
+
+  uint8_t beacon[1 + FLEET_GROUP_SIZE] = {1};
+  strcpy((char*)beacon + 1, "default");
+  receive(FLEET_BEACON, LOWER_NODE, beacon, sizeof(beacon));
+  CHECK(fleetLeader == LOWER_NODE, "leader %08x after a lower synced node was heard", fleetLeader);
+  CHECK(!fleetSynced, "still synced on its own clock after the leader changed");
+
+  // A sync exchange with a 1 ms round trip, answered halfway through
+  int64_t t1 = esp_timer_get_time();
+  host::advanceClock(1000);
+  uint8_t reply[16];
+  writeBigEndian(reply, t1, 8);
+  writeBigEndian(reply + 8, t1 + 500 + LEADER_AHEAD_US, 8);
+  receive(FLEET_SYNC_REPLY, LOWER_NODE, reply, sizeof(reply));
+  CHECK(fleetSynced, "not synced after a sample of the new leader's clock");
+  CHECK(fleetOffsetUs == LEADER_AHEAD_US, "offset %lld us, the leader is %lld us ahead", (long long)fleetOffsetUs,
+        (long long)LEADER_AHEAD_US);
+  printf("new leader: unsynced until its first sample, then offset %lld us\n", (long long)fleetOffsetUs);
+}
+
+static void checkStreamAdmission() {
+  streamActive = true;
+  streamPriority = STREAM_WEB_PRIORITY + 1;
+  streamFirst = 0;
+  streamCount = NUM_LEDS;
+  streamLastFrameTime = millis();
+
+  uint32_t missedBefore = fleetCommandsMissed;
+  receiveCommand(LOWER_NODE, 1, fleetTime() + FLEET_COMMAND_LEAD_US);
+  CHECK(fleetCommandsMissed == missedBefore + 1, "command under a stream not counted as missed when it arrived");
+  CHECK(scheduledCount() == 0, "command under a stream was scheduled");
+
+  // The stream times out; the next command is admitted, and still runs if
+  // a stream starts before it falls due
+  host::advanceClock(STREAM_TIMEOUT_MS * 1000);
+  receiveCommand(LOWER_NODE, 2, fleetTime() + FLEET_COMMAND_LEAD_US);
+  CHECK(scheduledCount() == 1, "command without a stream not scheduled");
+  streamLastFrameTime = millis();
+  host::advanceClock(FLEET_COMMAND_LEAD_US);
+  uint32_t runBefore = fleetCommandsRun;
+  runFleetSchedule();
+  CHECK(fleetCommandsRun == runBefore + 1 && scheduledCount() == 0, "admitted command didn't run when due");
+  CHECK(fleetCommandsMissed == missedBefore + 1, "admitted command counted as missed");
+  printf("stream priority: checked on arrival, %u missed, %u run\n", fleetCommandsMissed - missedBefore,
+         fleetCommandsRun - runBefore);
+}
+
+int main() {
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::useVirtualClock();
+  host::holdTasks();
+  setup();
+
+  checkNewLeader();
+  checkStreamAdmission();
+  return failures() != 0;
+}
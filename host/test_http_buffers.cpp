@@ -0,0 +1,191 @@
+// The web server's shared response buffers. Clients that stop reading hold
+// every buffer; a request from another client must then wait, not fail,
+// and be answered once one is given back. Parked long-polls hold no
+// buffer, and more of them than there are buffers are all answered when the
+// state changes. Chunked responses use the shortest size lines, and the
+// Prometheus histograms without labels have no empty braces.
+
+#include "sim.h"
+
+#include <poll.h>
+#include <string>
+
+static int rawConnect(int receiveBuffer = 0) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (receiveBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  }
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(host::boundPort(HTTP_PORT));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t length) {
+  while (length > 0) {
+    ssize_t n = ::send(fd, data, length, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+// Reads until the status line is in, for up to timeoutMs; 0 if it isn't
+static int readStatus(int fd, int timeoutMs) {
+  char head[16];
+  size_t have = 0;
+  int64_t deadline = hostNanos() + timeoutMs * 1000000LL;
+  while (have < 13) {
+    int64_t left = (deadline - hostNanos()) / 1000000;
+    pollfd p = {fd, POLLIN, 0};
+    if (left <= 0 || poll(&p, 1, (int)left) <= 0) {
+      return 0;
+    }
+    ssize_t n = ::recv(fd, head + have, sizeof(head) - have, 0);
+    if (n <= 0) {
+      return 0;
+    }
+    have += n;
+  }
+  return atoi(head + 9);
+}
+
+static bool waitFor(bool (*condition)(), int timeoutMs) {
+  for (int i = 0; i < timeoutMs && !condition(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return condition();
+}
+
+// Sends requests and reads nothing until the server stops taking them,
+// which it does once it is stuck writing a response
+static bool stallServer(int fd) {
+  static const char request[] = "GET / HTTP/1.1\r\nHost: led\r\n\r\n";
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  int64_t blockedSince = 0;
+  size_t sent = 0;
+  for (int64_t start = hostNanos(); hostNanos() - start < 10000000000LL;) {
+    ssize_t n = ::send(fd, request + sent, sizeof(request) - 1 - sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      sent = (sent + n) % (sizeof(request) - 1);
+      blockedSince = 0;
+    } else if (errno != EAGAIN) {
+      return false;
+    } else if (blockedSince == 0) {
+      blockedSince = hostNanos();
+    } else if (hostNanos() - blockedSince > 100000000) {
+      return true;
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return false;
+}
+
+static void checkRequestsWaitForABuffer() {
+  int stalled[HTTP_RESPONSE_BUFFERS];
+  for (int i = 0; i < HTTP_RESPONSE_BUFFERS; i++) {
+    stalled[i] = rawConnect(1024);
+    CHECK(stalled[i] >= 0 && stallServer(stalled[i]), "the server kept reading a client that doesn't read");
+  }
+  CHECK(!server.canRespond(), "the clients that don't read hold no buffers");
+
+  // Loopback lets the stalled responses creep on now and then, so the
+  // request may get a buffer before any client closes; it must not be
+  // turned away or dropped either way
+  int waiting = rawConnect();
+  const char request[] = "GET /api/status HTTP/1.1\r\nHost: led\r\n\r\n";
+  CHECK(sendAll(waiting, request, sizeof(request) - 1), "cannot send to the web server");
+  ::close(stalled[0]);
+  int status = readStatus(waiting, 2000);
+  CHECK(status == 200, "answered %d after waiting for a buffer", status);
+  printf("pool: %d clients not reading held every buffer; a request sent meanwhile got %d\n", HTTP_RESPONSE_BUFFERS,
+         status);
+
+  ::close(waiting);
+  for (int i = 1; i < HTTP_RESPONSE_BUFFERS; i++) {
+    ::close(stalled[i]);
+  }
+  CHECK(waitFor([] { return server.canRespond(); }, 2000), "closing the connections gave no buffer back");
+}
+
+static void checkLongPolls() {
+  SimClient client;
+  SimResponse response;
+  CHECK(client.connect() && client.request("GET", "/api/status?format=compact", nullptr, response) &&
+        response.status == 200, "GET /api/status failed");
+  unsigned long version = strtoul(strstr(response.body, "\"version\":") + 10, nullptr, 10);
+
+  char request[96];
+  int length = snprintf(request, sizeof(request), "GET /api/status?since=%lu&wait=10000 HTTP/1.1\r\n\r\n", version);
+  int polls[MAX_LONGPOLL_CLIENTS];
+  for (int i = 0; i < MAX_LONGPOLL_CLIENTS; i++) {
+    polls[i] = rawConnect();
+    CHECK(polls[i] >= 0 && sendAll(polls[i], request, length), "cannot send to the web server");
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  bool free = server.canRespond();
+  CHECK(free, "parked long-polls hold a response buffer");
+
+  CHECK(client.request("POST", "/api/all", "{\"action\":\"on\"}", response) && response.status == 200,
+        "POST /api/all failed");
+  int answered = 0;
+  for (int i = 0; i < MAX_LONGPOLL_CLIENTS; i++) {
+    int status = readStatus(polls[i], 2000);
+    CHECK(status == 200, "long-poll %d answered %d after the change", i, status);
+    answered += status == 200;
+    ::close(polls[i]);
+  }
+  printf("long-polls: %d parked on %d buffers, %d answered after the change\n", MAX_LONGPOLL_CLIENTS,
+         HTTP_RESPONSE_BUFFERS, answered);
+}
+
+static void checkMetrics() {
+  SimClient client;
+  SimResponse response;
+  CHECK(client.connect() && client.request("GET", "/api/metrics", nullptr, response) && response.status == 200,
+        "GET /api/metrics failed");
+  std::string body(response.body, response.bodyLength);
+
+  // Walk the chunks: lowercase hex sizes with no leading zeros
+  size_t at = 0;
+  int chunks = 0;
+  std::string text;
+  for (;;) {
+    size_t end = body.find("\r\n", at);
+    if (end == std::string::npos) {
+      CHECK(false, "chunk %d has no size line", chunks);
+      return;
+    }
+    std::string sizeLine = body.substr(at, end - at);
+    CHECK(!sizeLine.empty() && sizeLine.find_first_not_of("0123456789abcdef") == std::string::npos &&
+          (sizeLine == "0" || sizeLine[0] != '0'), "chunk %d size line \"%s\"", chunks, sizeLine.c_str());
+    size_t size = strtoul(sizeLine.c_str(), nullptr, 16);
+    if (size == 0) {
+      break;
+    }
+    text += body.substr(end + 2, size);
+    at = end + 2 + size + 2;
+    chunks++;
+  }
+  CHECK(text.find("{}") == std::string::npos, "empty label braces in the metrics");
+  CHECK(text.find("led_loop_duration_seconds_sum ") != std::string::npos, "no unlabelled _sum line");
+  CHECK(text.find("led_http_request_duration_seconds_count{route=") != std::string::npos, "no labelled _count line");
+  printf("metrics: %d chunks, %zu bytes of text\n", chunks, text.size());
+}
+
+int main() {
+  startSketch();
+  checkRequestsWaitForABuffer();
+  checkLongPolls();
+  checkMetrics();
+  return failures() != 0;
+}
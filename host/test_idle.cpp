@@ -0,0 +1,112 @@
+// loop() and the engine sleeping between deadlines, on the real clock with
+// real sockets. Left alone, loop() may wake only for its own periodic work
+// (the fleet beacon), spends nearly all its time waiting, and the engine
+// doesn't wake at all. A long-poll must time out when its wait runs out,
+// by a deadline wake rather than polling. A blinking channel must wake the
+// engine once per edge.
+
+#include "sim.h"
+
+const int IDLE_MS = 3000;
+const double MAX_IDLE_WAKEUPS_PER_SECOND = 3;
+const int LONGPOLL_WAIT_MS = 300;
+const int LONGPOLL_SLACK_MS = 25;
+const int BLINK_INTERVAL_MS = 100;
+const int BLINK_MS = 1000;
+
+static uint32_t loopWakeupCount(WakeReason reason) {
+  return __atomic_load_n(&loopWakeups[reason], __ATOMIC_RELAXED);
+}
+
+static uint32_t loopWakeupTotal() {
+  uint32_t total = 0;
+  for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+    total += loopWakeupCount((WakeReason)r);
+  }
+  return total;
+}
+
+static uint32_t engineWakeupCount() {
+  return __atomic_load_n(&engineWakeups, __ATOMIC_RELAXED);
+}
+
+static void checkIdle() {
+  uint32_t loopBefore = loopWakeupTotal();
+  uint32_t engineBefore = engineWakeupCount();
+  uint64_t idleBefore = __atomic_load_n(&loopIdleUs, __ATOMIC_RELAXED);
+  int64_t start = hostNanos();
+  std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+  double seconds = (hostNanos() - start) / 1e9;
+  double loopRate = (loopWakeupTotal() - loopBefore) / seconds;
+  uint32_t engine = engineWakeupCount() - engineBefore;
+  double idleShare = (__atomic_load_n(&loopIdleUs, __ATOMIC_RELAXED) - idleBefore) / 1e6 / seconds;
+
+  CHECK(loopRate <= MAX_IDLE_WAKEUPS_PER_SECOND, "idle loop() woke %.2f times a second", loopRate);
+  CHECK(engine == 0, "idle engine woke %u times", engine);
+  CHECK(idleShare > 0.95, "idle loop() waited %.1f%% of the time", idleShare * 100);
+  printf("idle %.1f s: loop() %.2f wakeups/s, waiting %.1f%% of the time, engine %u wakeups\n", seconds, loopRate,
+         idleShare * 100, engine);
+}
+
+static void checkLongPollDeadline(SimClient& client) {
+  SimResponse response;
+  CHECK(client.request("GET", "/api/status", nullptr, response) && response.status == 200, "GET /api/status");
+  const char* version = strstr(response.body, "\"version\":");
+  CHECK(version != nullptr, "no version in /api/status");
+  if (version == nullptr) {
+    return;
+  }
+  char path[64];
+  snprintf(path, sizeof(path), "/api/status?since=%lu&wait=%d", strtoul(version + 10, nullptr, 10),
+           LONGPOLL_WAIT_MS);
+
+  uint32_t deadlineBefore = loopWakeupCount(WAKE_DEADLINE);
+  uint32_t loopBefore = loopWakeupTotal();
+  int64_t start = hostNanos();
+  bool answered = client.request("GET", path, nullptr, response);
+  double waitedMs = (hostNanos() - start) / 1e6;
+  uint32_t deadline = loopWakeupCount(WAKE_DEADLINE) - deadlineBefore;
+  uint32_t loop = loopWakeupTotal() - loopBefore;
+
+  CHECK(answered && response.status == 304, "long-poll with no change: status %d", response.status);
+  CHECK(waitedMs >= LONGPOLL_WAIT_MS && waitedMs < LONGPOLL_WAIT_MS + LONGPOLL_SLACK_MS,
+        "long-poll for %d ms answered after %.1f ms", LONGPOLL_WAIT_MS, waitedMs);
+  CHECK(deadline >= 1, "long-poll answered without a deadline wake");
+  // The request, the deadline, and perhaps a fleet beacon
+  CHECK(loop <= 4, "loop() woke %u times during a %d ms long-poll", loop, LONGPOLL_WAIT_MS);
+  printf("long-poll %d ms: answered after %.1f ms, loop() woke %u times (%u on a deadline)\n", LONGPOLL_WAIT_MS,
+         waitedMs, loop, deadline);
+}
+
+static void checkBlinkWakeups(SimClient& client) {
+  SimResponse response;
+  char body[64];
+  snprintf(body, sizeof(body), "{\"led\":0,\"action\":\"blink\",\"value\":%d}", BLINK_INTERVAL_MS);
+  CHECK(client.request("POST", "/api/led", body, response) && response.status == 200, "blink: status %d",
+        response.status);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(BLINK_INTERVAL_MS));
+  uint32_t engineBefore = engineWakeupCount();
+  std::this_thread::sleep_for(std::chrono::milliseconds(BLINK_MS));
+  int engine = engineWakeupCount() - engineBefore;
+  int edges = BLINK_MS / BLINK_INTERVAL_MS;
+  CHECK(engine >= edges - 1 && engine <= edges + 1, "engine woke %d times over %d blink edges", engine, edges);
+  printf("blink every %d ms: engine woke %d times in %d ms\n", BLINK_INTERVAL_MS, engine, BLINK_MS);
+
+  client.request("POST", "/api/led", "{\"led\":0,\"action\":\"off\"}", response);
+}
+
+int main() {
+  startSketch();
+  // Past the fleet's join time, after which the node only beacons
+  std::this_thread::sleep_for(std::chrono::milliseconds(FLEET_JOIN_MS + 500));
+
+  checkIdle();
+  SimClient client;
+  CHECK(client.connect(), "cannot connect to the web server");
+  if (failures() == 0) {
+    checkLongPollDeadline(client);
+    checkBlinkWakeups(client);
+  }
+  return failures() != 0;
+}
@@ -0,0 +1,62 @@
+// LEDC output setup and the latch wait, built for all 16 channels so both
+// groups are used. After setup() every channel must run off LEDC_TIMER of
+// its group, and no other timer may have been configured. Then a flush is
+// made with the group 0 counter stuck inside the latch guard window, as a
+// stopped timer would leave it: it must give up waiting after the guard
+// time and still write every channel.
+
+#include "sim.h"
+
+static void checkTimers() {
+  for (int i = 0; i < NUM_LEDS; i++) {
+    uint32_t timer = LEDC.channel_group[ledcGroup(i)].channel[ledcChannel(i)].conf0 & 3;
+    CHECK(timer == LEDC_TIMER, "channel %d runs off timer %u of group %d", i, timer, ledcGroup(i));
+  }
+  for (int g = 0; g < LEDC_GROUPS; g++) {
+    for (int t = 0; t < LEDC_TIMER_MAX; t++) {
+      uint32_t conf = LEDC.timer_group[g].timer[t].conf;
+      if (t == LEDC_TIMER) {
+        CHECK((conf & 0x1f) == PWM_RESOLUTION, "group %d timer %d: %u-bit, not %d", g, t, conf & 0x1f,
+              PWM_RESOLUTION);
+      } else {
+        CHECK(conf == 0, "group %d timer %d configured but unused", g, t);
+      }
+    }
+  }
+  printf("timers: %d channels on timer %d of %d groups, no other timer configured\n", NUM_LEDS, LEDC_TIMER,
+         LEDC_GROUPS);
+}
+
+static void checkStoppedTimer() {
+  LEDC.timer_group[0].timer[LEDC_TIMER].value.timer_cnt = PWM_MAX_DUTY - 1;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    setOutputDuty(i, 100 + i);
+  }
+  int64_t start = hostNanos();
+  flushOutputs();
+  double waitedUs = (hostNanos() - start) / 1000.0;
+  LEDC.timer_group[0].timer[LEDC_TIMER].value.timer_cnt = 0;
+
+  // The guard time plus the clock's own granularity, with room for a busy
+  // host to deschedule the thread
+  CHECK(waitedUs < 1000, "flush with a stopped timer took %.0f us", waitedUs);
+  CHECK(waitedUs >= LEDC_LATCH_GUARD_US, "flush with a stopped timer waited %.1f us, the guard is %u us", waitedUs,
+        LEDC_LATCH_GUARD_US);
+  for (int i = 0; i < NUM_LEDS; i++) {
+    uint32_t duty = LEDC.channel_group[ledcGroup(i)].channel[ledcChannel(i)].duty >> 4;
+    CHECK(duty == (uint32_t)(100 + i), "channel %d: duty %u after the flush, not %d", i, duty, 100 + i);
+  }
+  printf("stopped timer: flush gave up waiting after %.1f us and wrote all %d channels\n", waitedUs, NUM_LEDS);
+}
+
+int main() {
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::holdTasks();
+  setup();
+  host::enterTask(engineTaskHandle);
+
+  checkTimers();
+  checkStoppedTimer();
+  return failures() != 0;
+}
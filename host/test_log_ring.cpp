@@ -0,0 +1,140 @@
+// The log ring, with malloc wrapped. logEvent() is called from the engine
+// and from loop(), so it must never allocate or block, even when the log
+// task has fallen behind and the ring is full: the record is dropped and
+// counted instead. Two producer threads then log flat out against a
+// consumer thread standing in for the log task. Every record must come out
+// whole and in its producer's order, and the ones missing must be exactly
+// the ones counted as dropped.
+
+#include "sim.h"
+
+const uint32_t RECORDS_PER_PRODUCER = 100000;
+
+static void drainRing() {
+  LogRecord record;
+  while (popLogRecord(record)) {
+  }
+}
+
+static void checkFullRing() {
+  drainRing();
+  uint32_t droppedBefore = logDropped.load();
+  const uint32_t calls = 4 * LOG_RING_SIZE;
+
+  uint64_t allocations = 0;
+  uint64_t blockingCalls = 0;
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < calls; i++) {
+      if (i % 2 == 0) {
+        logEvent(LOG_LEVEL_WARN, LOG_CLIENT_THROTTLED, i, 2, 3, 4);
+      } else {
+        logEvent(LOG_LEVEL_INFO, LOG_SCENE_SAVED, "a scene name longer than the record holds");
+      }
+    }
+    allocations = host::allocations();
+    blockingCalls = host::blockingCalls();
+  });
+  producer.join();
+
+  uint32_t dropped = logDropped.load() - droppedBefore;
+  CHECK(allocations == 0, "%llu allocations logging into a full ring", (unsigned long long)allocations);
+  CHECK(blockingCalls == 0, "%llu blocking calls logging into a full ring", (unsigned long long)blockingCalls);
+  CHECK(dropped == calls - LOG_RING_SIZE, "%u of %u records dropped, the ring holds %d", dropped, calls,
+        LOG_RING_SIZE);
+
+  LogRecord record;
+  uint32_t kept = 0;
+  while (popLogRecord(record)) {
+    if (record.event == LOG_SCENE_SAVED) {
+      CHECK(strlen(record.text) == LOG_TEXT_SIZE - 1, "text record not cut to %zu characters", LOG_TEXT_SIZE - 1);
+    }
+    kept++;
+  }
+  CHECK(kept == (uint32_t)LOG_RING_SIZE, "%u records in a full ring of %d", kept, LOG_RING_SIZE);
+  printf("full ring: %u calls, %u kept, %u dropped, no allocation or blocking call\n", calls, kept, dropped);
+}
+
+static void checkProducers() {
+  drainRing();
+  uint32_t droppedBefore = logDropped.load();
+
+  std::atomic<int> running(2);
+  uint64_t allocations[2] = {};
+  uint64_t blockingCalls[2] = {};
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 2; p++) {
+    producers.emplace_back([&, p] {
+      for (uint32_t i = 0; i < RECORDS_PER_PRODUCER; i++) {
+        logEvent(LOG_LEVEL_INFO, LOG_CLIENT_THROTTLED, p, i, ~i, i * 7);
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+      }
+      allocations[p] = host::allocations();
+      blockingCalls[p] = host::blockingCalls();
+      running--;
+    });
+  }
+
+  // The log task's side: take records as they come and format them
+  uint32_t received[2] = {};
+  int64_t last[2] = {-1, -1};
+  uint32_t corrupt = 0;
+  uint32_t outOfOrder = 0;
+  uint64_t formatAllocations = host::allocations();
+  char line[LOG_LINE_SIZE];
+  for (;;) {
+    bool done = running.load() == 0;
+    LogRecord record;
+    if (!popLogRecord(record)) {
+      if (done) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    int p = record.numbers[0];
+    uint32_t i = record.numbers[1];
+    if (record.event != LOG_CLIENT_THROTTLED || p < 0 || p > 1 || (uint32_t)record.numbers[2] != ~i ||
+        (uint32_t)record.numbers[3] != i * 7) {
+      corrupt++;
+      continue;
+    }
+    if ((int64_t)i <= last[p]) {
+      outOfOrder++;
+    }
+    last[p] = i;
+    received[p]++;
+    formatLogRecord(line, sizeof(line), record);
+  }
+  formatAllocations = host::allocations() - formatAllocations;
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+
+  uint32_t dropped = logDropped.load() - droppedBefore;
+  uint32_t total = received[0] + received[1];
+  for (int p = 0; p < 2; p++) {
+    CHECK(allocations[p] == 0, "producer %d allocated %llu times", p, (unsigned long long)allocations[p]);
+    CHECK(blockingCalls[p] == 0, "producer %d made %llu blocking calls", p, (unsigned long long)blockingCalls[p]);
+  }
+  CHECK(corrupt == 0, "%u records came out corrupted", corrupt);
+  CHECK(outOfOrder == 0, "%u records came out of their producer's order", outOfOrder);
+  CHECK(total + dropped == 2 * RECORDS_PER_PRODUCER, "%u received + %u dropped of %u logged", total, dropped,
+        2 * RECORDS_PER_PRODUCER);
+  CHECK(formatAllocations == 0, "formatting allocated %llu times", (unsigned long long)formatAllocations);
+  printf("two producers: %u records logged, %u received in order, %u dropped and counted\n",
+         2 * RECORDS_PER_PRODUCER, total, dropped);
+}
+
+int main() {
+  // The log task stays parked; this thread and the ones above stand in for it
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::holdTasks();
+  setup();
+
+  checkFullRing();
+  checkProducers();
+  return failures() != 0;
+}
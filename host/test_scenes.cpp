@@ -0,0 +1,163 @@
+// Boot restore and scene recall. NVS is seeded with a saved state and a
+// scene before setup(), as a previous run would have left it. The saved
+// levels must be on the outputs when setup() returns, before the web
+// server is up. Then a scene is
+// recalled while an equal-priority UDP stream sends a frame for half the
+// channels before the engine gets to run. Both must be applied, in order:
+// the stream's channels end at the stream's level, the others crossfade to
+// the scene.
+
+#include "sim.h"
+
+const uint32_t RECALL_FADE_MS = 400;
+
+static uint8_t savedBrightness(int i) {
+  return 30 + 25 * (i % 9);
+}
+
+static bool savedOn(int i) {
+  return i % 3 != 1;
+}
+
+static uint8_t sceneLevel(int i) {
+  return 40 + 20 * (i % 10);
+}
+
+static void seedFlash() {
+  Preferences flash;
+  flash.begin(PERSIST_NAMESPACE);
+  SavedState saved = {};
+  saved.magic = PERSIST_MAGIC;
+  saved.count = NUM_LEDS;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    if (savedOn(i)) {
+      saved.isOn[i / 8] |= 1 << (i % 8);
+    }
+    saved.brightness[i] = savedBrightness(i);
+  }
+  flash.putBytes("state", &saved, sizeof(saved));
+
+  Scene warm = {};
+  strcpy(warm.name, "warm");
+  for (int i = 0; i < NUM_LEDS; i++) {
+    warm.levels[i] = sceneLevel(i);
+  }
+  flash.putBytes("scene3", &warm, sizeof(warm));
+}
+
+static void checkBoot() {
+  for (int i = 0; i < NUM_LEDS; i++) {
+    uint32_t expected = savedOn(i) ? gammaDuty(savedBrightness(i) * 257) : 0;
+    uint32_t duty = LEDC.channel_group[ledcGroup(i)].channel[ledcChannel(i)].duty >> 4;
+    CHECK(duty == expected, "channel %d: duty %u after setup(), saved state gives %u", i, duty, expected);
+  }
+  CHECK(findScene("warm") == 3, "the saved scene wasn't loaded");
+  CHECK(bootRestoreUs > 0, "no restore time recorded");
+}
+
+static bool post(SimClient& client, const char* path, const char* body, int expectStatus) {
+  SimResponse response;
+  if (!client.request("POST", path, body, response) || response.status != expectStatus) {
+    fprintf(stderr, "POST %s %s: %d %.*s\n", path, body, response.status, (int)response.bodyLength, response.body);
+    failures()++;
+    return false;
+  }
+  return true;
+}
+
+static void sendStreamFrame(uint8_t priority, uint16_t sequence, uint16_t first, uint16_t count, uint8_t level) {
+  uint8_t packet[STREAM_HEADER_SIZE + NUM_LEDS];
+  memcpy(packet, "LEDF", 4);
+  packet[4] = STREAM_VERSION;
+  packet[5] = priority;
+  packet[6] = sequence >> 8;
+  packet[7] = sequence;
+  packet[8] = first >> 8;
+  packet[9] = first;
+  packet[10] = count >> 8;
+  packet[11] = count;
+  memset(packet + STREAM_HEADER_SIZE, level, count);
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(host::boundPort(STREAM_PORT));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sendto(fd, packet, STREAM_HEADER_SIZE + count, 0, (sockaddr*)&address, sizeof(address));
+  ::close(fd);
+}
+
+// Until loop() has queued that many commands for the engine
+static bool waitForQueued(uint32_t count) {
+  for (int i = 0; i < 2000 && commandQueueSpace() > COMMAND_QUEUE_SIZE - count; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return commandQueueSpace() == COMMAND_QUEUE_SIZE - count;
+}
+
+static void checkRecallWithStream() {
+  SimClient client;
+  CHECK(client.connect(), "cannot connect to the web server");
+  if (failures() > 0) {
+    return;
+  }
+
+  // Start from everything off
+  post(client, "/api/all", "{\"action\":\"off\"}", 200);
+  CHECK(waitForQueued(1), "the off command didn't reach the queue");
+  runEngine();
+
+  char body[96];
+  snprintf(body, sizeof(body), "{\"action\":\"recall\",\"name\":\"warm\",\"fade\":%u}", RECALL_FADE_MS);
+  post(client, "/api/scenes", body, 200);
+  CHECK(waitForQueued(1), "the recall didn't reach the queue");
+  const int streamed = NUM_LEDS / 2;
+  sendStreamFrame(STREAM_WEB_PRIORITY, 1, 0, streamed, 7);
+  CHECK(waitForQueued(2), "the stream frame didn't reach the queue");
+  client.close();
+
+  int64_t start = hostNanos();
+  runEngine();
+  double engineUs = (hostNanos() - start) / 1000.0;
+
+  uint32_t fadeTicks = RECALL_FADE_MS * 1000 / FADE_TICK_US;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    if (i < streamed) {
+      CHECK(channels.isOn[i] && channels.brightness[i] == 7 && channels.fadeTicks[i] == 0,
+            "channel %d: on %d, brightness %u, fading %u; the stream frame sets 7 at once", i, channels.isOn[i],
+            channels.brightness[i], channels.fadeTicks[i]);
+    } else {
+      CHECK(channels.isOn[i] && channels.brightness[i] == sceneLevel(i) && channels.fadeTicks[i] == fadeTicks,
+            "channel %d: on %d, brightness %u, fading %u ticks; the scene gives %u over %u ticks", i,
+            channels.isOn[i], channels.brightness[i], channels.fadeTicks[i], sceneLevel(i), fadeTicks);
+    }
+  }
+  printf("recall + stream frame: %.1f us in one engine pass, %d channels streamed, %d fading to the scene\n",
+         engineUs, streamed, NUM_LEDS - streamed);
+}
+
+int main() {
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::holdTasks();
+  seedFlash();
+
+  setup();
+  checkBoot();
+  int64_t restoreUs = bootRestoreUs;
+
+  // The engine runs on this thread, when the test says
+  host::enterTask(engineTaskHandle);
+  runLoop();
+  for (int i = 0; i < 2000 && __atomic_load_n(&httpReadyUs, __ATOMIC_ACQUIRE) == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  int64_t readyUs = __atomic_load_n(&httpReadyUs, __ATOMIC_ACQUIRE);
+  CHECK(readyUs > restoreUs, "web server ready at %lld us, outputs restored at %lld us", (long long)readyUs,
+        (long long)restoreUs);
+  printf("boot: saved state on the outputs at %lld us, web server ready at %lld us\n", (long long)restoreUs,
+         (long long)readyUs);
+
+  checkRecallWithStream();
+  return failures() != 0;
+}
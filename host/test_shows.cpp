@@ -0,0 +1,201 @@
+// Show upload and playback, with the engine run by the test. An upload left
+// unfinished must lose its file when the next one is created, and a cue
+// with a count but no first channel, or a range past the last channel
+// however large its count, must be turned away. Pausing a fade
+// must hold the output where the fade got to, without making that level
+// the channel's brightness. A seek far into a long show must be replayed
+// over many loop() passes and still land on the right look. Show uploads
+// count against the client's command rate like any other command.
+
+#include "sim.h"
+
+const uint32_t SHOW_FADE_MS = 10000;
+const uint8_t SHOW_FADE_LEVEL = 200;
+const uint32_t LONG_SHOW_KEYFRAMES = 5000;
+const uint32_t LONG_SHOW_SPACING_MS = 10;
+
+static std::atomic<uint32_t> loopPasses(0);
+
+static void countedLoop() {
+  loop();
+  loopPasses++;
+}
+
+static bool post(SimClient& client, const char* path, const char* body, int expectStatus,
+                 SimResponse* reply = nullptr) {
+  SimResponse response;
+  if (!client.request("POST", path, body, response) || response.status != expectStatus) {
+    fprintf(stderr, "POST %s %s: %d %.*s\n", path, body, response.status, (int)response.bodyLength, response.body);
+    failures()++;
+    return false;
+  }
+  if (reply != nullptr) {
+    *reply = response;
+  }
+  return true;
+}
+
+static bool fsHas(const char* path) {
+  char hostPath[256];
+  snprintf(hostPath, sizeof(hostPath), "%s%s", host::fsRoot(), path);
+  return access(hostPath, F_OK) == 0;
+}
+
+// Until loop() has queued that many commands for the engine
+static bool waitForQueued(uint32_t count) {
+  for (int i = 0; i < 2000 && commandQueueSpace() > COMMAND_QUEUE_SIZE - count; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return commandQueueSpace() == COMMAND_QUEUE_SIZE - count;
+}
+
+static void checkUpload(SimClient& client) {
+  post(client, "/api/shows", "{\"action\":\"create\",\"name\":\"first\"}", 200);
+  post(client, "/api/shows", "{\"action\":\"append\",\"cues\":[{\"t\":0,\"level\":9}]}", 200);
+  CHECK(fsHas("/shows/first.tmp"), "no upload file for the first show");
+  post(client, "/api/shows", "{\"action\":\"create\",\"name\":\"second\"}", 200);
+  CHECK(!fsHas("/shows/first.tmp"), "the unfinished upload's file was left behind");
+
+  SimResponse response;
+  post(client, "/api/shows", "{\"action\":\"append\",\"cues\":[{\"t\":0,\"count\":2,\"level\":9}]}", 400, &response);
+  CHECK(strstr(response.body, "Count without first") != nullptr, "count without first: %.*s",
+        (int)response.bodyLength, response.body);
+  post(client, "/api/shows",
+       "{\"action\":\"append\",\"cues\":[{\"t\":0,\"first\":1,\"count\":2147483647,\"level\":9}]}", 400, &response);
+  CHECK(strstr(response.body, "Invalid range") != nullptr, "count that overflows the range: %.*s",
+        (int)response.bodyLength, response.body);
+  post(client, "/api/shows", "{\"action\":\"finish\"}", 200);
+  printf("upload: unfinished upload removed on create, count without first and overflowing range rejected\n");
+}
+
+static void checkPause(SimClient& client) {
+  char body[160];
+  post(client, "/api/shows", "{\"action\":\"create\",\"name\":\"fade\"}", 200);
+  snprintf(body, sizeof(body), "{\"action\":\"append\",\"cues\":[{\"t\":0,\"level\":%u,\"fade\":%u}]}",
+           SHOW_FADE_LEVEL, SHOW_FADE_MS);
+  post(client, "/api/shows", body, 200);
+  post(client, "/api/shows", "{\"action\":\"finish\",\"duration\":20000}", 200);
+
+  post(client, "/api/playback", "{\"action\":\"play\",\"name\":\"fade\"}", 200);
+  CHECK(waitForQueued(2), "play didn't stop and start the engine's show");
+  for (int i = 0; i < 20; i++) {
+    runEngine();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  post(client, "/api/playback", "{\"action\":\"pause\"}", 200);
+  CHECK(waitForQueued(1), "pause didn't reach the queue");
+  runEngine();
+
+  uint32_t target = (uint32_t)SHOW_FADE_LEVEL * 257 << 16;
+  uint32_t level = channels.level[0];
+  uint32_t duty = outputDuty[0];
+  CHECK(level > 0 && level < target, "channel 0 at level %08x after the pause, the fade goes to %08x", level, target);
+  CHECK(level % (257 << 16) != 0, "held level %08x was rounded to 8 bits", level);
+  for (int i = 0; i < NUM_LEDS; i++) {
+    CHECK(channels.fadeTicks[i] == 0, "channel %d still fading after the pause", i);
+    CHECK(channels.isOn[i] && channels.brightness[i] == SHOW_FADE_LEVEL,
+          "channel %d: on %d, brightness %u after the pause; the paused level isn't a setting", i,
+          channels.isOn[i], channels.brightness[i]);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  runEngine();
+  CHECK(channels.level[0] == level && outputDuty[0] == duty, "held output moved while paused");
+  printf("pause: fade held at level %.2f of %u, brightness still %u\n", level / 65536.0 / 257, SHOW_FADE_LEVEL,
+         channels.brightness[0]);
+
+  post(client, "/api/playback", "{\"action\":\"stop\"}", 200);
+  CHECK(waitForQueued(1), "stop didn't reach the queue");
+  runEngine();
+}
+
+static uint8_t longShowLevel(uint32_t k) {
+  return (k * 7) % 256;
+}
+
+// Written straight to the flash: one channel per keyframe, in turn
+static void writeLongShow() {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/shows/long.show", host::fsRoot());
+  FILE* file = fopen(path, "wb");
+  ShowHeader header = {SHOW_MAGIC, NUM_LEDS, 0, LONG_SHOW_KEYFRAMES, LONG_SHOW_KEYFRAMES * LONG_SHOW_SPACING_MS};
+  fwrite(&header, sizeof(header), 1, file);
+  for (uint32_t k = 0; k < LONG_SHOW_KEYFRAMES; k++) {
+    ShowKeyframe keyframe = {};
+    keyframe.timeMs = k * LONG_SHOW_SPACING_MS;
+    keyframe.first = k % NUM_LEDS;
+    keyframe.count = 1;
+    keyframe.level = longShowLevel(k);
+    fwrite(&keyframe, sizeof(keyframe), 1, file);
+  }
+  fclose(file);
+}
+
+static void checkLongSeek(SimClient& client) {
+  writeLongShow();
+  // Between keyframes, so the next isn't due by the time the engine runs
+  const uint32_t lastBefore = LONG_SHOW_KEYFRAMES - 10;
+  const uint32_t at = lastBefore * LONG_SHOW_SPACING_MS + LONG_SHOW_SPACING_MS / 2;
+  char body[96];
+  snprintf(body, sizeof(body), "{\"action\":\"play\",\"name\":\"long\",\"at\":%u}", at);
+  uint32_t passesBefore = loopPasses.load();
+  SimResponse response;
+  post(client, "/api/playback", body, 200, &response);
+  CHECK(strstr(response.body, "\"state\":\"seeking\"") != nullptr, "play far into a long show: %.*s",
+        (int)response.bodyLength, response.body);
+
+  for (int i = 0; i < 2000 && playbackState != PLAYBACK_PLAYING; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  uint32_t passes = loopPasses.load() - passesBefore;
+  uint32_t minPasses = lastBefore / SHOW_REPLAY_STEP;
+  CHECK(playbackState == PLAYBACK_PLAYING, "replay never finished");
+  CHECK(passes >= minPasses, "replay of %u keyframes took %u loop() passes, at most %d a pass allows %u", lastBefore,
+        passes, SHOW_REPLAY_STEP, minPasses);
+
+  CHECK(waitForQueued(2), "the seek didn't stop and start the engine's show");
+  for (int i = 0; i < 2000 && !showBlocks[0].full.load(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  runEngine();
+  for (int i = 0; i < NUM_LEDS; i++) {
+    uint32_t last = lastBefore - ((lastBefore - i) % NUM_LEDS);
+    uint8_t expected = longShowLevel(last);
+    bool right = expected == 0 ? !channels.isOn[i] : channels.isOn[i] && channels.brightness[i] == expected;
+    CHECK(right, "channel %d: on %d, brightness %u at %u ms; the show has %u", i, channels.isOn[i],
+          channels.brightness[i], at, expected);
+  }
+  printf("seek to %u ms: %u keyframes replayed over %u loop() passes\n", at, lastBefore + 1, passes);
+
+  post(client, "/api/playback", "{\"action\":\"stop\"}", 200);
+}
+
+static void checkAdmission(SimClient& client) {
+  SimResponse response;
+  int limited = 0;
+  for (uint32_t i = 0; i < 2 * CLIENT_COMMAND_BURST && limited == 0; i++) {
+    client.request("POST", "/api/shows", "{\"action\":\"none\"}", response);
+    limited = response.status == 429;
+  }
+  CHECK(limited, "no 429 after %u show requests", 2 * CLIENT_COMMAND_BURST);
+  printf("admission: show requests are rate limited\n");
+}
+
+int main() {
+  useTempFsRoot();
+  host::useEphemeralPorts();
+  host::holdTasks();
+  setup();
+  host::enterTask(engineTaskHandle);
+  runLoop(countedLoop);
+
+  SimClient client;
+  CHECK(client.connect(), "cannot connect to the web server");
+  if (failures() > 0) {
+    return 1;
+  }
+  checkUpload(client);
+  checkPause(client);
+  checkLongSeek(client);
+  checkAdmission(client);
+  return failures() != 0;
+}
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Build the dashboard blob served by handleRoot().
+
+Reads data/index.html, minifies it, gzips it and writes dashboard_html.h
+next to the sketch as a const byte array that lives in flash, together with
+its length and a strong ETag.
+
+The source page is written one fragment per line: leading/trailing
+whitespace and line breaks are not significant and are dropped, as are
+full-line comments (<!-- -->, /* */ and //). Keep that in mind when editing
+data/index.html -- anything that needs a space must carry it inside the line.
+
+Usage:
+  python3 tools/build_dashboard.py          regenerate dashboard_html.h
+  python3 tools/build_dashboard.py --check  verify dashboard_html.h matches data/index.html
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "data", "index.html")
+HEADER = os.path.join(ROOT, "dashboard_html.h")
+
+COMMENT_LINE = re.compile(r"^(<!--.*-->|/\*.*\*/|//.*)$")
+
+
+def minify(text):
+    parts = []
+    for line in text.splitlines():
+        line = line.strip()
+        if not line or COMMENT_LINE.match(line):
+            continue
+        parts.append(line)
+    return "".join(parts).encode("utf-8")
+
+
+def compress(html):
+    # mtime=0 keeps the output (and therefore the ETag) reproducible
+    return gzip.compress(html, compresslevel=9, mtime=0)
+
+
+def etag_for(blob):
+    return '"' + hashlib.sha256(blob).hexdigest()[:16] + '"'
+
+
+def render_header(html, blob):
+    rows = []
+    for i in range(0, len(blob), 16):
+        rows.append("  " + ",".join("0x%02x" % b for b in blob[i:i + 16]) + ",")
+    return (
+        "// Generated by tools/build_dashboard.py from data/index.html - do not edit.\n"
+        "#pragma once\n"
+        "\n"
+        "#include <Arduino.h>\n"
+        "\n"
+        "// Minified page: %d bytes, gzip: %d bytes\n"
+        "#define DASHBOARD_ETAG \"%s\"\n"
+        "\n"
+        "const size_t DASHBOARD_HTML_GZ_LEN = %d;\n"
+        "\n"
+        "const uint8_t DASHBOARD_HTML_GZ[] PROGMEM = {\n"
+        "%s\n"
+        "};\n"
+    ) % (len(html), len(blob), etag_for(blob).replace('"', '\\"'), len(blob), "\n".join(rows))
+
+
+def read_header_blob(path):
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    body = text.split("DASHBOARD_HTML_GZ[] PROGMEM = {", 1)[1].split("};", 1)[0]
+    return bytes(int(b, 16) for b in re.findall(r"0x([0-9a-f]{2})", body))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--check", action="store_true",
+                        help="fail if dashboard_html.h is stale")
+    args = parser.parse_args()
+
+    with open(SOURCE, encoding="utf-8") as f:
+        html = minify(f.read())
+
+    if args.check:
+        if not os.path.exists(HEADER):
+            print("dashboard_html.h is missing", file=sys.stderr)
+            return 1
+        embedded = gzip.decompress(read_header_blob(HEADER))
+        if embedded != html:
+            print("dashboard_html.h is out of date, rerun tools/build_dashboard.py",
+                  file=sys.stderr)
+            return 1
+        print("dashboard_html.h matches data/index.html (%d bytes)" % len(html))
+        return 0
+
+    blob = compress(html)
+    with open(HEADER, "w", encoding="utf-8", newline="\n") as f:
+        f.write(render_header(html, blob))
+    print("wrote %s: %d -> %d bytes, ETag %s"
+          % (os.path.relpath(HEADER, ROOT), len(html), len(blob), etag_for(blob)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,175 @@
+#!/usr/bin/env node
+/*
+ * Count the DOM writes the dashboard makes for a status update.
+ *
+ * Runs the script from data/index.html against a stub DOM that counts every
+ * write (text, markup, classes, attributes, inline style, inserted and
+ * removed nodes), with a 512-channel snapshot on a 3-column grid, and checks
+ * that once the grid is built:
+ *
+ *   - a snapshot with the version already on screen writes nothing, and
+ *     neither does redrawing unchanged state with updateUI()
+ *   - a snapshot with one channel switched on writes 3 times
+ *   - scrolling one row down writes at most 6 times per column plus the
+ *     grid's two paddings, however many channels there are
+ *
+ * Usage:
+ *   node tools/dom_mutations.js
+ *
+ * Exits non-zero if a check fails.
+ */
+
+'use strict';
+
+const fs = require('fs');
+const path = require('path');
+const vm = require('vm');
+
+const SOURCE = path.join(__dirname, '..', 'data', 'index.html');
+const CHANNELS = 512;
+const COLUMNS = 3;
+const CARD_HEIGHT = 100;
+const ROW_GAP = 10;
+const ROW_HEIGHT = CARD_HEIGHT + ROW_GAP;
+const VIEWPORT_HEIGHT = 800;
+
+let writes = 0;
+
+// Style and dataset: every property set is a write
+function countingBag() {
+  return new Proxy({}, {
+    set(target, key, value) {
+      writes++;
+      target[key] = value;
+      return true;
+    },
+    get(target, key) {
+      return key in target ? target[key] : '';
+    },
+  });
+}
+
+class StubElement {
+  constructor(tag) {
+    this.tag = tag;
+    this.children = [];
+    this.style = countingBag();
+    this.dataset = countingBag();
+    this.classes = new Set();
+    this.found = new Map();
+    this.text = '';
+    this.markup = '';
+    this.classList = {
+      toggle: (name, force) => {
+        writes++;
+        const on = force === undefined ? !this.classes.has(name) : force;
+        if (on) this.classes.add(name); else this.classes.delete(name);
+        return on;
+      },
+    };
+  }
+  set textContent(value) { writes++; this.text = String(value); this.children = []; }
+  get textContent() { return this.text; }
+  set innerHTML(value) { writes++; this.markup = String(value); this.found.clear(); }
+  get innerHTML() { return this.markup; }
+  set className(value) { writes++; this.classes = new Set(String(value).split(/\s+/).filter(Boolean)); }
+  get className() { return [...this.classes].join(' '); }
+  get offsetHeight() { return CARD_HEIGHT; }
+  appendChild(child) { writes++; this.children.push(child); return child; }
+  removeChild(child) { writes++; this.children.splice(this.children.indexOf(child), 1); return child; }
+  querySelector(selector) {
+    if (!this.found.has(selector)) this.found.set(selector, new StubElement('div'));
+    return this.found.get(selector);
+  }
+  addEventListener() {}
+}
+
+const grid = new StubElement('div');
+grid.getBoundingClientRect = () => ({top: -window.scrollY});
+const elements = {ledGrid: grid, statusIcon: new StubElement('div'), statusText: new StubElement('div')};
+
+const document = {
+  hidden: false,
+  getElementById: id => elements[id],
+  createElement: tag => new StubElement(tag),
+  querySelectorAll: () => [],
+  addEventListener() {},
+};
+const window = {scrollY: 0, innerHeight: VIEWPORT_HEIGHT, addEventListener() {}};
+
+const context = vm.createContext({
+  document,
+  window,
+  console,
+  Map,
+  Math,
+  JSON,
+  parseInt,
+  parseFloat,
+  getComputedStyle: () => ({gridTemplateColumns: Array(COLUMNS).fill('1fr').join(' '), rowGap: ROW_GAP + 'px'}),
+  requestAnimationFrame: callback => callback(),
+  setTimeout() {},
+  setInterval() {},
+  fetch: () => new Promise(() => {}),
+});
+
+const html = fs.readFileSync(SOURCE, 'utf8');
+const script = html.match(/<script>([\s\S]*)<\/script>/)[1];
+// The page's functions live in the script's own scope; its last expression
+// hands them back
+const page = vm.runInContext(script + '\n;({applySnapshot,updateUI,onScroll,cards});', context);
+
+// A compact status snapshot (see decodeCompact) with the given channels on
+function snapshot(version, on) {
+  let mask = '';
+  for (let digit = 0; digit < CHANNELS / 4; digit++) {
+    let bits = 0;
+    for (let bit = 0; bit < 4; bit++) {
+      if (on.includes(digit * 4 + bit)) bits |= 1 << bit;
+    }
+    mask += bits.toString(16);
+  }
+  return {version, count: CHANNELS, on: mask, brightness: 'ff'.repeat(CHANNELS), effect: '0'.repeat(CHANNELS)};
+}
+
+function measure(action) {
+  writes = 0;
+  action();
+  return writes;
+}
+
+let failed = false;
+function check(label, count, ok, expected, unit = 'writes') {
+  console.log(`  ${label.padEnd(40)} ${String(count).padStart(5)} ${unit}`);
+  if (!ok) {
+    console.error(`${label}: ${count} ${unit}, expected ${expected}`);
+    failed = true;
+  }
+}
+
+console.log(`DOM writes, ${CHANNELS} channels on ${COLUMNS} columns`);
+check('first snapshot (builds the grid)', measure(() => page.applySnapshot(snapshot(1, []))), true);
+
+window.scrollY = 20 * ROW_HEIGHT;
+check('scroll to row 20', measure(() => page.onScroll()), true);
+
+let count = measure(() => page.applySnapshot(snapshot(1, [])));
+check('same version again', count, count === 0, 0);
+count = measure(() => page.updateUI());
+check('updateUI() with nothing changed', count, count === 0, 0);
+
+// A channel on screen, so its card is the one patched
+const shown = [...page.cards.keys()][0];
+count = measure(() => page.applySnapshot(snapshot(2, [shown])));
+check(`channel ${shown + 1} switched on`, count, count === 3, 3);
+
+window.scrollY += ROW_HEIGHT;
+const scrollBound = COLUMNS * 6 + 2;
+count = measure(() => page.onScroll());
+check('scroll one row down', count, count > 0 && count <= scrollBound, `1 to ${scrollBound}`);
+
+const maxCards = (Math.ceil(VIEWPORT_HEIGHT / ROW_HEIGHT) + 4) * COLUMNS;
+count = grid.children.length;
+check('cards in the grid', count, count <= maxCards, `at most ${maxCards}`, 'cards');
+
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Measure how closely a fleet of controllers commits a group command.
+
+Sends /api/all with a group to the first node, waits for the command to
+run, then reads /api/fleet from every node. Each node reports when it ran
+the command on the fleet clock; the spread of those times is the skew.
+Each node's clock can be off by up to half its sync round trip, which is
+reported alongside. Nodes are given as host or host:port.
+
+Usage:
+  python3 tools/fleet_skew.py 192.168.1.50 192.168.1.51 192.168.1.52
+  python3 tools/fleet_skew.py 192.168.1.50 192.168.1.51 --group lobby --rounds 50
+"""
+
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def request(node, method, path, body=None):
+    host, _, port = node.partition(":")
+    conn = http.client.HTTPConnection(host, int(port or 80), timeout=5)
+    try:
+        headers = {"Content-Type": "application/json"} if body is not None else {}
+        conn.request(method, path, json.dumps(body) if body is not None else None, headers)
+        response = conn.getresponse()
+        return response.status, json.loads(response.read() or b"null")
+    finally:
+        conn.close()
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("nodes", nargs="+", help="controller addresses, the first one takes the requests")
+    parser.add_argument("--group", default="*", help='group to command, "*" for every node')
+    parser.add_argument("--rounds", type=int, default=20)
+    parser.add_argument("--interval", type=float, default=0.5, help="seconds between rounds")
+    args = parser.parse_args()
+
+    status, info = request(args.nodes[0], "GET", "/api/fleet")
+    if status != 200:
+        print(f"{args.nodes[0]}: /api/fleet returned {status}", file=sys.stderr)
+        return 1
+    origin = info["node"]
+
+    skews = []
+    missing = 0
+    for round_number in range(args.rounds):
+        action = "on" if round_number % 2 == 0 else "off"
+        status, sent = request(args.nodes[0], "POST", "/api/all", {"action": action, "group": args.group})
+        if status != 200:
+            print(f"round {round_number}: /api/all returned {status} {sent}", file=sys.stderr)
+            return 1
+        # The command runs about 100 ms after the request
+        time.sleep(0.3)
+
+        ran = []
+        uncertainty = 0
+        for node in args.nodes:
+            _, state = request(node, "GET", "/api/fleet")
+            last = state["lastCommand"]
+            if last is None or last["origin"] != origin or last["id"] != sent["id"]:
+                missing += 1
+                continue
+            ran.append(last["dueUs"] + last["lateUs"])
+            uncertainty = max(uncertainty, state["roundTripUs"] / 2)
+        if len(ran) > 1:
+            skew = max(ran) - min(ran)
+            skews.append(skew)
+            print(f"round {round_number}: {len(ran)} nodes, skew {skew / 1000:.2f} ms "
+                  f"(clock uncertainty up to {uncertainty / 1000:.2f} ms)")
+        time.sleep(args.interval)
+
+    if skews:
+        print("skew ms: p50 %.2f  p90 %.2f  max %.2f" % tuple(
+            percentile(skews, f) / 1000 for f in (0.5, 0.9, 1.0)))
+    print(f"nodes that didn't run a command: {missing}")
+    return 0 if missing == 0 else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
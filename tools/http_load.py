@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Load-test the controller's HTTP server with concurrent keep-alive clients.
+
+Each client holds one persistent HTTP/1.1 connection and sends requests
+back to back for the length of the run: status polls, with a share of
+POST /api/led commands mixed in. Optional slow clients open connections
+and trickle their request a byte at a time, to check that they don't hold
+up everyone else (a request takes them about 2.5 s, inside the server's
+request timeout). Reports throughput, latency percentiles, reconnects,
+errors and status codes; command requests over the per-client rate limit
+come back as 429.
+
+Usage:
+  python3 tools/http_load.py 192.168.1.50
+  python3 tools/http_load.py 192.168.1.50 --clients 6 --seconds 30 --writes 0.2
+  python3 tools/http_load.py 192.168.1.50 --clients 4 --slow 2
+  python3 tools/http_load.py 192.168.1.50 --clients 6 --writes 1 --channels 2
+"""
+
+import argparse
+import http.client
+import json
+import socket
+import sys
+import threading
+import time
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def client(host, port, deadline, writes, channels, index, stats, lock):
+    conn = None
+    latencies = []
+    errors = 0
+    connects = 0
+    codes = {}
+    n = 0
+    credit = 0.0
+
+    while time.monotonic() < deadline:
+        if conn is None:
+            conn = http.client.HTTPConnection(host, port, timeout=10)
+            connects += 1
+        n += 1
+        credit += writes
+        write = credit >= 1
+        if write:
+            credit -= 1
+        try:
+            start = time.monotonic()
+            if write:
+                body = json.dumps({"led": (index + n) % channels, "action": "brightness", "value": n % 256})
+                conn.request("POST", "/api/led", body, {"Content-Type": "application/json"})
+            else:
+                conn.request("GET", "/api/status?format=compact")
+            response = conn.getresponse()
+            response.read()
+            latencies.append(time.monotonic() - start)
+            codes[response.status] = codes.get(response.status, 0) + 1
+            if response.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            errors += 1
+            conn.close()
+            conn = None
+
+    if conn is not None:
+        conn.close()
+    with lock:
+        stats["latencies"].extend(latencies)
+        stats["errors"] += errors
+        stats["connects"] += connects
+        for code, count in codes.items():
+            stats["codes"][code] = stats["codes"].get(code, 0) + count
+
+
+def slow_client(host, port, deadline, stats, lock):
+    request = b"GET /api/status?format=compact HTTP/1.1\r\nHost: x\r\n\r\n"
+    answered = 0
+    while time.monotonic() < deadline:
+        try:
+            sock = socket.create_connection((host, port), timeout=10)
+            for i in range(len(request)):
+                sock.sendall(request[i:i + 1])
+                time.sleep(0.05)
+            answered += sock.recv(16).startswith(b"HTTP/1.1 ")
+            sock.close()
+        except OSError:
+            pass
+    with lock:
+        stats["slow"] += answered
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host", help="controller IP address")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--clients", type=int, default=4, help="concurrent keep-alive clients")
+    parser.add_argument("--slow", type=int, default=0, help="clients trickling their requests")
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--writes", type=float, default=0.1, help="share of requests that are POST /api/led")
+    parser.add_argument("--channels", type=int, default=8)
+    args = parser.parse_args()
+
+    if args.clients < 1 or not 0 <= args.writes <= 1:
+        print("need at least one client and --writes between 0 and 1", file=sys.stderr)
+        return 1
+
+    stats = {"latencies": [], "errors": 0, "connects": 0, "codes": {}, "slow": 0}
+    lock = threading.Lock()
+    deadline = time.monotonic() + args.seconds
+    threads = [threading.Thread(target=client, args=(args.host, args.port, deadline, args.writes,
+                                                     args.channels, i, stats, lock))
+               for i in range(args.clients)]
+    threads += [threading.Thread(target=slow_client, args=(args.host, args.port, deadline, stats, lock))
+                for _ in range(args.slow)]
+    start = time.monotonic()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - start
+
+    latencies = stats["latencies"]
+    print(f"{len(latencies)} requests in {elapsed:.1f} s ({len(latencies) / elapsed:.0f}/s) "
+          f"over {stats['connects']} connections, {stats['errors']} errors")
+    print("latency ms: p50 %.1f  p90 %.1f  p99 %.1f  max %.1f" % tuple(
+        1000 * percentile(latencies, f) for f in (0.5, 0.9, 0.99, 1.0)))
+    print("status codes:", ", ".join(f"{code}: {count}" for code, count in sorted(stats["codes"].items())))
+    if args.slow:
+        print(f"slow clients answered: {stats['slow']}")
+    return 0 if stats["errors"] == 0 else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
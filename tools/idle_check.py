@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Check that an idle controller sleeps, and how fast it answers when woken.
+
+Reads /api/metrics?format=json, leaves the controller alone for a while and
+reads it again: loop() and engine wakeups per second and the share of time
+loop() spent waiting. Then sends single requests a while apart, each on a
+fresh connection so that it finds loop() asleep, and reports the time from
+the wake to the handler finishing. The metric requests themselves add a
+couple of wakeups. Fails if the idle loop wakes more often than --max-wakeups
+per second.
+
+Usage:
+  python3 tools/idle_check.py 192.168.1.50
+  python3 tools/idle_check.py 192.168.1.50 --idle 30 --requests 50 --max-wakeups 5
+"""
+
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def get(host, port, path):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    try:
+        conn.request("GET", path)
+        response = conn.getresponse()
+        return response.status, response.read()
+    finally:
+        conn.close()
+
+
+def metrics(host, port):
+    return json.loads(get(host, port, "/api/metrics?format=json")[1])
+
+
+def bucket_percentile(limits, counts, fraction):
+    total = sum(counts)
+    if total == 0:
+        return 0
+    seen = 0
+    for i, count in enumerate(counts):
+        seen += count
+        if seen >= fraction * total:
+            return limits[i] if i < len(limits) else float("inf")
+    return float("inf")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host", help="controller IP address")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--idle", type=float, default=10.0, help="seconds to leave the controller alone")
+    parser.add_argument("--requests", type=int, default=20)
+    parser.add_argument("--gap", type=float, default=0.25, help="seconds between requests")
+    parser.add_argument("--max-wakeups", type=float, default=10.0, help="idle loop wakeups per second allowed")
+    args = parser.parse_args()
+
+    before = metrics(args.host, args.port)
+    time.sleep(args.idle)
+    after = metrics(args.host, args.port)
+
+    elapsed = (after["uptimeMs"] - before["uptimeMs"]) / 1000
+    wakeups = {reason: (after["wakeups"][reason] - before["wakeups"][reason]) / elapsed
+               for reason in after["wakeups"]}
+    loop_wakeups = sum(rate for reason, rate in wakeups.items() if reason != "engine")
+    idle_share = (after["idleUs"] - before["idleUs"]) / 1e6 / elapsed
+    print(f"idle {elapsed:.1f} s, light sleep {'on' if after['lightSleep'] else 'off'}")
+    print("wakeups/s: loop %.2f (%s), engine %.2f" % (
+        loop_wakeups, ", ".join(f"{reason} {rate:.2f}" for reason, rate in wakeups.items() if reason != "engine"),
+        wakeups["engine"]))
+    print(f"loop() waiting {100 * idle_share:.1f}% of the time")
+
+    for _ in range(args.requests):
+        time.sleep(args.gap)
+        get(args.host, args.port, "/api/status?format=compact")
+    woken = metrics(args.host, args.port)["wake"]
+    counts = [b - a for a, b in zip(after["wake"]["buckets"], woken["buckets"])]
+    answered = woken["count"] - after["wake"]["count"]
+    if answered > 0:
+        mean = (woken["sumUs"] - after["wake"]["sumUs"]) / answered
+        limits = after["bucketLimitsUs"]
+        print("wake to response over %d requests: mean %.0f us, p50 <= %s us, p99 <= %s us, max so far %d us" % (
+            answered, mean, bucket_percentile(limits, counts, 0.5), bucket_percentile(limits, counts, 0.99),
+            woken["maxUs"]))
+    else:
+        print("no request woke loop()")
+
+    if loop_wakeups > args.max_wakeups:
+        print(f"idle loop wakes {loop_wakeups:.2f} times a second, over {args.max_wakeups}", file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
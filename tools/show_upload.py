@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+Upload a cue-list show to the controller, and optionally play it.
+
+The show is a JSON file holding a list of cues, or an object with "cues"
+and an optional "duration" in ms. A cue is
+  {"t": ms from the start, "level": 0-255, "fade": ms,
+   "led": n | "leds": [n, ...] | "first": n, "count": n}
+and is for every channel when it names none. Cues must be in time order.
+They are sent --chunk at a time; the controller compiles them into
+keyframes on its flash as they arrive, and requests it turns away for
+coming too fast are sent again after the wait it asks for. --demo generates a chase across
+--channels channels instead of reading a file.
+
+With --measure, plays the show for that many seconds and reports how late
+the controller applied its keyframes, from /api/metrics?format=json.
+
+Usage:
+  python3 tools/show_upload.py 192.168.1.50 finale finale.json
+  python3 tools/show_upload.py 192.168.1.50 chase --demo 2000 --play --loop
+  python3 tools/show_upload.py 192.168.1.50 chase --demo 2000 --step 20 --measure 30
+"""
+
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def request(host, port, method, path, body=None):
+    # Commands are rate limited per client; a 429 says when to try again
+    while True:
+        conn = http.client.HTTPConnection(host, port, timeout=10)
+        try:
+            headers = {"Content-Type": "application/json"} if body is not None else {}
+            conn.request(method, path, json.dumps(body) if body is not None else None, headers)
+            response = conn.getresponse()
+            reply = json.loads(response.read() or b"null")
+            if response.status != 429:
+                return response.status, reply
+            time.sleep(float(response.getheader("Retry-After") or 1))
+        finally:
+            conn.close()
+
+
+def demo_cues(count, channels, step, fade):
+    # Each step lights the next channel and fades the one before out
+    cues = []
+    for i in range(count):
+        t = i * step
+        cues.append({"t": t, "led": i % channels, "level": 255, "fade": fade})
+        cues.append({"t": t, "led": (i - 1) % channels, "level": 0, "fade": fade})
+    return {"cues": cues, "duration": count * step}
+
+
+def bucket_percentile(limits, counts, fraction):
+    total = sum(counts)
+    if total == 0:
+        return 0
+    seen = 0
+    for i, count in enumerate(counts):
+        seen += count
+        if seen >= fraction * total:
+            return limits[i] if i < len(limits) else float("inf")
+    return float("inf")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host", help="controller IP address")
+    parser.add_argument("name", help="show name, [A-Za-z0-9_-]")
+    parser.add_argument("file", nargs="?", help="JSON cue list")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--chunk", type=int, default=40, help="cues per request")
+    parser.add_argument("--demo", type=int, metavar="STEPS", help="generate a chase of this many steps")
+    parser.add_argument("--channels", type=int, default=8)
+    parser.add_argument("--step", type=int, default=50, help="demo ms between steps")
+    parser.add_argument("--fade", type=int, default=100, help="demo fade ms")
+    parser.add_argument("--play", action="store_true")
+    parser.add_argument("--loop", action="store_true")
+    parser.add_argument("--measure", type=float, metavar="SECONDS", help="play and report keyframe lateness")
+    args = parser.parse_args()
+
+    if args.demo:
+        show = demo_cues(args.demo, args.channels, args.step, args.fade)
+    elif args.file:
+        with open(args.file) as f:
+            show = json.load(f)
+        if isinstance(show, list):
+            show = {"cues": show}
+    else:
+        print("give a cue file or --demo", file=sys.stderr)
+        return 1
+
+    def post(path, body):
+        status, reply = request(args.host, args.port, "POST", path, body)
+        if status != 200:
+            print(f"{path} {body.get('action')}: {status} {reply}", file=sys.stderr)
+            sys.exit(1)
+        return reply
+
+    start = time.monotonic()
+    post("/api/shows", {"action": "create", "name": args.name})
+    cues = show["cues"]
+    for i in range(0, len(cues), args.chunk):
+        post("/api/shows", {"action": "append", "cues": cues[i:i + args.chunk]})
+    finish = {"action": "finish"}
+    if "duration" in show:
+        finish["duration"] = show["duration"]
+    stored = post("/api/shows", finish)
+    print(f"{len(cues)} cues stored as {stored['keyframes']} keyframes, {stored['durationMs']} ms long, "
+          f"in {time.monotonic() - start:.1f} s")
+
+    if not (args.play or args.measure):
+        return 0
+    _, before = request(args.host, args.port, "GET", "/api/metrics?format=json")
+    post("/api/playback", {"action": "play", "name": args.name, "loop": args.loop or bool(args.measure)})
+    if not args.measure:
+        return 0
+
+    time.sleep(args.measure)
+    post("/api/playback", {"action": "stop"})
+    _, after = request(args.host, args.port, "GET", "/api/metrics?format=json")
+    late_before, late_after = before["show"]["late"], after["show"]["late"]
+    counts = [b - a for a, b in zip(late_before["buckets"], late_after["buckets"])]
+    applied = late_after["count"] - late_before["count"]
+    if applied == 0:
+        print("no keyframes applied")
+        return 2
+    limits = after["bucketLimitsUs"]
+    print("%d keyframes applied, late by: mean %.0f us, p50 <= %s us, p99 <= %s us, max so far %d us" % (
+        applied, (late_after["sumUs"] - late_before["sumUs"]) / applied, bucket_percentile(limits, counts, 0.5),
+        bucket_percentile(limits, counts, 0.99), late_after["maxUs"]))
+    print(f"block underruns: {after['show']['underruns'] - before['show']['underruns']}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
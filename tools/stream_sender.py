@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Send UDP stream frames to the controller for load tests and show playback.
+
+Streams full frames of channel levels in the "LEDF" format that
+acceptStreamFrame() in LED_IOT.cpp understands, at a fixed frame rate,
+and reports the rate it actually achieved. The default pattern is a
+moving sine wave across all channels, so every frame changes every channel.
+
+Usage:
+  python3 tools/stream_sender.py 192.168.1.50
+  python3 tools/stream_sender.py 192.168.1.50 --channels 512 --fps 44 --seconds 60
+  python3 tools/stream_sender.py 192.168.1.50 --priority 150   lock out the web API
+"""
+
+import argparse
+import math
+import socket
+import struct
+import sys
+import time
+
+MAGIC = b"LEDF"
+VERSION = 1
+DEFAULT_PORT = 5570
+HEADER = struct.Struct(">4sBBHHH")
+
+
+def build_frame(sequence, priority, first, levels):
+    header = HEADER.pack(MAGIC, VERSION, priority, sequence & 0xFFFF, first, len(levels))
+    return header + bytes(levels)
+
+
+def wave(channels, t):
+    return [int(127.5 + 127.5 * math.sin(2 * math.pi * (t + i / channels))) for i in range(channels)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host", help="controller IP address")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--channels", type=int, default=8, help="channels per frame")
+    parser.add_argument("--first", type=int, default=0, help="first channel of the frame")
+    parser.add_argument("--fps", type=float, default=40.0)
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--priority", type=int, default=100, help="0-200, web API is 100")
+    args = parser.parse_args()
+
+    if not 0 <= args.priority <= 200 or args.channels < 1:
+        print("priority must be 0-200 and channels at least 1", file=sys.stderr)
+        return 1
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    period = 1.0 / args.fps
+    start = time.monotonic()
+    deadline = start
+    sequence = 0
+    late = 0
+
+    while True:
+        now = time.monotonic()
+        if now - start >= args.seconds:
+            break
+        frame = build_frame(sequence, args.priority, args.first, wave(args.channels, now - start))
+        sock.sendto(frame, (args.host, args.port))
+        sequence += 1
+
+        deadline += period
+        sleep = deadline - time.monotonic()
+        if sleep > 0:
+            time.sleep(sleep)
+        else:
+            late += 1
+
+    elapsed = time.monotonic() - start
+    print(f"sent {sequence} frames of {args.channels} channels in {elapsed:.1f} s "
+          f"({sequence / elapsed:.1f} fps, {late} late)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())